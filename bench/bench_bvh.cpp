@@ -0,0 +1,70 @@
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <bvh.h>
+
+TEST_CASE("Bvh ray queries", "[benchmark][bvh]") {
+    auto mesh = load_obj(GLSB_RES_DIR "/room.obj");
+
+    BENCHMARK("Bvh build room.obj") {
+        return Bvh(mesh.view()).nodes().size();
+    };
+
+    auto bvh = Bvh(mesh.view());
+    // coherent primary rays from a camera in the middle of the room
+    auto bounds = bvh.bounds();
+    auto cam = Camera{bounds.center(), bounds.center() + glm::vec3(1.f, .3f, 0.f), std::make_pair(.1f, 1000.f), 60.f, 1.f};
+    constexpr auto resolution = 256;
+    auto rays = std::vector<Ray>{};
+    rays.reserve(resolution*resolution);
+    // in blocks of 2x2 pixels, so that each packet covers one block
+    for (int y=0; y<resolution; y+=2) {
+        for (int x=0; x<resolution; x+=2) {
+            for (int k=0; k<4; ++k) {
+                auto pixel = glm::vec2(x + k%2, y + k/2) + .5f;
+                rays.push_back(camera_ray(cam, pixel/static_cast<float>(resolution)*2.f - 1.f));
+            }
+        }
+    }
+
+    auto report = [&](const char* name, auto&& trace) {
+        auto start = std::chrono::steady_clock::now();
+        auto hits = trace();
+        auto secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        fmt::print("{}: {:.2f} Mrays/s, {} of {} rays hit\n", name, static_cast<double>(rays.size())/secs*1e-6, hits, rays.size());
+        return hits;
+    };
+
+    auto trace_single = [&] {
+        auto hits = size_t{0};
+        for (const auto& ray : rays) {
+            hits += bvh.intersect(ray) ? 1 : 0;
+        }
+        return hits;
+    };
+    auto trace_packets = [&] {
+        auto hits = size_t{0};
+        for (size_t i=0; i<rays.size(); i+=ray_packet_size) {
+            for (const auto& hit : bvh.intersect(std::span<const Ray, ray_packet_size>(rays.data() + i, ray_packet_size))) {
+                hits += hit ? 1 : 0;
+            }
+        }
+        return hits;
+    };
+
+    report("Bvh::intersect single", trace_single);
+    report("Bvh::intersect packet", trace_packets);
+
+    BENCHMARK("Bvh::intersect single") {
+        return trace_single();
+    };
+
+    BENCHMARK("Bvh::intersect packet") {
+        return trace_packets();
+    };
+}
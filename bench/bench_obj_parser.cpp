@@ -0,0 +1,96 @@
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <mesh.h>
+#include <obj_parser.h>
+#include <thread_pool.h>
+
+namespace {
+
+// grid of `size`x`size` quads, roughly 120 bytes of OBJ text per quad
+std::string generate_grid_obj(int size) {
+    auto out = std::string{};
+    out.reserve(static_cast<size_t>(size)*static_cast<size_t>(size)*120);
+    out += "o grid\n";
+    for (int y=0; y<=size; ++y) {
+        for (int x=0; x<=size; ++x) {
+            out += fmt::format("v {:.6f} {:.6f} {:.6f}\n", x*.01, y*.01, (x*y % 17)*.001);
+            out += fmt::format("vt {:.6f} {:.6f}\n", x/double(size), y/double(size));
+        }
+    }
+    out += "vn 0.000000 0.000000 1.000000\n";
+    for (int y=0; y<size; ++y) {
+        for (int x=0; x<size; ++x) {
+            auto i0 = y*(size+1) + x + 1;
+            auto i1 = i0 + 1;
+            auto i2 = i1 + size + 1;
+            auto i3 = i0 + size + 1;
+            out += fmt::format("f {0}/{0}/1 {1}/{1}/1 {2}/{2}/1 {3}/{3}/1\n", i0, i1, i2, i3);
+        }
+    }
+    return out;
+}
+
+}
+
+TEST_CASE("OBJ parser thread scaling", "[benchmark][obj_parser]") {
+    static const auto text = generate_grid_obj(700);
+    WARN(fmt::format("parsing {:.1f} MiB of OBJ text", static_cast<double>(text.size())/(1024.*1024.)));
+
+    BENCHMARK("tinyobjloader") {
+        auto attrib = tinyobj::attrib_t{};
+        auto shapes = std::vector<tinyobj::shape_t>{};
+        auto materials = std::vector<tinyobj::material_t>{};
+        auto err = std::string{};
+        auto iss = std::istringstream(text);
+        tinyobj::LoadObj(&attrib, &shapes, &materials, &err, &iss);
+        return shapes.size();
+    };
+
+    BENCHMARK("parse_obj, calling thread only") {
+        auto attrib = tinyobj::attrib_t{};
+        auto shapes = std::vector<tinyobj::shape_t>{};
+        parse_obj(text, attrib, shapes);
+        return shapes.size();
+    };
+
+    auto max_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    auto thread_counts = std::vector<unsigned>{};
+    for (auto threads=1u; threads<max_threads; threads*=2) {
+        thread_counts.push_back(threads);
+    }
+    thread_counts.push_back(max_threads);
+
+    for (auto threads : thread_counts) {
+        auto pool = ThreadPool(threads);
+        BENCHMARK(fmt::format("parse_obj, {} threads", threads)) {
+            auto attrib = tinyobj::attrib_t{};
+            auto shapes = std::vector<tinyobj::shape_t>{};
+            parse_obj(text, attrib, shapes, &pool);
+            return shapes.size();
+        };
+    }
+}
+
+TEST_CASE("Loading room.obj", "[benchmark][obj_parser]") {
+    // the cache would turn every iteration after the first into a cache hit
+    BENCHMARK("load_obj room.obj") {
+        auto opts = ObjLoadOptions{};
+        opts.use_cache = false;
+        return load_obj(GLSB_RES_DIR "/room.obj", opts).index_data.size();
+    };
+
+    BENCHMARK("load_obj room.obj, tinyobjloader") {
+        auto opts = ObjLoadOptions{};
+        opts.use_cache = false;
+        opts.use_tinyobjloader = true;
+        return load_obj(GLSB_RES_DIR "/room.obj", opts).index_data.size();
+    };
+}
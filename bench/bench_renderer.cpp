@@ -0,0 +1,117 @@
+#include <catch2/catch.hpp>
+
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include <framebuffer.h>
+#include <gl_state.h>
+#include <headless_surface.h>
+#include <mesh.h>
+#include <renderer.h>
+#include <scene.h>
+#include <shader.h>
+// only here, it holds the stb_image implementation
+#include <texture.h>
+#include <uniform_blocks.h>
+#include <utils.h>
+
+namespace {
+
+// OpenGL 4.3 core context without a window, throws without a driver
+struct HeadlessContext {
+    HeadlessSurface surface;
+
+    HeadlessContext(int width, int height) : surface{width, height} {
+        if (glewInit() != GLEW_OK) {
+            throw GLSBError("error initializing GLEW");
+        }
+        // names of an earlier context
+        gl_state().invalidate();
+    }
+};
+
+}
+
+TEST_CASE("Bitmap decoding", "[benchmark][texture]") {
+    BENCHMARK("Bitmap room.png") {
+        return Bitmap(GLSB_RES_DIR "/room.png").size();
+    };
+
+    BENCHMARK("Bitmap opengl.png") {
+        return Bitmap(GLSB_RES_DIR "/opengl.png").size();
+    };
+}
+
+TEST_CASE("Renderer", "[benchmark][renderer]") {
+    constexpr auto width = 1280;
+    constexpr auto height = 720;
+    // fails rather than skips, so missing results show up in bench_json
+    auto context = std::optional<HeadlessContext>{};
+    try {
+        context.emplace(width, height);
+    }
+    catch (const GLSBError& ex) {
+        FAIL("no headless OpenGL 4.3 context: " << ex.what());
+    }
+
+    auto mesh = load_obj(GLSB_RES_DIR "/room.obj", ObjLoadOptions{.use_cache = false});
+    auto renderer = Renderer(context->surface);
+    renderer.init();
+    auto vert_src = load_file(GLSB_RES_DIR "/vert.glsl");
+    auto frag_src = load_file(GLSB_RES_DIR "/frag.glsl");
+    auto shaders = std::vector<Shader>{};
+    shaders.emplace_back(Shader::Type::Vertex, vert_src.data());
+    shaders.emplace_back(Shader::Type::Fragment, frag_src.data());
+    auto prog_hndl = renderer.shader_manager().add_shader("default", shaders);
+
+    BENCHMARK_ADVANCED("Renderer::upload_mesh room.obj")(Catch::Benchmark::Chronometer meter) {
+        auto hndls = std::vector<Renderer::handle_type>(static_cast<size_t>(meter.runs()));
+        meter.measure([&](int i) {
+            hndls[static_cast<size_t>(i)] = renderer.upload_mesh(mesh, "default");
+            glFinish();
+        });
+        for (auto hndl : hndls) {
+            renderer.release_mesh(hndl);
+        }
+    };
+
+    auto scene = Scene{};
+    scene.cam = Camera{
+        {2.f, 2.f, 2.f},
+        {0.f, 0.f, 0.f},
+        std::make_pair(0.1f, 10.f),
+        40.f,
+        static_cast<float>(width)/static_cast<float>(height)
+    };
+    scene.diffuse = {{3.f, 3.f, 3.f}, {1.f, 1.f, 1.f}, 1.f};
+    scene.ambient = {{.8f, .8f, 1.f}, .5f};
+
+    // `Renderer` sets the viewport to the surface's size, there is no
+    // default framebuffer to draw to
+    auto framebuffer = Framebuffer(width, height);
+    framebuffer.bind();
+    auto mesh_hndl = renderer.upload_mesh(mesh, "default");
+    auto& prog = renderer.shader_manager().get(prog_hndl);
+    constexpr auto frames = 100;
+
+    BENCHMARK("draw room.obj offscreen, 100 frames") {
+        for (int i=0; i<frames; ++i) {
+            renderer.begin_frame();
+            renderer.clear_screen();
+            renderer.set_uniform_block(FrameUniforms::from_camera(scene.cam));
+            renderer.set_uniform_block(LightUniforms::from_scene(scene));
+            renderer.set_uniform_block(MaterialUniforms{.5f, 1.f, {}});
+            prog.use();
+            renderer.render(mesh_hndl, scene.cam);
+            renderer.end_frame();
+        }
+        glFinish();
+        return frames;
+    };
+
+    renderer.release_mesh(mesh_hndl);
+    framebuffer.unbind();
+}
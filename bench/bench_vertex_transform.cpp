@@ -0,0 +1,44 @@
+#include <catch2/catch.hpp>
+
+#include <random>
+#include <vector>
+
+#include <mesh.h>
+
+TEST_CASE("Vertex transform", "[benchmark][mesh]") {
+    auto rng = std::mt19937(42);
+    auto dist = std::uniform_real_distribution<float>(-1.f, 1.f);
+    auto vertices = std::vector<Vertex>(1 << 20);
+    for (auto& vert : vertices) {
+        vert.pos = glm::vec3(dist(rng), dist(rng), dist(rng));
+        vert.norm = glm::normalize(glm::vec3(dist(rng), dist(rng), dist(rng)));
+        vert.uv = glm::vec2(dist(rng), dist(rng));
+    }
+    auto tmat = glm::translate(glm::scale(glm::mat4(1.f), glm::vec3(1.01f)), glm::vec3(.01f, 0.f, -.01f));
+
+    BENCHMARK("Vertex::transform per vertex") {
+        for (auto& vert : vertices) {
+            vert.transform(tmat);
+        }
+        return vertices[0].pos.x;
+    };
+
+    BENCHMARK("transform_vertices_scalar") {
+        transform_vertices_scalar(vertices, tmat);
+        return vertices[0].pos.x;
+    };
+
+    BENCHMARK("transform_vertices") {
+        transform_vertices(vertices, tmat);
+        return vertices[0].pos.x;
+    };
+}
+
+TEST_CASE("Mesh transform", "[benchmark][mesh]") {
+    auto mesh = load_obj(GLSB_RES_DIR "/room.obj");
+    auto tmat = glm::rotate(glm::mat4(1.f), .01f, glm::vec3(0.f, 1.f, 0.f));
+
+    BENCHMARK("Mesh::transform room.obj") {
+        return mesh.transform(tmat).vertex_data[0].pos.x;
+    };
+}
@@ -0,0 +1,105 @@
+#include <catch2/catch.hpp>
+
+#include <set>
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+
+namespace {
+
+std::string
+escape_json(const std::string& str) {
+    auto ret = std::string{};
+    ret.reserve(str.size());
+    for (auto c : str) {
+        if (c == '"' || c == '\\') {
+            ret += '\\';
+            ret += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            ret += fmt::format("\\u{:04x}", static_cast<int>(c));
+        } else {
+            ret += c;
+        }
+    }
+    return ret;
+}
+
+// `glsb_bench -r json -o results.json` writes the results of all benchmarks
+// as JSON, times in nanoseconds, to be compared across releases. Failed
+// assertions are listed too, so benchmarks that didn't run are visible.
+class JsonReporter final : public Catch::StreamingReporterBase<JsonReporter> {
+    public:
+        using StreamingReporterBase::StreamingReporterBase;
+
+        static std::string getDescription() {
+            return "Reports benchmark results as JSON";
+        }
+
+        static std::set<Catch::Verbosity> getSupportedVerbosities() {
+            return {Catch::Verbosity::Quiet, Catch::Verbosity::Normal, Catch::Verbosity::High};
+        }
+
+        void assertionStarting(const Catch::AssertionInfo&) override {}
+
+        bool assertionEnded(const Catch::AssertionStats& stats) override {
+            const auto& result = stats.assertionResult;
+            if (!result.isOk()) {
+                failures_.push_back(Failure{currentTestCaseInfo->name, result.getMessage()});
+            }
+            return true;
+        }
+
+        void benchmarkEnded(const Catch::BenchmarkStats<>& stats) override {
+            results_.push_back(Result{currentTestCaseInfo->name, stats});
+        }
+
+        void testRunEnded(const Catch::TestRunStats& stats) override {
+            stream << "{\n";
+            stream << fmt::format("  \"run\": \"{}\",\n", escape_json(stats.runInfo.name));
+            stream << fmt::format("  \"failed_assertions\": {},\n", stats.totals.assertions.failed);
+            stream << "  \"failures\": [";
+            for (size_t i=0; i<failures_.size(); ++i) {
+                stream << (i == 0 ? "\n" : ",\n");
+                stream << fmt::format("    {{\"test_case\": \"{}\", \"message\": \"{}\"}}",
+                    escape_json(failures_[i].test_case), escape_json(failures_[i].message));
+            }
+            stream << (failures_.empty() ? "],\n" : "\n  ],\n");
+            stream << "  \"benchmarks\": [";
+            for (size_t i=0; i<results_.size(); ++i) {
+                const auto& [test_case, bench] = results_[i];
+                stream << (i == 0 ? "\n" : ",\n");
+                stream << "    {";
+                stream << fmt::format("\"test_case\": \"{}\", ", escape_json(test_case));
+                stream << fmt::format("\"name\": \"{}\", ", escape_json(bench.info.name));
+                stream << fmt::format("\"samples\": {}, ", bench.samples.size());
+                stream << fmt::format("\"iterations\": {}, ", bench.info.iterations);
+                stream << fmt::format("\"mean_ns\": {:.3f}, ", bench.mean.point.count());
+                stream << fmt::format("\"mean_lower_ns\": {:.3f}, ", bench.mean.lower_bound.count());
+                stream << fmt::format("\"mean_upper_ns\": {:.3f}, ", bench.mean.upper_bound.count());
+                stream << fmt::format("\"std_dev_ns\": {:.3f}, ", bench.standardDeviation.point.count());
+                stream << fmt::format("\"outliers\": {}, ", bench.outliers.total());
+                stream << fmt::format("\"outlier_variance\": {:.3f}", bench.outlierVariance);
+                stream << "}";
+            }
+            stream << "\n  ]\n}\n";
+            StreamingReporterBase::testRunEnded(stats);
+        }
+    private:
+        struct Result {
+            std::string test_case;
+            Catch::BenchmarkStats<> bench;
+        };
+
+        struct Failure {
+            std::string test_case;
+            std::string message;
+        };
+
+        std::vector<Result> results_;
+        std::vector<Failure> failures_;
+};
+
+}
+
+CATCH_REGISTER_REPORTER("json", JsonReporter)
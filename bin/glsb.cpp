@@ -1,5 +1,14 @@
 #include <iostream>
+#include <charconv>
+#include <chrono>
+#include <cstring>
 #include <filesystem>
+#include <future>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
 
 #include <GL/glew.h>
 #include <GLFW/glfw3.h>
@@ -9,12 +18,20 @@
 #include <imgui.h>
 
 #include <application.h>
+#include <benchmark_layer.h>
+#include <clustered_lighting.h>
+#include <deferred_shading.h>
 #include <layer.h>
+#include <lod.h>
 #include <texture.h>
 #include <scene.h>
 #include <shader.h>
+#include <uniform_blocks.h>
 #include <buffer.h>
+#include <gl_state.h>
+#include <headless_surface.h>
 #include <renderer.h>
+#include <surface.h>
 #include <utils.h>
 
 static float g_max_anisotropy = -1.;
@@ -49,11 +66,9 @@ static void gl_error_cb(
 }
 #endif // NDEBUG
 
-auto tex2d = TextureBindingPoint(TextureTarget::Texture2D);
-
 class SandboxLayer final : public Layer {
     public:
-        SandboxLayer(Application& app) : Layer{app}, tex_{tex2d} {
+        SandboxLayer(Application& app) : Layer{app}, tex_{} {
             scene_.cam = Camera{
                 {2.f, 2.f, 2.f},
                 {0.f, 0.f, 0.f},
@@ -72,34 +87,130 @@ class SandboxLayer final : public Layer {
             };
         }
 
+        const char* name() const noexcept override {
+            return "Sandbox";
+        }
+
         void init() override {
             app_.input_manager().register_mouse_scroll_handler([this](double /*x_offs*/, double y_offs){
                 this->scene_.cam.fov += static_cast<float>(y_offs)*5;
             });
 
-            auto materials = std::unordered_map<const char*, std::pair<std::filesystem::path, std::filesystem::path>>{
-                {"default", std::make_pair("res/vert.glsl", "res/frag.glsl")},
+            struct Material {
+                const char* name;
+                std::pair<std::filesystem::path, std::filesystem::path> files;
+                // where to keep the handle, if drawn with every frame
+                std::optional<ShaderManager::handle_type>* hndl = nullptr;
+            };
+            auto materials = std::vector<Material>{
+                {"default", std::make_pair("res/vert.glsl", "res/frag.glsl"), &default_prog_},
                 {"flat", std::make_pair("res/flat.vert.glsl", "res/flat.frag.glsl")},
+                {"packed", std::make_pair("res/packed.vert.glsl", "res/frag.glsl")},
+                {"static", std::make_pair("res/static.vert.glsl", "res/frag.glsl"), &static_prog_},
+                {"instanced", std::make_pair("res/instanced.vert.glsl", "res/frag.glsl"), &instanced_prog_},
+                // same vertex shaders, so the meshes uploaded for the ones above fit
+                {"gbuffer", std::make_pair("res/vert.glsl", "res/gbuffer.frag.glsl"), &gbuffer_prog_},
+                {"gbuffer_static", std::make_pair("res/static.vert.glsl", "res/gbuffer.frag.glsl"), &gbuffer_static_prog_},
+                {"gbuffer_instanced", std::make_pair("res/instanced.vert.glsl", "res/gbuffer.frag.glsl"), &gbuffer_instanced_prog_},
+                {DeferredShading::ambient_program, std::make_pair("res/deferred.vert.glsl", "res/deferred_ambient.frag.glsl")},
+                {DeferredShading::point_program, std::make_pair("res/deferred_point.vert.glsl", "res/deferred_point.frag.glsl")},
+                {"clustered", std::make_pair("res/vert.glsl", "res/clustered.frag.glsl"), &clustered_prog_},
+                {"clustered_static", std::make_pair("res/static.vert.glsl", "res/clustered.frag.glsl"), &clustered_static_prog_},
+                {"clustered_instanced", std::make_pair("res/instanced.vert.glsl", "res/clustered.frag.glsl"), &clustered_instanced_prog_},
             };
 
-            for (const auto& [name, files] : materials) {
-                auto vert_src = load_file(files.first);
-                auto frag_src = load_file(files.second);
-
-                auto shaders = std::vector<Shader>{};
-                shaders.emplace_back(Shader::Type::Vertex, vert_src.data());
-                shaders.emplace_back(Shader::Type::Fragment, frag_src.data());
-
-                app_.renderer().shader_manager().add_shader(name, shaders);
+            auto& loader = app_.asset_loader();
+
+            // file I/O, parsing and decoding run on the loader's workers,
+            // only the GL uploads run on this thread
+            auto programs = std::vector<std::shared_future<void>>{};
+            for (const auto& mat : materials) {
+                programs.push_back(loader.load(
+                    [files = mat.files]() {
+                        return std::make_pair(load_file(files.first), load_file(files.second));
+                    },
+                    [this, name = mat.name, hndl = mat.hndl](std::pair<std::vector<char>, std::vector<char>>&& srcs) {
+                        auto shaders = std::vector<Shader>{};
+                        shaders.emplace_back(Shader::Type::Vertex, srcs.first.data());
+                        shaders.emplace_back(Shader::Type::Fragment, srcs.second.data());
+
+                        auto prog = app_.renderer().shader_manager().add_shader(name, shaders);
+                        if (hndl != nullptr) {
+                            *hndl = prog;
+                        }
+                    }
+                ).share());
             }
+            pending_.push_back(loader.load(
+                []() {
+                    return load_file("res/cluster_lights.comp.glsl");
+                },
+                [this](std::vector<char>&& src) {
+                    auto shaders = std::vector<Shader>{};
+                    shaders.emplace_back(Shader::Type::Compute, src.data());
+                    app_.renderer().shader_manager().add_shader(ClusteredLighting::assign_program, shaders);
+                }
+            ).share());
+            pending_.insert(pending_.end(), programs.begin(), programs.end());
 
-            mesh_hndls_.emplace_back(app_.renderer().upload_mesh(
-                load_obj("res/cube.obj").transform(glm::translate(glm::mat4(1.f), glm::vec3(0.f, 0.f, 1.f))),
-                "default"
-            ));
-            mesh_hndls_.emplace_back(app_.renderer().upload_mesh(generate_quad(5.f, 5.f), "default"));
-
-            auto img = Bitmap("res/cube.png");
+            // vertex attributes are looked up in the program, so meshes are
+            // only uploaded after it has been linked
+            auto upload_mesh = [this](auto&& mesh) {
+                mesh_hndls_.emplace_back(app_.renderer().upload_mesh_shared(mesh, "default"));
+            };
+            pending_.push_back(loader.load_after(
+                programs,
+                [settings = lod_settings_]() {
+                    return generate_lods(
+                        load_obj("res/cube.obj").transform(glm::translate(glm::mat4(1.f), glm::vec3(0.f, 0.f, 1.f))),
+                        settings
+                    );
+                },
+                upload_mesh
+            ).share());
+            pending_.push_back(loader.load_after(
+                programs,
+                []() {
+                    return generate_quad(5.f, 5.f);
+                },
+                upload_mesh
+            ).share());
+
+            // one cube, drawn `instance_count_` times around the big one
+            pending_.push_back(loader.load_after(
+                programs,
+                []() {
+                    return load_obj("res/cube.obj");
+                },
+                [this](Mesh<Vertex>&& mesh) {
+                    instanced_hndl_ = app_.renderer().upload_mesh(mesh, "instanced");
+                }
+            ).share());
+            update_instances();
+
+            // small cubes around the floor quad, all drawn with one indirect call
+            pending_.push_back(loader.load_after(
+                programs,
+                []() {
+                    auto batch = StaticBatch<Vertex>{};
+                    auto cube = load_obj("res/cube.obj");
+                    auto cube_id = batch.add_mesh(cube.view());
+                    for (int y=-16; y<16; ++y) {
+                        for (int x=-16; x<16; ++x) {
+                            auto pos = glm::vec3(static_cast<float>(x) + .5f, static_cast<float>(y) + .5f, 0.f)*.3f;
+                            if ((std::fabs(pos.x) < 2.6f) && (std::fabs(pos.y) < 2.6f)) {
+                                continue;
+                            }
+                            pos.z = .1f;
+                            batch.add_draw(cube_id, glm::scale(glm::translate(glm::mat4(1.f), pos), glm::vec3(.1f)));
+                        }
+                    }
+                    return batch;
+                },
+                [this](StaticBatch<Vertex>&& batch) {
+                    static_batch_hndl_ = app_.renderer().upload_static_batch(batch, "static");
+                }
+            ).share());
 
             tex_.set_filtering(TextureFilter::Linear, true);
             tex_.set_wrapping(TextureWrapping::ClampToBorder);
@@ -107,11 +218,35 @@ class SandboxLayer final : public Layer {
                 glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAX_ANISOTROPY_EXT, g_max_anisotropy);
             }
 
-            tex_.allocate(img.width(), img.height(), reinterpret_cast<const void*>(img.data()));
+            pending_.push_back(loader.load(
+                []() {
+                    return Bitmap("res/cube.png");
+                },
+                [this](Bitmap&& img) {
+                    tex_.allocate(img.width(), img.height(), reinterpret_cast<const void*>(img.data()));
+                }
+            ).share());
+
+            deferred_.emplace(app_.renderer());
+            clustered_.emplace(app_.renderer());
+            update_point_lights();
         }
 
-        void cleanup() override {}
-        void prepare_frame() override {}
+        void cleanup() override {
+            deferred_.reset();
+            clustered_.reset();
+        }
+
+        void prepare_frame() override {
+            // rethrows errors of finished loads on the render thread
+            std::erase_if(pending_, [](const auto& fut) {
+                if (fut.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                    return false;
+                }
+                fut.get();
+                return true;
+            });
+        }
 
         void on_update() override {
             if (app_.input_manager().key_state(KeyCode::KEY_W) == KeyState::Pressed) {
@@ -132,6 +267,11 @@ class SandboxLayer final : public Layer {
             if (app_.input_manager().key_state(KeyCode::KEY_Z) == KeyState::Pressed) {
                 scene_.cam.pos -= scene_.cam.local_ccs().e_x*0.1f;
             }
+            // the point lights circle the big cube
+            auto rot = glm::rotate(glm::mat4(1.f), .005f, glm::vec3(0.f, 0.f, 1.f));
+            for (auto& light : scene_.point_lights) {
+                light.pos = glm::vec3(rot*glm::vec4(light.pos, 1.f));
+            }
             ImGui::Begin("Contols", nullptr, ImGuiWindowFlags_::ImGuiWindowFlags_AlwaysAutoResize);
                 if (ImGui::CollapsingHeader("Camera", ImGuiTreeNodeFlags_DefaultOpen)) {
                     ImGui::DragFloat3("Position", &scene_.cam.pos[0], .1f, -3.f, 3.f, "%.1f", 1.f);
@@ -150,70 +290,264 @@ class SandboxLayer final : public Layer {
                     ImGui::DragFloat("Specular Roughness", &roughness_, 1.f, 1.0f, 1000.0f, "%.0f");
                     ImGui::DragFloat("Specular Intensity", &spec_intensity_, .1f, 0.0f, 10.0f, "%.1f");
                 }
+                if (ImGui::CollapsingHeader("Point Lights")) {
+                    // in the order of `Shading`
+                    ImGui::Combo("Shading", &shading_, "Forward (no point lights)\0Deferred\0Clustered forward\0");
+                    if (ImGui::DragInt("Point Lights", &point_light_count_, 1.f, 0, 4096)) {
+                        update_point_lights();
+                    }
+                }
+                if (ImGui::CollapsingHeader("Level of Detail")) {
+                    auto lod_error = app_.renderer().lod_screen_error();
+                    if (ImGui::DragFloat("Max Screen Error [px]", &lod_error, .1f, 0.0f, 50.0f, "%.1f")) {
+                        app_.renderer().set_lod_screen_error(lod_error);
+                    }
+                }
+                if (ImGui::CollapsingHeader("Instancing")) {
+                    if (ImGui::DragInt("Instances", &instance_count_, 10.f, 0, 100000)) {
+                        update_instances();
+                    }
+                }
+                if (ImGui::CollapsingHeader("Draw Statistics")) {
+                    const auto& stats = app_.renderer().cull_stats();
+                    ImGui::Text("Drawn: %zu", stats.drawn);
+                    ImGui::Text("Culled: %zu", stats.culled);
+                    const auto& changes = app_.renderer().state_changes();
+                    ImGui::Text("Program changes: %zu", changes.programs);
+                    ImGui::Text("Texture changes: %zu", changes.textures);
+                    ImGui::Text("Vertex array changes: %zu", changes.vertex_arrays);
+                    // of the whole last frame, including ImGui's own draws
+                    const auto& gl = gl_state().frame_stats();
+                    ImGui::Separator();
+                    ImGui::Text("GL state calls (issued/avoided)");
+                    ImGui::Text("Programs: %zu/%zu", gl.programs.issued, gl.programs.avoided);
+                    ImGui::Text("Vertex arrays: %zu/%zu", gl.vertex_arrays.issued, gl.vertex_arrays.avoided);
+                    ImGui::Text("Buffers: %zu/%zu", gl.buffers.issued, gl.buffers.avoided);
+                    ImGui::Text("Textures: %zu/%zu", gl.textures.issued, gl.textures.avoided);
+                    ImGui::Text("Raster state: %zu/%zu", gl.raster.issued, gl.raster.avoided);
+                    ImGui::Text("Total: %zu/%zu", gl.total().issued, gl.total().avoided);
+                }
             ImGui::End();
+
+            app_.renderer().profiler().draw_window();
         }
 
         void on_draw() override {
             auto fb_size = app_.renderer().get_viewport_dim();
             scene_.cam.aspect = static_cast<float>(fb_size.width)/static_cast<float>(fb_size.height);
 
-            auto& prog = app_.renderer().shader_manager().get_shader("default");
-            prog.use();
-            prog.set_uniform("u_view", scene_.cam.get_view_matrix());
-            prog.set_uniform("u_proj", scene_.cam.get_proj_matrix());
-            prog.set_uniform("ambient.color", scene_.ambient.color);
-            prog.set_uniform("ambient.intensity", scene_.ambient.intensity);
-            prog.set_uniform("diffuse.pos", scene_.diffuse.pos);
-            prog.set_uniform("diffuse.color", scene_.diffuse.color);
-            prog.set_uniform("diffuse.intensity", scene_.diffuse.intensity);
-            prog.set_uniform("spec.roughness", roughness_);
-            prog.set_uniform("spec.intensity", spec_intensity_);
-            prog.set_uniform("camera.pos", scene_.cam.pos);
-            tex_.bind();
+            if (!default_prog_) {
+                // still loading
+                return;
+            }
+            auto& renderer = app_.renderer();
+            // read by all programs for the rest of the frame
+            renderer.set_uniform_block(FrameUniforms::from_camera(scene_.cam));
+            renderer.set_uniform_block(LightUniforms::from_scene(scene_));
+            renderer.set_uniform_block(MaterialUniforms{roughness_, spec_intensity_, {}});
+            // Deferred: the geometry is drawn into the G-buffer by the
+            // gbuffer* variants of the programs, and lit afterwards.
+            // Clustered: the lights are binned first, the clustered* variants
+            // light with the lights of their cluster.
+            auto mesh_prog = default_prog_;
+            auto instanced_prog = instanced_prog_;
+            auto static_prog = static_prog_;
+            auto deferred = (shading_ == Shading::Deferred) && gbuffer_prog_ && gbuffer_static_prog_ && gbuffer_instanced_prog_;
+            if (deferred) {
+                mesh_prog = gbuffer_prog_;
+                instanced_prog = gbuffer_instanced_prog_;
+                static_prog = gbuffer_static_prog_;
+                deferred_->begin_geometry();
+            }
+            if ((shading_ == Shading::Clustered) && clustered_prog_ && clustered_static_prog_ && clustered_instanced_prog_) {
+                auto zone = renderer.profiler().zone("Light clusters");
+                if (clustered_->assign_lights(scene_)) {
+                    mesh_prog = clustered_prog_;
+                    instanced_prog = clustered_instanced_prog_;
+                    static_prog = clustered_static_prog_;
+                }
+            }
+            auto& prog = renderer.shader_manager().get(*mesh_prog);
 
             for (auto mesh : mesh_hndls_) {
-                app_.renderer().render(mesh);
+                renderer.submit(DrawItem{mesh, &prog, &tex_, false, renderer.view_depth(mesh, scene_.cam)});
+            }
+            {
+                auto zone = renderer.profiler().zone("Queue");
+                renderer.flush(scene_.cam);
+            }
+
+            if (instanced_hndl_ && instanced_prog) {
+                auto zone = renderer.profiler().zone("Instanced");
+                renderer.shader_manager().get(*instanced_prog).use();
+                tex_.bind();
+                renderer.render_instanced(*instanced_hndl_, instance_models_);
+            }
+
+            if (static_batch_hndl_ && static_prog) {
+                auto zone = renderer.profiler().zone("Static batch");
+                renderer.shader_manager().get(*static_prog).use();
+                tex_.bind();
+                renderer.render_static(*static_batch_hndl_, scene_.cam);
             }
             tex_.unbind();
+
+            if (deferred) {
+                auto zone = renderer.profiler().zone("Deferred lighting");
+                deferred_->light(scene_);
+            }
         }
 
     private:
+        // small cubes evenly spread over a sphere around the big cube
+        void update_instances() {
+            constexpr auto golden_angle = 2.39996323f;
+            auto count = static_cast<size_t>(std::max(instance_count_, 0));
+            auto scale = .08f*std::sqrt(64.f/std::max(static_cast<float>(count), 64.f));
+            instance_models_.resize(count);
+            for (size_t i=0; i<count; ++i) {
+                auto z = 1.f - 2.f*(static_cast<float>(i) + .5f)/static_cast<float>(count);
+                auto r = std::sqrt(1.f - z*z);
+                auto phi = golden_angle*static_cast<float>(i);
+                auto pos = glm::vec3(0.f, 0.f, 1.f) + 1.8f*glm::vec3(r*std::cos(phi), r*std::sin(phi), z);
+                instance_models_[i] = glm::scale(glm::translate(glm::mat4(1.f), pos), glm::vec3(scale));
+            }
+        }
+
+        // random colors, scattered over the floor quad
+        void update_point_lights() {
+            auto rng = std::mt19937{42};
+            auto pos = std::uniform_real_distribution<float>(-2.5f, 2.5f);
+            auto height = std::uniform_real_distribution<float>(.05f, .6f);
+            auto hue = std::uniform_real_distribution<float>(0.f, 1.f);
+            auto count = static_cast<size_t>(std::max(point_light_count_, 0));
+            scene_.point_lights.resize(count);
+            for (auto& light : scene_.point_lights) {
+                auto color = glm::vec3(hue(rng), hue(rng), hue(rng));
+                light = PointLight{
+                    {pos(rng), pos(rng), height(rng)},
+                    .6f,
+                    color/std::max(color.r, std::max(color.g, color.b)),
+                    1.f
+                };
+            }
+        }
+
         Scene scene_;
         float roughness_ = 1.f;
         float spec_intensity_ = 1.f;
+        LodSettings lod_settings_;
 
         Texture tex_;
 
+        // set once loaded
+        std::optional<ShaderManager::handle_type> default_prog_;
+        std::optional<ShaderManager::handle_type> static_prog_;
+        std::optional<ShaderManager::handle_type> instanced_prog_;
+        std::optional<ShaderManager::handle_type> gbuffer_prog_;
+        std::optional<ShaderManager::handle_type> gbuffer_static_prog_;
+        std::optional<ShaderManager::handle_type> gbuffer_instanced_prog_;
+
+        std::optional<ShaderManager::handle_type> clustered_prog_;
+        std::optional<ShaderManager::handle_type> clustered_static_prog_;
+        std::optional<ShaderManager::handle_type> clustered_instanced_prog_;
+
+        // how the point lights are drawn, an int for ImGui::Combo
+        enum Shading : int {
+            Forward,
+            Deferred,
+            Clustered,
+        };
+        std::optional<DeferredShading> deferred_;
+        std::optional<ClusteredLighting> clustered_;
+        int shading_ = Shading::Forward;
+        int point_light_count_ = 256;
+
         std::vector<Renderer::handle_type> mesh_hndls_;
+        std::optional<Renderer::handle_type> static_batch_hndl_;
+        std::optional<Renderer::handle_type> instanced_hndl_;
+        int instance_count_ = 64;
+        std::vector<glm::mat4> instance_models_;
+        std::vector<std::shared_future<void>> pending_;
 };
 
-int main() {
-    if (!glfwInit()) {
-        spdlog::critical("Error initializing GLFW");
-        return 1;
+int main(int argc, char** argv) {
+    // --trace <file>: write the CPU trace to <file> on F12 and on exit
+    // --headless <frames>: render <frames> frames offscreen and log their
+    //     timing, without a window or display server, e.g. on llvmpipe with
+    //     `env LIBGL_ALWAYS_SOFTWARE=1 glsb --headless 500`
+    auto trace_path = std::optional<std::string>{};
+    auto headless_frames = std::optional<size_t>{};
+    for (int i=1; i<argc; ++i) {
+        if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (std::strcmp(argv[i], "--headless") == 0 && i + 1 < argc) {
+            auto arg = std::string_view(argv[++i]);
+            auto frames = size_t{0};
+            auto [end, ec] = std::from_chars(arg.data(), arg.data() + arg.size(), frames);
+            if (ec != std::errc{} || end != arg.data() + arg.size() || frames == 0) {
+                spdlog::critical("--headless needs a frame count > 0, got \"{}\"", argv[i]);
+                return 1;
+            }
+            headless_frames = frames;
+        } else {
+            spdlog::warn("ignoring unknown argument \"{}\"", argv[i]);
+        }
     }
 
-    glfwSetErrorCallback(glfw_error_cb);
+    // the window, or the context without one; outlives the application
+    auto surface = std::unique_ptr<Surface>{};
+    GLFWwindow* win = nullptr;
+    auto destroy_surface = [&]() {
+        surface.reset();
+        if (!headless_frames) {
+            if (win) {
+                glfwDestroyWindow(win);
+            }
+            glfwTerminate();
+        }
+    };
+
+    if (headless_frames) {
+        try {
+            surface = std::make_unique<HeadlessSurface>(800, 600);
+        }
+        catch (const GLSBError& ex) {
+            spdlog::critical("Error creating a headless OpenGL context: {}", ex.what());
+            return 1;
+        }
+    } else {
+        if (!glfwInit()) {
+            spdlog::critical("Error initializing GLFW");
+            return 1;
+        }
+
+        glfwSetErrorCallback(glfw_error_cb);
 
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #ifndef NDEBUG
-    glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLFW_TRUE);
+        glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, GLFW_TRUE);
 #endif // NDEBUG
-    auto win = glfwCreateWindow(800, 600, "OpenGL sandbox", nullptr, nullptr);
-    if (!win) {
-        spdlog::error("Error creating window");
-        glfwTerminate();
-        return 1;
+#ifdef GLSB_HAS_EGL
+        // GLEW loads through EGL there, see CMakeLists.txt
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+#endif // GLSB_HAS_EGL
+        win = glfwCreateWindow(800, 600, "OpenGL sandbox", nullptr, nullptr);
+        if (!win) {
+            spdlog::error("Error creating window");
+            destroy_surface();
+            return 1;
+        }
+        glfwMakeContextCurrent(win);
+        surface = std::make_unique<WindowSurface>(win);
     }
-    glfwMakeContextCurrent(win);
 
     if (auto res = glewInit(); res != GLEW_OK) {
         spdlog::critical("Error initalizing GLEW: {}", glewGetErrorString(res));
-        glfwDestroyWindow(win);
-        glfwTerminate();
+        destroy_surface();
         return 1;
     }
 
@@ -231,21 +565,24 @@ int main() {
 #endif // NDEBUG
 
     try {
-        auto app = Application(win);
+        auto app = Application(*surface);
+        if (trace_path) {
+            app.set_trace_path(*trace_path, true);
+        }
         app.layers().emplace_front(std::make_unique<SandboxLayer>(app));
+        if (headless_frames) {
+            app.layers().emplace_front(std::make_unique<BenchmarkLayer>(app, *headless_frames));
+        }
         app.init();
         app.run();
     }
     catch (const GLSBError& ex) {
         spdlog::error("Error building shaders: {}", ex.what());
-        glfwDestroyWindow(win);
-        glfwTerminate();
+        destroy_surface();
         return 1;
     }
 
-    glfwDestroyWindow(win);
-
-    glfwTerminate();
+    destroy_surface();
 
     return 0;
 }
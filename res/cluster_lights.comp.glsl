@@ -0,0 +1,107 @@
+#version 430 core
+
+// ClusteredLighting: one invocation per cluster of the ClusterGrid, lists
+// the point lights whose sphere touches the cluster's box. The lights are
+// moved to view space a workgroup sized batch at a time, shared by the
+// whole workgroup.
+
+// ClusteredLighting::workgroup_size
+layout(local_size_x = 128) in;
+
+// PointLight
+struct PointLight {
+    vec3 pos;
+    float radius;
+    vec3 color;
+    float intensity;
+};
+
+layout(std430, binding = 1) readonly buffer PointLights {
+    PointLight lights[];
+};
+
+// per cluster, the number of lights
+layout(std430, binding = 2) writeonly buffer ClusterLightCounts {
+    uint cluster_light_counts[];
+};
+
+// per cluster, u_max_cluster_lights light indices
+layout(std430, binding = 3) writeonly buffer ClusterLightIndices {
+    uint cluster_light_indices[];
+};
+
+// FrameUniforms
+layout(std140) uniform Frame {
+    mat4 u_view;
+    mat4 u_proj;
+    vec3 camera_pos;
+};
+
+// ClusterUniforms
+layout(std140) uniform Clusters {
+    uvec4 u_grid_size;
+    float u_z_near;
+    float u_z_far;
+    float u_tan_half_fov;
+    float u_aspect;
+    vec2 u_viewport_size;
+    uint u_max_cluster_lights;
+};
+
+// view space center and radius
+shared vec4 s_lights[gl_WorkGroupSize.x];
+
+float slice_depth(uint k) {
+    return u_z_near * pow(u_z_far / u_z_near, float(k) / float(u_grid_size.z));
+}
+
+void main() {
+    uint cluster = gl_GlobalInvocationID.x;
+    uint cluster_count = u_grid_size.x * u_grid_size.y * u_grid_size.z;
+    bool valid = cluster < cluster_count;
+
+    // ClusterGrid::bounds
+    uvec3 cell = uvec3(
+        cluster % u_grid_size.x,
+        (cluster / u_grid_size.x) % u_grid_size.y,
+        cluster / (u_grid_size.x * u_grid_size.y)
+    );
+    vec2 ndc_lo = vec2(cell.xy) / vec2(u_grid_size.xy) * 2.0 - 1.0;
+    vec2 ndc_hi = vec2(cell.xy + 1u) / vec2(u_grid_size.xy) * 2.0 - 1.0;
+    vec2 half_extent = vec2(u_tan_half_fov * u_aspect, u_tan_half_fov);
+    float slice_near = slice_depth(cell.z);
+    float slice_far = slice_depth(cell.z + 1u);
+    // the tile's sides are planes through the eye, so its corners on either
+    // slice plane bound it
+    vec2 lo = min(min(ndc_lo * slice_near, ndc_lo * slice_far), min(ndc_hi * slice_near, ndc_hi * slice_far)) * half_extent;
+    vec2 hi = max(max(ndc_lo * slice_near, ndc_lo * slice_far), max(ndc_hi * slice_near, ndc_hi * slice_far)) * half_extent;
+    vec3 box_lo = vec3(lo, -slice_far);
+    vec3 box_hi = vec3(hi, -slice_near);
+
+    uint light_count = u_grid_size.w;
+    uint base = cluster * u_max_cluster_lights;
+    uint count = 0u;
+    for (uint first = 0u; first < light_count; first += gl_WorkGroupSize.x) {
+        uint i = first + gl_LocalInvocationIndex;
+        if (i < light_count) {
+            s_lights[gl_LocalInvocationIndex] = vec4((u_view * vec4(lights[i].pos, 1.0)).xyz, lights[i].radius);
+        }
+        barrier();
+
+        uint batch = min(gl_WorkGroupSize.x, light_count - first);
+        for (uint j = 0u; valid && (j < batch); ++j) {
+            vec4 light = s_lights[j];
+            vec3 d = clamp(light.xyz, box_lo, box_hi) - light.xyz;
+            if ((dot(d, d) <= light.w * light.w) && (count < u_max_cluster_lights)) {
+                cluster_light_indices[base + count] = first + j;
+                ++count;
+            }
+        }
+        // before the next batch overwrites the shared lights
+        barrier();
+    }
+
+    if (valid) {
+        cluster_light_counts[cluster] = count;
+    }
+}
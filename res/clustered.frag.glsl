@@ -0,0 +1,125 @@
+#version 430 core
+
+// frag.glsl plus the point lights of the fragment's cluster, binned by
+// cluster_lights.comp.glsl; with vert.glsl, static.vert.glsl or
+// instanced.vert.glsl
+
+struct AmbientLight {
+    vec3 color;
+    float intensity;
+};
+
+struct Light {
+    vec3 pos;
+    vec3 color;
+    float intensity;
+};
+
+struct Specularity {
+    float roughness;
+    float intensity;
+};
+
+// PointLight
+struct PointLight {
+    vec3 pos;
+    float radius;
+    vec3 color;
+    float intensity;
+};
+
+in vec3 f_pos;
+in vec3 f_normal;
+in vec2 f_uv;
+
+out vec4 color;
+
+uniform sampler2D tex;
+
+layout(std430, binding = 1) readonly buffer PointLights {
+    PointLight lights[];
+};
+
+layout(std430, binding = 2) readonly buffer ClusterLightCounts {
+    uint cluster_light_counts[];
+};
+
+layout(std430, binding = 3) readonly buffer ClusterLightIndices {
+    uint cluster_light_indices[];
+};
+
+// FrameUniforms
+layout(std140) uniform Frame {
+    mat4 u_view;
+    mat4 u_proj;
+    vec3 camera_pos;
+};
+
+// LightUniforms
+layout(std140) uniform Lights {
+    AmbientLight ambient;
+    Light diffuse;
+};
+
+// MaterialUniforms
+layout(std140) uniform Material {
+    Specularity spec;
+};
+
+// ClusterUniforms
+layout(std140) uniform Clusters {
+    uvec4 u_grid_size;
+    float u_z_near;
+    float u_z_far;
+    float u_tan_half_fov;
+    float u_aspect;
+    vec2 u_viewport_size;
+    uint u_max_cluster_lights;
+};
+
+// ClusterGrid::cluster_of, the tile from the window position
+uint cluster_index() {
+    uvec2 tile = uvec2(clamp(
+        ivec2(gl_FragCoord.xy / u_viewport_size * vec2(u_grid_size.xy)),
+        ivec2(0),
+        ivec2(u_grid_size.xy) - 1));
+    float depth = max(-(u_view * vec4(f_pos, 1.0)).z, u_z_near);
+    uint slice = uint(clamp(
+        int(log(depth / u_z_near) / log(u_z_far / u_z_near) * float(u_grid_size.z)),
+        0,
+        int(u_grid_size.z) - 1));
+    return (slice * u_grid_size.y + tile.y) * u_grid_size.x + tile.x;
+}
+
+void main() {
+    vec4 tex_color = texture(tex, f_uv);
+
+    vec3 light_dir = normalize(diffuse.pos - f_pos);
+    vec3 view_vector = normalize(f_pos - camera_pos);
+
+    vec3 refl = reflect(view_vector, f_normal);
+    float spec_factor = pow(max(dot(refl, light_dir), 0), spec.roughness);
+    float mu = max(0, dot(light_dir, f_normal));
+    vec3 light = \
+        spec.intensity * spec_factor * ambient.color +
+        ambient.intensity * ambient.color +
+        mu * diffuse.intensity * diffuse.color;
+
+    uint cluster = cluster_index();
+    uint count = cluster_light_counts[cluster];
+    uint base = cluster * u_max_cluster_lights;
+    for (uint i = 0u; i < count; ++i) {
+        PointLight point = lights[cluster_light_indices[base + i]];
+        vec3 to_light = point.pos - f_pos;
+        float dist = length(to_light);
+        // smooth falloff, 0 at the radius, like deferred_point.frag.glsl
+        float falloff = max(1.0 - (dist*dist) / (point.radius*point.radius), 0.0);
+        falloff *= falloff;
+        vec3 point_dir = to_light / max(dist, 1e-5);
+        float point_spec = pow(max(dot(refl, point_dir), 0), spec.roughness);
+        float point_mu = max(0, dot(point_dir, f_normal));
+        light += falloff * point.intensity * point.color * (point_mu + spec.intensity * point_spec);
+    }
+
+    color = vec4(light, 1.0) * tex_color;
+}
@@ -0,0 +1,81 @@
+#version 330 core
+
+// the ambient and diffuse light of the G-buffer, what frag.glsl does while
+// drawing
+
+struct AmbientLight {
+    vec3 color;
+    float intensity;
+};
+
+struct Light {
+    vec3 pos;
+    vec3 color;
+    float intensity;
+};
+
+out vec4 color;
+
+uniform sampler2D g_albedo;
+uniform sampler2D g_normal_spec;
+uniform sampler2D g_depth;
+
+// FrameUniforms
+layout(std140) uniform Frame {
+    mat4 u_view;
+    mat4 u_proj;
+    vec3 camera_pos;
+};
+
+// LightUniforms
+layout(std140) uniform Lights {
+    AmbientLight ambient;
+    Light diffuse;
+};
+
+// DeferredUniforms
+layout(std140) uniform Deferred {
+    mat4 u_inv_view_proj;
+    vec2 u_viewport_size;
+};
+
+vec3 oct_decode(vec2 e) {
+    vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += (n.x >= 0.0) ? -t : t;
+    n.y += (n.y >= 0.0) ? -t : t;
+    return normalize(n);
+}
+
+vec3 world_pos(float depth) {
+    vec2 uv = gl_FragCoord.xy / u_viewport_size;
+    vec4 pos = u_inv_view_proj * vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);
+    return pos.xyz / pos.w;
+}
+
+void main() {
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    float depth = texelFetch(g_depth, texel, 0).r;
+    if (depth == 1.0) {
+        // nothing drawn, keep the clear color
+        discard;
+    }
+    vec4 albedo = texelFetch(g_albedo, texel, 0);
+    vec4 normal_spec = texelFetch(g_normal_spec, texel, 0);
+    vec3 normal = oct_decode(normal_spec.xy);
+    vec3 pos = world_pos(depth);
+
+    vec3 light_dir = normalize(diffuse.pos - pos);
+    vec3 view_vector = normalize(pos - camera_pos);
+
+    vec3 refl = reflect(view_vector, normal);
+    float spec_factor = pow(max(dot(refl, light_dir), 0), normal_spec.z);
+    float mu = max(0, dot(light_dir, normal));
+    color = \
+        vec4(
+            normal_spec.w * spec_factor * ambient.color +
+            ambient.intensity * ambient.color +
+            mu * diffuse.intensity * diffuse.color,
+            1.0
+        ) * albedo;
+}
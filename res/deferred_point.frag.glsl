@@ -0,0 +1,78 @@
+#version 430 core
+
+// one point light on the G-buffer pixels its volume covers, added up
+
+flat in int f_light;
+
+out vec4 color;
+
+uniform sampler2D g_albedo;
+uniform sampler2D g_normal_spec;
+uniform sampler2D g_depth;
+
+// PointLight
+struct PointLight {
+    vec3 pos;
+    float radius;
+    vec3 color;
+    float intensity;
+};
+
+layout(std430, binding = 1) readonly buffer PointLights {
+    PointLight lights[];
+};
+
+// FrameUniforms
+layout(std140) uniform Frame {
+    mat4 u_view;
+    mat4 u_proj;
+    vec3 camera_pos;
+};
+
+// DeferredUniforms
+layout(std140) uniform Deferred {
+    mat4 u_inv_view_proj;
+    vec2 u_viewport_size;
+};
+
+vec3 oct_decode(vec2 e) {
+    vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += (n.x >= 0.0) ? -t : t;
+    n.y += (n.y >= 0.0) ? -t : t;
+    return normalize(n);
+}
+
+vec3 world_pos(float depth) {
+    vec2 uv = gl_FragCoord.xy / u_viewport_size;
+    vec4 pos = u_inv_view_proj * vec4(vec3(uv, depth) * 2.0 - 1.0, 1.0);
+    return pos.xyz / pos.w;
+}
+
+void main() {
+    PointLight light = lights[f_light];
+    ivec2 texel = ivec2(gl_FragCoord.xy);
+    vec3 pos = world_pos(texelFetch(g_depth, texel, 0).r);
+    vec3 to_light = light.pos - pos;
+    float dist = length(to_light);
+    if (dist >= light.radius) {
+        discard;
+    }
+    vec4 albedo = texelFetch(g_albedo, texel, 0);
+    vec4 normal_spec = texelFetch(g_normal_spec, texel, 0);
+    vec3 normal = oct_decode(normal_spec.xy);
+
+    vec3 light_dir = to_light / dist;
+    vec3 view_vector = normalize(pos - camera_pos);
+    vec3 refl = reflect(view_vector, normal);
+    float spec_factor = pow(max(dot(refl, light_dir), 0), normal_spec.z);
+    float mu = max(0, dot(light_dir, normal));
+    // smooth falloff, 0 at the radius
+    float falloff = 1.0 - (dist*dist) / (light.radius*light.radius);
+    falloff *= falloff;
+
+    color = vec4(
+        falloff * light.intensity * light.color * (mu * albedo.rgb + normal_spec.w * spec_factor),
+        0.0
+    );
+}
@@ -0,0 +1,33 @@
+#version 430 core
+
+// light volumes of DeferredShading: a sphere around each point light, one
+// instance per light
+
+layout(location = 0) in vec3 v_pos;
+
+flat out int f_light;
+
+// PointLight
+struct PointLight {
+    vec3 pos;
+    float radius;
+    vec3 color;
+    float intensity;
+};
+
+layout(std430, binding = 1) readonly buffer PointLights {
+    PointLight lights[];
+};
+
+// FrameUniforms
+layout(std140) uniform Frame {
+    mat4 u_view;
+    mat4 u_proj;
+    vec3 camera_pos;
+};
+
+void main() {
+    PointLight light = lights[gl_InstanceID];
+    gl_Position = u_proj * u_view * vec4(light.pos + v_pos * light.radius, 1.0);
+    f_light = gl_InstanceID;
+}
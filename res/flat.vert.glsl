@@ -5,8 +5,12 @@ in vec4 v_color;
 
 out vec4 f_color;
 
-uniform mat4 u_view;
-uniform mat4 u_proj;
+// FrameUniforms
+layout(std140) uniform Frame {
+    mat4 u_view;
+    mat4 u_proj;
+    vec3 camera_pos;
+};
 
 void main() {
     gl_Position = u_proj * u_view * vec4(v_pos, 1.0);
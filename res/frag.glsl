@@ -16,10 +16,6 @@ struct Specularity {
     float intensity;
 };
 
-struct Camera {
-    vec3 pos;
-};
-
 in vec3 f_pos;
 in vec3 f_normal;
 in vec2 f_uv;
@@ -27,16 +23,30 @@ in vec2 f_uv;
 out vec4 color;
 
 uniform sampler2D tex;
-uniform AmbientLight ambient;
-uniform Light diffuse;
-uniform Camera camera;
-uniform Specularity spec;
+
+// FrameUniforms
+layout(std140) uniform Frame {
+    mat4 u_view;
+    mat4 u_proj;
+    vec3 camera_pos;
+};
+
+// LightUniforms
+layout(std140) uniform Lights {
+    AmbientLight ambient;
+    Light diffuse;
+};
+
+// MaterialUniforms
+layout(std140) uniform Material {
+    Specularity spec;
+};
 
 void main() {
     vec4 tex_color = texture(tex, f_uv);
 
     vec3 light_dir = normalize(diffuse.pos - f_pos);
-    vec3 view_vector = normalize(f_pos - camera.pos);
+    vec3 view_vector = normalize(f_pos - camera_pos);
 
     vec3 refl = reflect(view_vector, f_normal);
     float spec_factor = pow(max(dot(refl, light_dir), 0), spec.roughness);
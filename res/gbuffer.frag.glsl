@@ -0,0 +1,39 @@
+#version 330 core
+
+// writes the G-buffer of DeferredShading instead of lighting like frag.glsl,
+// with vert.glsl, static.vert.glsl or instanced.vert.glsl
+
+struct Specularity {
+    float roughness;
+    float intensity;
+};
+
+in vec3 f_pos;
+in vec3 f_normal;
+in vec2 f_uv;
+
+// DeferredShading::Target
+layout(location = 0) out vec4 g_albedo;
+layout(location = 1) out vec4 g_normal_spec;
+
+uniform sampler2D tex;
+
+// MaterialUniforms
+layout(std140) uniform Material {
+    Specularity spec;
+};
+
+// octahedral encoding, the inverse of oct_decode in deferred_*.frag.glsl
+vec2 oct_encode(vec3 n) {
+    n /= abs(n.x) + abs(n.y) + abs(n.z);
+    vec2 e = n.xy;
+    if (n.z < 0.0) {
+        e = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+    }
+    return e;
+}
+
+void main() {
+    g_albedo = texture(tex, f_uv);
+    g_normal_spec = vec4(oct_encode(normalize(f_normal)), spec.roughness, spec.intensity);
+}
@@ -0,0 +1,31 @@
+#version 330 core
+
+// vert.glsl with a model and normal matrix per instance, see Renderer::render_instanced
+
+layout(location = 0) in vec3 v_pos;
+layout(location = 1) in vec3 v_normal;
+layout(location = 2) in vec2 v_uv;
+
+// locations match InstanceData
+layout(location = 8) in mat4 i_model;
+layout(location = 12) in mat3 i_normal_mat;
+
+out vec3 f_pos;
+out vec3 f_normal;
+out vec2 f_uv;
+
+// FrameUniforms
+layout(std140) uniform Frame {
+    mat4 u_view;
+    mat4 u_proj;
+    vec3 camera_pos;
+};
+
+void main() {
+    vec4 pos = i_model * vec4(v_pos, 1.0);
+    gl_Position = u_proj * u_view * pos;
+
+    f_pos = pos.xyz;
+    f_normal = normalize(i_normal_mat * v_normal);
+    f_uv = v_uv;
+}
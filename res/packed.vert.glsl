@@ -0,0 +1,37 @@
+#version 330 core
+
+// vertex shader for PackedVertex/QuantizedVertex meshes
+
+in vec3 v_pos;
+in vec2 v_normal;
+in vec2 v_uv;
+
+out vec3 f_pos;
+out vec3 f_normal;
+out vec2 f_uv;
+
+// FrameUniforms
+layout(std140) uniform Frame {
+    mat4 u_view;
+    mat4 u_proj;
+    vec3 camera_pos;
+};
+uniform vec3 u_pos_offset;
+uniform vec3 u_pos_scale;
+
+vec3 oct_decode(vec2 e) {
+    vec3 n = vec3(e.xy, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += (n.x >= 0.0) ? -t : t;
+    n.y += (n.y >= 0.0) ? -t : t;
+    return normalize(n);
+}
+
+void main() {
+    vec3 pos = u_pos_offset + v_pos * u_pos_scale;
+    gl_Position = u_proj * u_view * vec4(pos, 1.0);
+
+    f_pos = pos;
+    f_normal = oct_decode(v_normal);
+    f_uv = v_uv;
+}
@@ -0,0 +1,40 @@
+#version 430 core
+
+// vertex shader for meshes of a StaticBatch, drawn with glMultiDrawElementsIndirect
+
+layout(location = 0) in vec3 v_pos;
+layout(location = 1) in vec3 v_normal;
+layout(location = 2) in vec2 v_uv;
+// instanced with divisor 1, so it holds the base instance of the draw
+// command, which is the draw index (gl_BaseInstance needs GL 4.6)
+layout(location = 3) in uint v_draw_id;
+
+out vec3 f_pos;
+out vec3 f_normal;
+out vec2 f_uv;
+
+struct DrawData {
+    mat4 model;
+    mat4 normal_mat;
+};
+
+layout(std430, binding = 0) readonly buffer Draws {
+    DrawData draws[];
+};
+
+// FrameUniforms
+layout(std140) uniform Frame {
+    mat4 u_view;
+    mat4 u_proj;
+    vec3 camera_pos;
+};
+
+void main() {
+    DrawData draw = draws[v_draw_id];
+    vec4 pos = draw.model * vec4(v_pos, 1.0);
+    gl_Position = u_proj * u_view * pos;
+
+    f_pos = pos.xyz;
+    f_normal = normalize(mat3(draw.normal_mat) * v_normal);
+    f_uv = v_uv;
+}
@@ -1,15 +1,19 @@
 #version 330 core
 
-in vec3 v_pos;
-in vec3 v_normal;
-in vec2 v_uv;
+layout(location = 0) in vec3 v_pos;
+layout(location = 1) in vec3 v_normal;
+layout(location = 2) in vec2 v_uv;
 
 out vec3 f_pos;
 out vec3 f_normal;
 out vec2 f_uv;
 
-uniform mat4 u_view;
-uniform mat4 u_proj;
+// FrameUniforms
+layout(std140) uniform Frame {
+    mat4 u_view;
+    mat4 u_proj;
+    vec3 camera_pos;
+};
 
 void main() {
     gl_Position = u_proj * u_view * vec4(v_pos, 1.0);
@@ -1,15 +1,41 @@
 #pragma once
 
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <utility>
+
+#include <spdlog/spdlog.h>
+
+#include "asset_loader.h"
+#include "cpu_profiler.h"
 #include "layer.h"
 #include "renderer.h"
 #include "input.h"
+#include "surface.h"
 
 class Application {
     public:
-        Application(GLFWwindow* win) : win_{win}, renderer_{win}, input_mngr_{win}, is_running_{true} {
-            layers_.push_back(std::make_unique<ImGuiLayer>(*this, win));
+        // frames in a trace written by `write_trace`
+        static constexpr size_t trace_frames = 300;
+
+        // `surface` has to outlive the application
+        explicit Application(Surface& surface) :
+                surface_{surface},
+                renderer_{surface},
+                input_mngr_{make_input_manager(surface)},
+                is_running_{true} {
+            layers_.push_back(std::make_unique<ImGuiLayer>(*this, surface));
+            input_mngr_->register_key_handler([this](KeyCode key, KeyState state, KeyModifier) {
+                if (key == KeyCode::KEY_F12 && state == KeyState::Pressed) {
+                    write_trace();
+                }
+            });
         }
         ~Application() {
+            if (trace_on_exit_) {
+                write_trace();
+            }
             for (auto& layer : layers_) {
                 layer->cleanup();
             }
@@ -17,10 +43,12 @@ class Application {
 
         void run() {
             while (is_running_) {
-                if (glfwWindowShouldClose(win_)) {
+                if (surface_.should_close()) {
                     this->is_running_ = false;
                     break;
                 }
+                cpu_profiler().mark_frame();
+                auto zone = cpu_profiler().zone("Frame");
                 prepare_frame();
                 update();
                 draw();
@@ -35,26 +63,59 @@ class Application {
         }
 
         void prepare_frame() {
-            glfwPollEvents();
+            auto zone = cpu_profiler().zone("prepare_frame");
+            {
+                auto poll_zone = cpu_profiler().zone("poll_events");
+                surface_.poll_events();
+            }
+            {
+                auto upload_zone = cpu_profiler().zone("process_uploads");
+                asset_loader_.process_uploads();
+            }
 
             for (auto& layer : layers_) {
+                auto layer_zone = cpu_profiler().zone(layer->name());
                 layer->prepare_frame();
             }
         }
 
         void update() {
+            auto zone = cpu_profiler().zone("update");
             for (auto& layer : layers_) {
+                auto layer_zone = cpu_profiler().zone(layer->name());
                 layer->on_update();
             }
         }
         void draw() {
+            auto zone = cpu_profiler().zone("draw");
+            renderer_.begin_frame();
             renderer_.clear_screen();
 
             for (auto& layer : layers_) {
+                auto layer_zone = cpu_profiler().zone(layer->name());
+                auto gpu_zone = renderer_.profiler().zone(layer->name());
                 layer->on_draw();
             }
+            renderer_.end_frame();
 
-            glfwSwapBuffers(win_);
+            auto swap_zone = cpu_profiler().zone("swap_buffers");
+            surface_.swap_buffers();
+        }
+
+        // where F12 writes the last `trace_frames` frames of the CPU profiler
+        // as Chrome trace_event JSON; with `on_exit` also when the application
+        // closes
+        void set_trace_path(std::filesystem::path fpath, bool on_exit = false) {
+            trace_path_ = std::move(fpath);
+            trace_on_exit_ = on_exit;
+        }
+
+        void write_trace() const {
+            if (cpu_profiler().write_trace(trace_path_, trace_frames)) {
+                spdlog::info("wrote CPU trace to \"{}\"", trace_path_.string());
+            } else {
+                spdlog::error("can't write CPU trace to \"{}\"", trace_path_.string());
+            }
         }
 
         LayerStack& layers() noexcept {
@@ -69,18 +130,36 @@ class Application {
             return renderer_;
         }
 
+        AssetLoader& asset_loader() noexcept {
+            return asset_loader_;
+        }
+
         InputManager& input_manager() {
-            return input_mngr_;
+            return *input_mngr_;
         }
 
         const InputManager& input_manager() const {
-            return input_mngr_;
+            return *input_mngr_;
+        }
+
+        Surface& surface() noexcept {
+            return surface_;
         }
     protected:
-        GLFWwindow* win_;
+        static std::unique_ptr<InputManager> make_input_manager(Surface& surface) {
+            if (auto win = surface.window()) {
+                return std::make_unique<GLFWInputManager>(win);
+            }
+            return std::make_unique<NullInputManager>();
+        }
+
+        Surface& surface_;
         Renderer renderer_;
-        GLFWInputManager input_mngr_;
+        std::unique_ptr<InputManager> input_mngr_;
+        AssetLoader asset_loader_;
         bool is_running_;
+        std::filesystem::path trace_path_ = "glsb_trace.json";
+        bool trace_on_exit_ = false;
 
         LayerStack layers_;
 };
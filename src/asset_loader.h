@@ -0,0 +1,160 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "thread_pool.h"
+
+// Runs the expensive part of asset loading (file I/O, parsing, decoding) on
+// worker threads. Work that needs the GL context is queued as an upload and
+// runs on the render thread in `process_uploads`.
+class AssetLoader {
+    public:
+        // keeps one core free for the render thread
+        explicit AssetLoader(unsigned thread_count = std::max(std::thread::hardware_concurrency(), 2u) - 1) :
+            pool_{thread_count} {}
+
+        AssetLoader(const AssetLoader&) = delete;
+        AssetLoader& operator=(const AssetLoader&) = delete;
+
+        // runs `load_fn()` on a worker thread
+        template <typename LoadFn>
+        std::future<std::invoke_result_t<LoadFn>> load(LoadFn&& load_fn) {
+            ++loads_in_flight_;
+            return pool_.submit([this, load_fn = std::forward<LoadFn>(load_fn)]() mutable {
+                auto done = LoadDone{loads_in_flight_};
+                return load_fn();
+            });
+        }
+
+        // Runs `load_fn()` on a worker thread and passes its result to
+        // `upload_fn` on the render thread. The future holds the result of
+        // `upload_fn` or the exception thrown by either function.
+        template <typename LoadFn, typename UploadFn>
+        auto load(LoadFn&& load_fn, UploadFn&& upload_fn) {
+            return load_after({}, std::forward<LoadFn>(load_fn), std::forward<UploadFn>(upload_fn));
+        }
+
+        // Like `load(load_fn, upload_fn)`, but `upload_fn` waits in the queue
+        // until all of `deps` are ready, e.g. the programs whose attribute
+        // locations a mesh upload needs. Nothing blocks a worker meanwhile.
+        template <typename LoadFn, typename UploadFn>
+        auto load_after(std::vector<std::shared_future<void>> deps, LoadFn&& load_fn, UploadFn&& upload_fn) {
+            using asset_type = std::invoke_result_t<LoadFn>;
+            using result_type = std::invoke_result_t<UploadFn, asset_type&&>;
+
+            auto promise = std::make_shared<std::promise<result_type>>();
+            auto ret = promise->get_future();
+            ++loads_in_flight_;
+            pool_.submit([this, promise, deps = std::move(deps), load_fn = std::forward<LoadFn>(load_fn), upload_fn = std::forward<UploadFn>(upload_fn)]() mutable {
+                try {
+                    // shared, as queued uploads have to be copyable
+                    auto asset = std::make_shared<asset_type>(load_fn());
+                    enqueue_upload(std::move(deps), [this, promise, asset, upload_fn = std::move(upload_fn)]() mutable {
+                        auto done = LoadDone{loads_in_flight_};
+                        try {
+                            if constexpr (std::is_void_v<result_type>) {
+                                upload_fn(std::move(*asset));
+                                promise->set_value();
+                            } else {
+                                promise->set_value(upload_fn(std::move(*asset)));
+                            }
+                        } catch (...) {
+                            promise->set_exception(std::current_exception());
+                        }
+                    });
+                } catch (...) {
+                    --loads_in_flight_;
+                    promise->set_exception(std::current_exception());
+                }
+            });
+            return ret;
+        }
+
+        // Runs queued uploads on the calling thread until the queue is empty
+        // or `budget` is used up. At least one upload runs per call, so
+        // loading progresses even if single uploads exceed the budget.
+        size_t process_uploads(std::chrono::microseconds budget = std::chrono::milliseconds(4)) {
+            auto start = std::chrono::steady_clock::now();
+            auto processed = size_t{0};
+            {
+                auto lock = std::scoped_lock(mtx_);
+                // moves the uploads whose dependencies are ready to the queue
+                std::erase_if(waiting_, [this](WaitingUpload& waiting) {
+                    auto ready = std::all_of(waiting.deps.begin(), waiting.deps.end(), [](const auto& dep) {
+                        return dep.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+                    });
+                    if (ready) {
+                        uploads_.push_back(std::move(waiting.upload));
+                    }
+                    return ready;
+                });
+            }
+            do {
+                auto upload = std::function<void()>{};
+                {
+                    auto lock = std::scoped_lock(mtx_);
+                    if (uploads_.empty()) {
+                        break;
+                    }
+                    upload = std::move(uploads_.front());
+                    uploads_.pop_front();
+                }
+                upload();
+                ++processed;
+            } while (std::chrono::steady_clock::now() - start < budget);
+            return processed;
+        }
+
+        // queued uploads, including those waiting for their dependencies
+        size_t pending_uploads() const {
+            auto lock = std::scoped_lock(mtx_);
+            return uploads_.size() + waiting_.size();
+        }
+
+        // loads that haven't finished yet, including their uploads
+        size_t pending_loads() const noexcept {
+            return loads_in_flight_;
+        }
+    private:
+        // counts a load as finished when it goes out of scope
+        struct LoadDone {
+            std::atomic<size_t>& loads_in_flight;
+
+            ~LoadDone() {
+                --loads_in_flight;
+            }
+        };
+
+        struct WaitingUpload {
+            std::vector<std::shared_future<void>> deps;
+            std::function<void()> upload;
+        };
+
+        void enqueue_upload(std::vector<std::shared_future<void>> deps, std::function<void()> upload) {
+            auto lock = std::scoped_lock(mtx_);
+            if (deps.empty()) {
+                uploads_.push_back(std::move(upload));
+            } else {
+                waiting_.push_back(WaitingUpload{std::move(deps), std::move(upload)});
+            }
+        }
+
+        mutable std::mutex mtx_;
+        std::deque<std::function<void()>> uploads_;
+        std::vector<WaitingUpload> waiting_;
+        std::atomic<size_t> loads_in_flight_ = 0;
+        // declared last: joins the workers before the queue goes away
+        ThreadPool pool_;
+};
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+
+#include <GL/glew.h>
+#include <spdlog/spdlog.h>
+
+#include "application.h"
+#include "framebuffer.h"
+#include "layer.h"
+#include "rolling_stats.h"
+
+// Renders the frames of the layers after it into an offscreen framebuffer,
+// closes the surface after `frame_count` timed frames and logs their frame
+// times. Warmup starts once the asset loader is idle, so loading doesn't skew
+// the timing. Goes first in the layer stack, so the framebuffer is bound
+// before anything draws.
+class BenchmarkLayer final : public Layer {
+    public:
+        BenchmarkLayer(Application& app, size_t frame_count, size_t warmup_frames = 60) :
+            Layer{app},
+            frame_count_{frame_count},
+            warmup_frames_{warmup_frames},
+            frame_ms_{frame_count} {}
+
+        const char* name() const noexcept override {
+            return "Benchmark";
+        }
+
+        void init() override {
+            // `Renderer` sets the viewport to the surface's framebuffer size
+            auto size = app_.surface().framebuffer_size();
+            framebuffer_.emplace(size.width, size.height);
+        }
+
+        void cleanup() override {
+            glFinish();
+            if (frame_ms_.empty()) {
+                spdlog::warn("benchmark: no frames timed");
+                return;
+            }
+            auto mean = frame_ms_.mean();
+            spdlog::info("benchmark: {} frames at {}x{} after {} warmup frames",
+                frame_ms_.size(), framebuffer_->width(), framebuffer_->height(), warmup_frames_);
+            spdlog::info("benchmark: frame time mean {:.3f} ms, p50 {:.3f} ms, p95 {:.3f} ms, p99 {:.3f} ms, max {:.3f} ms ({:.1f} fps)",
+                mean, frame_ms_.percentile(.5f), frame_ms_.percentile(.95f), frame_ms_.percentile(.99f),
+                frame_ms_.percentile(1.f), mean > 0.f ? 1000.f/mean : 0.f);
+        }
+
+        void prepare_frame() override {
+            framebuffer_->bind();
+
+            auto& loader = app_.asset_loader();
+            if (frame_ == 0 && (loader.pending_loads() > 0 || loader.pending_uploads() > 0)) {
+                return;
+            }
+
+            auto now = clock::now();
+            if (frame_ > warmup_frames_) {
+                frame_ms_.push(std::chrono::duration<float, std::milli>(now - last_frame_begin_).count());
+            }
+            last_frame_begin_ = now;
+            ++frame_;
+            if (frame_ms_.size() == frame_count_) {
+                app_.surface().request_close();
+            }
+        }
+
+        void on_update() override {
+        }
+
+        void on_draw() override {
+        }
+    private:
+        using clock = std::chrono::steady_clock;
+
+        size_t frame_count_;
+        size_t warmup_frames_;
+        std::optional<Framebuffer> framebuffer_;
+        RollingStats frame_ms_;
+        clock::time_point last_frame_begin_;
+        size_t frame_ = 0;
+};
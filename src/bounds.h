@@ -0,0 +1,64 @@
+#pragma once
+
+#include <algorithm>
+#include <limits>
+#include <span>
+
+#include <glm/glm.hpp>
+
+struct BoundingBox {
+    // inverted, so that growing it by anything yields that thing's bounds
+    static BoundingBox empty() noexcept {
+        return {glm::vec3(std::numeric_limits<float>::max()), glm::vec3(std::numeric_limits<float>::lowest())};
+    }
+
+    void grow(const glm::vec3& p) noexcept {
+        lo = glm::min(lo, p);
+        hi = glm::max(hi, p);
+    }
+
+    void grow(const BoundingBox& other) noexcept {
+        lo = glm::min(lo, other.lo);
+        hi = glm::max(hi, other.hi);
+    }
+
+    glm::vec3 center() const noexcept {
+        return (lo+hi)*.5f;
+    }
+
+    float surface_area() const noexcept {
+        auto ext = glm::max(hi-lo, glm::vec3(0.f));
+        return 2.f*(ext.x*ext.y + ext.y*ext.z + ext.z*ext.x);
+    }
+
+    glm::vec3 lo;
+    glm::vec3 hi;
+};
+
+struct BoundingSphere {
+    glm::vec3 center;
+    float radius;
+};
+
+// axis aligned bounding box of the vertex positions, empty for no vertices
+template <typename VertexT>
+BoundingBox compute_bounding_box(std::span<const VertexT> vertices) noexcept {
+    auto ret = BoundingBox::empty();
+    for (const auto& vert : vertices) {
+        ret.grow(vert.pos);
+    }
+    return ret;
+}
+
+// sphere around the axis aligned bounding box of the vertex positions
+template <typename VertexT>
+BoundingSphere compute_bounding_sphere(std::span<const VertexT> vertices) noexcept {
+    if (vertices.empty()) {
+        return BoundingSphere{glm::vec3(0.f), 0.f};
+    }
+    auto ret = BoundingSphere{compute_bounding_box(vertices).center(), 0.f};
+    for (const auto& vert : vertices) {
+        ret.radius = std::max(ret.radius, glm::length(vert.pos - ret.center));
+    }
+    return ret;
+}
@@ -1,25 +1,28 @@
 #pragma once
 
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "gl_state.h"
 #include "utils.h"
 
 #include <GL/glew.h>
 
-enum class BufferType : GLenum {
-    Array = GL_ARRAY_BUFFER,
-    ElementArray = GL_ELEMENT_ARRAY_BUFFER,
-};
-
 template <BufferType Type>
 class Buffer {
     public:
         struct BufferDeleter {
             void operator()(GLuint buffer_hndl) const noexcept {
+                gl_state().forget_buffer(buffer_hndl);
                 glDeleteBuffers(1, &buffer_hndl);
             }
         };
         using UniqueBufferHandle = UniqueHandle<GLuint, BufferDeleter>;
 
-        Buffer() : buf_{}, is_bound_{false} {
+        Buffer() : buf_{} {
             auto buf = typename UniqueBufferHandle::value_type{};
             glGenBuffers(1, &buf);
             buf_.reset(buf);
@@ -27,7 +30,7 @@ class Buffer {
 
         void set_data(const void* data, size_t size, GLenum usage) const {
             assert((size < PTRDIFF_MAX));
-            bool do_unbind = !is_bound_;
+            bool do_unbind = !gl_state().is_bound(Type, buf_.get());
             bind();
             glBufferData(
                 static_cast<std::underlying_type_t<BufferType>>(Type),
@@ -39,20 +42,215 @@ class Buffer {
             }
         }
 
+        // through `gl_state()`, so binding the bound buffer again is free
         void bind() const noexcept {
-            if (!is_bound_) {
-                glBindBuffer(static_cast<std::underlying_type_t<BufferType>>(Type), buf_.get());
-                is_bound_ = true;
-            }
+            gl_state().bind_buffer(Type, buf_.get());
         }
 
         void unbind() const noexcept {
-            if (is_bound_) {
-                glBindBuffer(static_cast<std::underlying_type_t<BufferType>>(Type), 0);
-                is_bound_ = false;
+            if (gl_state().is_bound(Type, buf_.get())) {
+                gl_state().bind_buffer(Type, 0);
             }
         }
+
+        GLuint handle() const noexcept {
+            return buf_.get();
+        }
     private:
         UniqueBufferHandle buf_;
-        mutable bool is_bound_;
+};
+
+// Buffer that grows geometrically as data is appended. The old contents are
+// copied on the GPU, going through the copy targets so growing doesn't
+// disturb any other binding.
+template <BufferType Type>
+class GrowableBuffer {
+    public:
+        explicit GrowableBuffer(GLenum usage = GL_STATIC_DRAW) : usage_{usage} {}
+
+        void append(const void* data, size_t size) {
+            if (size_ + size > capacity_) {
+                grow(std::max(capacity_*2, size_ + size));
+            }
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buf_.handle());
+            glBufferSubData(GL_COPY_WRITE_BUFFER, static_cast<GLintptr>(size_), static_cast<GLsizeiptr>(size), data);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+            size_ += size;
+        }
+
+        size_t size() const noexcept {
+            return size_;
+        }
+
+        size_t capacity() const noexcept {
+            return capacity_;
+        }
+
+        const Buffer<Type>& buffer() const noexcept {
+            return buf_;
+        }
+
+        Buffer<Type> release() && noexcept {
+            return std::move(buf_);
+        }
+    private:
+        void grow(size_t capacity) {
+            assert((capacity < PTRDIFF_MAX));
+            auto buf = Buffer<Type>{};
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buf.handle());
+            glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(capacity), nullptr, usage_);
+            if (size_ > 0) {
+                glBindBuffer(GL_COPY_READ_BUFFER, buf_.handle());
+                glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, static_cast<GLsizeiptr>(size_));
+                glBindBuffer(GL_COPY_READ_BUFFER, 0);
+            }
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+            // the old buffer is deleted with `buf`
+            std::swap(buf_, buf);
+            capacity_ = capacity;
+        }
+
+        Buffer<Type> buf_;
+        GLenum usage_;
+        size_t size_ = 0;
+        size_t capacity_ = 0;
+};
+
+// Persistently mapped buffer for data that changes every frame, e.g. instance
+// data or draw commands. The storage is split into one region per frame in
+// flight. The region of a frame is only written again after a fence shows the
+// GPU is done with it, so writes never stall on a reallocation or sync with
+// the driver. Needs GL 4.4 or ARB_buffer_storage.
+//
+// Call `begin_frame` before and `end_frame` after the frame's draw calls;
+// `allocate` hands out write pointers in between.
+template <BufferType Type>
+class RingBuffer {
+    public:
+        static constexpr size_t frame_count = 3;
+
+        struct Allocation {
+            // write only, coherent: no flush needed before drawing
+            void* ptr;
+            // of `ptr` in `buffer()`
+            size_t offset;
+        };
+
+        explicit RingBuffer(size_t frame_size) {
+            if (!GLEW_ARB_buffer_storage) {
+                throw GLSBError("persistently mapped buffers need ARB_buffer_storage");
+            }
+            allocate_storage(frame_size);
+        }
+
+        RingBuffer(const RingBuffer&) = delete;
+        RingBuffer& operator=(const RingBuffer&) = delete;
+
+        ~RingBuffer() {
+            for (auto& fence : fences_) {
+                if (fence != nullptr) {
+                    glDeleteSync(fence);
+                }
+            }
+            unmap();
+        }
+
+        // moves on to the next region, waits until the GPU has finished the
+        // frame that used it last
+        void begin_frame() {
+            frame_ = (frame_ + 1) % frame_count;
+            head_ = 0;
+            auto& fence = fences_[frame_];
+            if (fence == nullptr) {
+                return;
+            }
+            constexpr auto timeout_ns = GLuint64{1'000'000'000};
+            auto res = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeout_ns);
+            while (res == GL_TIMEOUT_EXPIRED) {
+                res = glClientWaitSync(fence, 0, timeout_ns);
+            }
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+
+        void end_frame() {
+            assert(fences_[frame_] == nullptr);
+            fences_[frame_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        }
+
+        // `size` bytes at an offset that is a multiple of `alignment` (which
+        // need not be a power of 2). If the region is full, the buffer grows,
+        // which invalidates the pointers of earlier allocations: write the
+        // data before allocating again.
+        Allocation allocate(size_t size, size_t alignment = 16) {
+            assert(alignment > 0);
+            auto base = frame_*frame_size_;
+            auto offset = (base + head_ + alignment-1)/alignment*alignment;
+            if (offset + size > base + frame_size_) {
+                grow(std::max(frame_size_*2, size + alignment));
+                base = frame_*frame_size_;
+                offset = (base + alignment-1)/alignment*alignment;
+            }
+            head_ = offset + size - base;
+            return Allocation{static_cast<std::byte*>(mapped_) + offset, offset};
+        }
+
+        const Buffer<Type>& buffer() const noexcept {
+            return buf_;
+        }
+
+        size_t frame_size() const noexcept {
+            return frame_size_;
+        }
+
+        // changes whenever the buffer grows and `buffer()` is replaced, so
+        // bindings to the old buffer are known to be stale; never 0
+        uint64_t generation() const noexcept {
+            return generation_;
+        }
+    private:
+        static constexpr GLbitfield map_flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        void allocate_storage(size_t frame_size) {
+            assert((frame_size*frame_count < PTRDIFF_MAX));
+            auto size = static_cast<GLsizeiptr>(frame_size*frame_count);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buf_.handle());
+            glBufferStorage(GL_COPY_WRITE_BUFFER, size, nullptr, map_flags);
+            mapped_ = glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, map_flags);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+            if (mapped_ == nullptr) {
+                throw GLSBError("error mapping ring buffer");
+            }
+            frame_size_ = frame_size;
+        }
+
+        void unmap() noexcept {
+            if (mapped_ != nullptr) {
+                glBindBuffer(GL_COPY_WRITE_BUFFER, buf_.handle());
+                glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+                glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+                mapped_ = nullptr;
+            }
+        }
+
+        // Immutable storage can't be resized, so a new buffer replaces the old
+        // one. Draws already issued keep the old storage alive, the fences of
+        // the other regions stay valid since they only guard the frame order.
+        void grow(size_t frame_size) {
+            unmap();
+            auto buf = Buffer<Type>{};
+            // the old buffer is deleted with `buf`
+            std::swap(buf_, buf);
+            allocate_storage(frame_size);
+            ++generation_;
+        }
+
+        Buffer<Type> buf_;
+        void* mapped_ = nullptr;
+        size_t frame_size_ = 0;
+        size_t frame_ = 0;
+        // bytes used in the current frame's region
+        size_t head_ = 0;
+        uint64_t generation_ = 1;
+        GLsync fences_[frame_count] = {};
 };
@@ -0,0 +1,440 @@
+#include "bvh.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "simd.h"
+
+namespace {
+
+using simd::Float4;
+using simd::Mask4;
+
+struct BuildTriangle {
+    BoundingBox bounds;
+    glm::vec3 centroid;
+};
+
+struct BuildTask {
+    uint32_t node;
+    uint32_t begin;
+    uint32_t end;
+    uint32_t depth;
+};
+
+struct Split {
+    int axis = -1;
+    // triangles with a centroid bin below `bin` go left
+    uint32_t bin = 0;
+    float cost = std::numeric_limits<float>::infinity();
+};
+
+// Maps centroids to bins along one axis of the centroid bounds.
+struct Binning {
+    Binning(const BoundingBox& centroid_bounds, int axis_, uint32_t bin_count_) noexcept :
+            axis{axis_},
+            bin_count{bin_count_},
+            lo{centroid_bounds.lo[axis_]},
+            scale{static_cast<float>(bin_count_) / (centroid_bounds.hi[axis_] - centroid_bounds.lo[axis_])} {}
+
+    uint32_t bin(const glm::vec3& centroid) const noexcept {
+        auto ret = static_cast<uint32_t>(std::max((centroid[axis] - lo)*scale, 0.f));
+        return std::min(ret, bin_count-1);
+    }
+
+    int axis;
+    uint32_t bin_count;
+    float lo;
+    float scale;
+};
+
+// triangles are tested in blocks of 4, so that's what a leaf costs
+float
+leaf_cost(uint32_t count) noexcept {
+    return static_cast<float>((count + 3)/4);
+}
+
+Split
+find_split(
+        std::span<const BuildTriangle> triangles,
+        std::span<const uint32_t> order,
+        const BoundingBox& bounds,
+        const BoundingBox& centroid_bounds,
+        const BvhSettings& settings) {
+    struct Bin {
+        BoundingBox bounds = BoundingBox::empty();
+        uint32_t count = 0;
+    };
+    auto bins = std::vector<Bin>(settings.bin_count);
+    // cost of everything right of a split, computed in a backward sweep
+    auto right_cost = std::vector<float>(settings.bin_count);
+    auto inv_area = 1.f / std::max(bounds.surface_area(), std::numeric_limits<float>::min());
+
+    auto ret = Split{};
+    for (int axis=0; axis<3; ++axis) {
+        if (!(centroid_bounds.hi[axis] > centroid_bounds.lo[axis])) {
+            continue;
+        }
+        auto binning = Binning(centroid_bounds, axis, settings.bin_count);
+        std::fill(bins.begin(), bins.end(), Bin{});
+        for (auto tri : order) {
+            auto& bin = bins[binning.bin(triangles[tri].centroid)];
+            bin.bounds.grow(triangles[tri].bounds);
+            ++bin.count;
+        }
+
+        auto acc = Bin{};
+        for (auto i=settings.bin_count-1; i>0; --i) {
+            acc.bounds.grow(bins[i].bounds);
+            acc.count += bins[i].count;
+            right_cost[i] = (acc.count > 0) ? acc.bounds.surface_area()*leaf_cost(acc.count) : 0.f;
+        }
+        acc = Bin{};
+        for (uint32_t i=1; i<settings.bin_count; ++i) {
+            acc.bounds.grow(bins[i-1].bounds);
+            acc.count += bins[i-1].count;
+            if ((acc.count == 0) || (acc.count == order.size())) {
+                continue;
+            }
+            auto cost = settings.traversal_cost + (acc.bounds.surface_area()*leaf_cost(acc.count) + right_cost[i])*inv_area;
+            if (cost < ret.cost) {
+                ret = Split{axis, i, cost};
+            }
+        }
+    }
+    return ret;
+}
+
+// slab test, `t_entry` is where the ray enters the box
+bool
+intersect_box(const Bvh::Node& node, const glm::vec3& origin, const glm::vec3& inv_dir, float t_max, float& t_entry) noexcept {
+    auto t1 = (node.lo - origin)*inv_dir;
+    auto t2 = (node.hi - origin)*inv_dir;
+    auto t_near = glm::min(t1, t2);
+    auto t_far = glm::max(t1, t2);
+    t_entry = std::max(std::max(t_near.x, t_near.y), std::max(t_near.z, 0.f));
+    auto t_exit = std::min(std::min(t_far.x, t_far.y), std::min(t_far.z, t_max));
+    return t_entry <= t_exit;
+}
+
+// avoids NaNs in the slab test for axis aligned rays
+float
+safe_inverse(float d) noexcept {
+    constexpr auto min_abs = 1e-30f;
+    return 1.f / ((std::fabs(d) > min_abs) ? d : std::copysign(min_abs, d));
+}
+
+struct Vec3x4 {
+    Float4 x, y, z;
+
+    static Vec3x4 broadcast(const glm::vec3& v) noexcept {
+        return {Float4(v.x), Float4(v.y), Float4(v.z)};
+    }
+
+    static Vec3x4 load(const float (&v)[3][4]) noexcept {
+        return {Float4::load(v[0]), Float4::load(v[1]), Float4::load(v[2])};
+    }
+
+    friend Vec3x4 operator-(const Vec3x4& a, const Vec3x4& b) noexcept {
+        return {a.x - b.x, a.y - b.y, a.z - b.z};
+    }
+};
+
+Float4
+dot(const Vec3x4& a, const Vec3x4& b) noexcept {
+    return a.x*b.x + a.y*b.y + a.z*b.z;
+}
+
+Vec3x4
+cross(const Vec3x4& a, const Vec3x4& b) noexcept {
+    return {a.y*b.z - a.z*b.y, a.z*b.x - a.x*b.z, a.x*b.y - a.y*b.x};
+}
+
+struct TriangleHits {
+    Mask4 mask;
+    Float4 t, u, v;
+};
+
+// Möller-Trumbore, two sided. Either one ray against 4 triangles or 4 rays
+// against one triangle, depending on what is broadcast.
+TriangleHits
+intersect_triangles(
+        const Vec3x4& origin,
+        const Vec3x4& dir,
+        const Vec3x4& v0,
+        const Vec3x4& e1,
+        const Vec3x4& e2,
+        Float4 t_max) noexcept {
+    auto pvec = cross(dir, e2);
+    auto det = dot(e1, pvec);
+    auto inv_det = Float4(1.f) / det;
+    auto tvec = origin - v0;
+    auto qvec = cross(tvec, e1);
+    auto ret = TriangleHits{};
+    ret.u = dot(tvec, pvec)*inv_det;
+    ret.v = dot(dir, qvec)*inv_det;
+    ret.t = dot(e2, qvec)*inv_det;
+    auto zero = Float4(0.f);
+    ret.mask = (simd::abs(det) > Float4(std::numeric_limits<float>::min()))
+        & (ret.u >= zero) & (ret.v >= zero) & (ret.u + ret.v <= Float4(1.f))
+        & (ret.t > zero) & (ret.t < t_max);
+    return ret;
+}
+
+}
+
+Bvh::Bvh(std::span<const glm::vec3> positions, std::span<const uint32_t> indices, const BvhSettings& settings) :
+        triangle_count_{indices.size()/3} {
+    assert(settings.bin_count >= 2);
+    auto triangles = std::vector<BuildTriangle>{};
+    triangles.reserve(triangle_count_);
+    for (size_t i=0; i<triangle_count_; ++i) {
+        auto tri = BuildTriangle{BoundingBox::empty(), glm::vec3(0.f)};
+        for (size_t k=0; k<3; ++k) {
+            assert(indices[3*i+k] < positions.size());
+            tri.bounds.grow(positions[indices[3*i+k]]);
+        }
+        tri.centroid = tri.bounds.center();
+        triangles.push_back(tri);
+    }
+    auto order = std::vector<uint32_t>(triangle_count_);
+    for (uint32_t i=0; i<order.size(); ++i) {
+        order[i] = i;
+    }
+
+    nodes_.push_back(Node{glm::vec3(0.f), 0, glm::vec3(0.f), 0});
+    auto tasks = std::vector<BuildTask>{{0, 0, static_cast<uint32_t>(triangle_count_), 0}};
+    while (!tasks.empty()) {
+        auto task = tasks.back();
+        tasks.pop_back();
+
+        auto range = std::span<uint32_t>(order).subspan(task.begin, task.end - task.begin);
+        auto bounds = BoundingBox::empty();
+        auto centroid_bounds = BoundingBox::empty();
+        for (auto tri : range) {
+            bounds.grow(triangles[tri].bounds);
+            centroid_bounds.grow(triangles[tri].centroid);
+        }
+        nodes_[task.node].lo = bounds.lo;
+        nodes_[task.node].hi = bounds.hi;
+
+        auto count = static_cast<uint32_t>(range.size());
+        auto can_split = (count > 1) && (task.depth+1 < max_depth);
+        auto split = can_split ? find_split(triangles, range, bounds, centroid_bounds, settings) : Split{};
+        if (!can_split || ((count <= settings.max_leaf_size) && (leaf_cost(count) <= split.cost))) {
+            // turned into blocks below
+            nodes_[task.node].first = task.begin;
+            nodes_[task.node].count = count;
+            continue;
+        }
+
+        auto mid = task.begin + count/2;
+        if (split.axis >= 0) {
+            auto binning = Binning(centroid_bounds, split.axis, settings.bin_count);
+            auto it = std::partition(range.begin(), range.end(), [&](uint32_t tri) {
+                return binning.bin(triangles[tri].centroid) < split.bin;
+            });
+            mid = task.begin + static_cast<uint32_t>(it - range.begin());
+        }
+        // else all centroids coincide and any split is as good as another
+
+        auto child = static_cast<uint32_t>(nodes_.size());
+        nodes_.resize(nodes_.size() + 2);
+        nodes_[task.node].first = child;
+        nodes_[task.node].count = 0;
+        tasks.push_back(BuildTask{child, task.begin, mid, task.depth+1});
+        tasks.push_back(BuildTask{child+1, mid, task.end, task.depth+1});
+    }
+
+    // pack the leaf triangles into blocks
+    for (auto& node : nodes_) {
+        if (!node.is_leaf()) {
+            continue;
+        }
+        auto first_block = static_cast<uint32_t>(blocks_.size());
+        for (uint32_t i=0; i<node.count; i+=4) {
+            auto block = TriangleBlock{};
+            for (uint32_t lane=0; lane<4; ++lane) {
+                if (i + lane >= node.count) {
+                    triangle_ids_.push_back(RayHit::no_triangle);
+                    continue;
+                }
+                auto tri = order[node.first + i + lane];
+                auto v0 = positions[indices[3*tri]];
+                auto e1 = positions[indices[3*tri+1]] - v0;
+                auto e2 = positions[indices[3*tri+2]] - v0;
+                for (int c=0; c<3; ++c) {
+                    block.v0[c][lane] = v0[c];
+                    block.e1[c][lane] = e1[c];
+                    block.e2[c][lane] = e2[c];
+                }
+                triangle_ids_.push_back(tri);
+            }
+            blocks_.push_back(block);
+        }
+        node.first = first_block;
+    }
+}
+
+RayHit
+Bvh::intersect(const Ray& ray) const noexcept {
+    if (triangle_count_ == 0) {
+        return RayHit{};
+    }
+    auto inv_dir = glm::vec3(safe_inverse(ray.dir.x), safe_inverse(ray.dir.y), safe_inverse(ray.dir.z));
+    auto origin = Vec3x4::broadcast(ray.origin);
+    auto dir = Vec3x4::broadcast(ray.dir);
+
+    auto ret = RayHit{};
+    ret.t = ray.t_max;
+    auto t_entry = 0.f;
+    if (!intersect_box(nodes_[0], ray.origin, inv_dir, ret.t, t_entry)) {
+        return RayHit{};
+    }
+
+    // far children still to visit, with their entry distance
+    auto stack = std::array<std::pair<uint32_t, float>, max_depth>{};
+    auto stack_size = size_t{0};
+    auto node_idx = uint32_t{0};
+    while (true) {
+        const auto& node = nodes_[node_idx];
+        if (node.is_leaf()) {
+            auto block_count = (node.count + 3)/4;
+            for (auto b=node.first; b<node.first+block_count; ++b) {
+                const auto& block = blocks_[b];
+                auto hits = intersect_triangles(
+                    origin, dir, Vec3x4::load(block.v0), Vec3x4::load(block.e1), Vec3x4::load(block.e2), Float4(ret.t)
+                );
+                if (!hits.mask.any()) {
+                    continue;
+                }
+                float t[4], u[4], v[4];
+                hits.t.store(t);
+                hits.u.store(u);
+                hits.v.store(v);
+                auto bits = hits.mask.bits();
+                for (size_t lane=0; lane<4; ++lane) {
+                    if ((bits & (1 << lane)) && (t[lane] < ret.t)) {
+                        ret = RayHit{t[lane], triangle_ids_[4*b + lane], u[lane], v[lane]};
+                    }
+                }
+            }
+        } else {
+            auto t_left = 0.f;
+            auto t_right = 0.f;
+            auto hit_left = intersect_box(nodes_[node.first], ray.origin, inv_dir, ret.t, t_left);
+            auto hit_right = intersect_box(nodes_[node.first+1], ray.origin, inv_dir, ret.t, t_right);
+            if (hit_left && hit_right) {
+                auto left_first = t_left <= t_right;
+                stack[stack_size++] = left_first ? std::make_pair(node.first+1, t_right) : std::make_pair(node.first, t_left);
+                node_idx = left_first ? node.first : node.first+1;
+                continue;
+            }
+            if (hit_left || hit_right) {
+                node_idx = hit_left ? node.first : node.first+1;
+                continue;
+            }
+        }
+
+        // skip nodes behind the closest hit found since they were pushed
+        while ((stack_size > 0) && (stack[stack_size-1].second > ret.t)) {
+            --stack_size;
+        }
+        if (stack_size == 0) {
+            break;
+        }
+        node_idx = stack[--stack_size].first;
+    }
+
+    if (ret.triangle == RayHit::no_triangle) {
+        return RayHit{};
+    }
+    return ret;
+}
+
+std::array<RayHit, ray_packet_size>
+Bvh::intersect(std::span<const Ray, ray_packet_size> rays) const noexcept {
+    auto ret = std::array<RayHit, ray_packet_size>{};
+    if (triangle_count_ == 0) {
+        return ret;
+    }
+
+    float soa[9][4];
+    for (size_t r=0; r<ray_packet_size; ++r) {
+        for (int c=0; c<3; ++c) {
+            soa[c][r] = rays[r].origin[c];
+            soa[3+c][r] = rays[r].dir[c];
+            soa[6+c][r] = safe_inverse(rays[r].dir[c]);
+        }
+    }
+    auto origin = Vec3x4{Float4::load(soa[0]), Float4::load(soa[1]), Float4::load(soa[2])};
+    auto dir = Vec3x4{Float4::load(soa[3]), Float4::load(soa[4]), Float4::load(soa[5])};
+    auto inv_dir = Vec3x4{Float4::load(soa[6]), Float4::load(soa[7]), Float4::load(soa[8])};
+    float t_max[4];
+    for (size_t r=0; r<ray_packet_size; ++r) {
+        t_max[r] = rays[r].t_max;
+    }
+    auto t_best = Float4::load(t_max);
+
+    auto hits_box = [&](const Node& node) {
+        auto t1 = Vec3x4::broadcast(node.lo) - origin;
+        auto t2 = Vec3x4::broadcast(node.hi) - origin;
+        auto x1 = t1.x*inv_dir.x, x2 = t2.x*inv_dir.x;
+        auto y1 = t1.y*inv_dir.y, y2 = t2.y*inv_dir.y;
+        auto z1 = t1.z*inv_dir.z, z2 = t2.z*inv_dir.z;
+        auto t_entry = simd::max(simd::max(simd::min(x1, x2), simd::min(y1, y2)), simd::max(simd::min(z1, z2), Float4(0.f)));
+        auto t_exit = simd::min(simd::min(simd::max(x1, x2), simd::max(y1, y2)), simd::min(simd::max(z1, z2), t_best));
+        return (t_entry <= t_exit).any();
+    };
+
+    // the packet's rays are assumed to point roughly the same way, so the
+    // first ray decides the order of the children
+    auto first_dir = rays[0].dir;
+
+    auto stack = std::array<uint32_t, max_depth+1>{};
+    auto stack_size = size_t{0};
+    stack[stack_size++] = 0;
+    while (stack_size > 0) {
+        const auto& node = nodes_[stack[--stack_size]];
+        if (!hits_box(node)) {
+            continue;
+        }
+        if (!node.is_leaf()) {
+            const auto& left = nodes_[node.first];
+            const auto& right = nodes_[node.first+1];
+            auto left_first = glm::dot((right.lo+right.hi) - (left.lo+left.hi), first_dir) >= 0.f;
+            stack[stack_size++] = left_first ? node.first+1 : node.first;
+            stack[stack_size++] = left_first ? node.first : node.first+1;
+            continue;
+        }
+
+        for (uint32_t i=0; i<node.count; ++i) {
+            const auto& block = blocks_[node.first + i/4];
+            auto lane = i%4;
+            auto hits = intersect_triangles(
+                origin,
+                dir,
+                Vec3x4{Float4(block.v0[0][lane]), Float4(block.v0[1][lane]), Float4(block.v0[2][lane])},
+                Vec3x4{Float4(block.e1[0][lane]), Float4(block.e1[1][lane]), Float4(block.e1[2][lane])},
+                Vec3x4{Float4(block.e2[0][lane]), Float4(block.e2[1][lane]), Float4(block.e2[2][lane])},
+                t_best
+            );
+            if (!hits.mask.any()) {
+                continue;
+            }
+            t_best = simd::select(hits.mask, hits.t, t_best);
+            float t[4], u[4], v[4];
+            hits.t.store(t);
+            hits.u.store(u);
+            hits.v.store(v);
+            auto bits = hits.mask.bits();
+            auto tri = triangle_ids_[4*node.first + i];
+            for (size_t r=0; r<ray_packet_size; ++r) {
+                if (bits & (1 << r)) {
+                    ret[r] = RayHit{t[r], tri, u[r], v[r]};
+                }
+            }
+        }
+    }
+    return ret;
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "bounds.h"
+#include "mesh.h"
+#include "scene.h"
+
+struct Ray {
+    glm::vec3 origin;
+    // does not need to be normalized, hit distances are in units of `dir`
+    glm::vec3 dir;
+    float t_max = std::numeric_limits<float>::infinity();
+};
+
+struct RayHit {
+    static constexpr uint32_t no_triangle = std::numeric_limits<uint32_t>::max();
+
+    explicit operator bool() const noexcept {
+        return triangle != no_triangle;
+    }
+
+    float t = std::numeric_limits<float>::infinity();
+    // index of the triangle in the mesh's index data, i.e. first index / 3
+    uint32_t triangle = no_triangle;
+    // barycentrics of the hit point relative to the 2nd and 3rd vertex
+    float u = 0.f;
+    float v = 0.f;
+};
+
+// rays traced together by the packet query, one per SIMD lane
+inline constexpr size_t ray_packet_size = 4;
+
+struct BvhSettings {
+    // nodes with more triangles are always split
+    uint32_t max_leaf_size = 8;
+    // SAH split candidates per axis
+    uint32_t bin_count = 16;
+    // cost of visiting a node relative to testing a block of 4 triangles
+    float traversal_cost = 1.f;
+};
+
+// Bounding volume hierarchy over the triangles of a mesh for CPU ray
+// queries (picking, focusing). Built with the binned surface area heuristic;
+// leaves store their triangles in blocks of 4, tested with one SIMD
+// ray/triangle test per block.
+class Bvh {
+    public:
+        // Flattened node, children of inner nodes are adjacent, at `first`
+        // and `first+1`. Leaves have `count > 0` and hold `count` triangles
+        // starting at block `first`.
+        struct Node {
+            bool is_leaf() const noexcept {
+                return count > 0;
+            }
+
+            glm::vec3 lo;
+            uint32_t first;
+            glm::vec3 hi;
+            uint32_t count;
+        };
+        static_assert(sizeof(Node) == 32);
+
+        Bvh(std::span<const glm::vec3> positions, std::span<const uint32_t> indices, const BvhSettings& settings = {});
+
+        template <typename VertexT>
+        explicit Bvh(MeshView<VertexT> mesh, const BvhSettings& settings = {}) :
+            Bvh(positions_of(mesh.vertex_data), mesh.index_data, settings) {}
+
+        RayHit intersect(const Ray& ray) const noexcept;
+        // Traces all rays of the packet together, which pays off for coherent
+        // rays, e.g. neighboring pixels. Same results as single queries.
+        std::array<RayHit, ray_packet_size> intersect(std::span<const Ray, ray_packet_size> rays) const noexcept;
+
+        std::span<const Node> nodes() const noexcept {
+            return nodes_;
+        }
+
+        size_t triangle_count() const noexcept {
+            return triangle_count_;
+        }
+
+        BoundingBox bounds() const noexcept {
+            return BoundingBox{nodes_[0].lo, nodes_[0].hi};
+        }
+
+        // limits the traversal stack, deeper nodes are turned into leaves
+        static constexpr size_t max_depth = 64;
+
+        // 4 triangles as SoA: first vertex and both edges starting at it,
+        // [component][lane]. Unused lanes are degenerate and never hit.
+        struct TriangleBlock {
+            float v0[3][4];
+            float e1[3][4];
+            float e2[3][4];
+        };
+    private:
+        template <typename VertexT>
+        static std::vector<glm::vec3> positions_of(std::span<const VertexT> vertices) {
+            auto ret = std::vector<glm::vec3>{};
+            ret.reserve(vertices.size());
+            for (const auto& vert : vertices) {
+                ret.push_back(vert.pos);
+            }
+            return ret;
+        }
+
+        std::vector<Node> nodes_;
+        std::vector<TriangleBlock> blocks_;
+        // per block lane, RayHit::no_triangle for unused lanes
+        std::vector<uint32_t> triangle_ids_;
+        size_t triangle_count_ = 0;
+};
+
+// Ray through `ndc` ([-1, 1], y up) on the near plane of `cam`.
+inline Ray camera_ray(const Camera& cam, glm::vec2 ndc) noexcept {
+    auto ccs = cam.local_ccs();
+    auto tan_half_fov = std::tan(glm::radians(cam.fov)*.5f);
+    auto dir = ccs.e_z + ccs.e_y*(ndc.x*tan_half_fov*cam.aspect) + ccs.e_x*(ndc.y*tan_half_fov);
+    return Ray{cam.pos, glm::normalize(dir)};
+}
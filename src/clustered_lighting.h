@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <span>
+
+#include <glm/glm.hpp>
+#include <GL/glew.h>
+
+#include "buffer.h"
+#include "gl_state.h"
+#include "light_clusters.h"
+#include "renderer.h"
+#include "scene.h"
+#include "uniform_blocks.h"
+
+// Clustered forward shading: a compute pass bins the point lights of `Scene`
+// into the clusters of a `ClusterGrid` each frame, so forward programs loop
+// over the few lights of their fragment's cluster only, see
+// res/clustered.frag.glsl. Unlike `DeferredShading` it keeps MSAA and
+// blending working.
+//
+// The program `assign_program` has to be added to the renderer's
+// `ShaderManager`, see res/cluster_lights.comp.glsl.
+class ClusteredLighting {
+    public:
+        static constexpr const char* assign_program = "cluster_lights";
+        // of the buffers in res/cluster*.glsl
+        static constexpr GLuint point_light_binding = 1;
+        static constexpr GLuint light_count_binding = 2;
+        static constexpr GLuint light_index_binding = 3;
+        // local_size_x of res/cluster_lights.comp.glsl
+        static constexpr uint32_t workgroup_size = 128;
+        // lights beyond are dropped from the cluster
+        static constexpr uint32_t max_cluster_lights = 128;
+
+        explicit ClusteredLighting(Renderer& renderer, glm::uvec3 grid_size = ClusterGrid::default_size) :
+                renderer_{renderer},
+                grid_size_{grid_size} {
+            auto clusters = size_t{grid_size.x}*grid_size.y*grid_size.z;
+            light_counts_.set_data(nullptr, clusters*sizeof(uint32_t), GL_DYNAMIC_COPY);
+            light_indices_.set_data(nullptr, clusters*max_cluster_lights*sizeof(uint32_t), GL_DYNAMIC_COPY);
+        }
+
+        // Bins the point lights of `scene` into the clusters of its camera
+        // and binds the result for the draws of this frame. Needs the `Frame`
+        // uniform block of this frame. Returns false while the program isn't
+        // loaded yet.
+        bool assign_lights(const Scene& scene) {
+            auto hndl = renderer_.shader_manager().find(assign_program);
+            if (!hndl) {
+                return false;
+            }
+
+            auto grid = ClusterGrid::from_camera(scene.cam, grid_size_);
+            auto dim = renderer_.get_viewport_dim();
+            assert(scene.point_lights.size() < UINT32_MAX);
+            renderer_.set_uniform_block(ClusterUniforms::from_grid(
+                grid,
+                glm::vec2(static_cast<float>(dim.width), static_cast<float>(dim.height)),
+                static_cast<uint32_t>(scene.point_lights.size()),
+                max_cluster_lights));
+
+            // no lights are read for an empty list, the counts are all 0
+            renderer_.set_storage_block(point_light_binding, std::span(scene.point_lights));
+            auto& state = gl_state();
+            state.bind_buffer_base(BufferType::ShaderStorage, light_count_binding, light_counts_.handle());
+            state.bind_buffer_base(BufferType::ShaderStorage, light_index_binding, light_indices_.handle());
+
+            renderer_.shader_manager().get(*hndl).use();
+            auto groups = (grid.cluster_count() + workgroup_size - 1)/workgroup_size;
+            glDispatchCompute(static_cast<GLuint>(groups), 1, 1);
+            // the fragment shaders read what the dispatch wrote
+            glMemoryBarrier(GL_SHADER_STORAGE_BARRIER_BIT);
+            return true;
+        }
+
+        glm::uvec3 grid_size() const noexcept {
+            return grid_size_;
+        }
+    private:
+        Renderer& renderer_;
+        glm::uvec3 grid_size_;
+        // per cluster
+        Buffer<BufferType::ShaderStorage> light_counts_;
+        // per cluster, `max_cluster_lights` each
+        Buffer<BufferType::ShaderStorage> light_indices_;
+};
@@ -0,0 +1,142 @@
+#include "cpu_profiler.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <utility>
+
+namespace {
+
+std::atomic<uint64_t> next_profiler_id{1};
+
+void
+write_escaped(std::ostream& os, const char* str) {
+    for (; *str; ++str) {
+        auto c = *str;
+        if (c == '"' || c == '\\') {
+            os << '\\' << c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+        } else {
+            os << c;
+        }
+    }
+}
+
+// trace_event times are in microseconds
+void
+write_us(std::ostream& os, uint64_t ns) {
+    os << ns/1000 << '.' << std::setw(3) << std::setfill('0') << ns%1000;
+}
+
+}
+
+CpuProfiler::CpuProfiler() : id_{next_profiler_id.fetch_add(1)}, start_{clock::now()} {}
+
+CpuProfiler::ThreadBuffer&
+CpuProfiler::thread_buffer() {
+    // a thread rarely records into more than one profiler
+    thread_local auto buffers = std::vector<std::pair<uint64_t, ThreadBuffer*>>{};
+    for (auto [id, buffer] : buffers) {
+        if (id == id_) {
+            return *buffer;
+        }
+    }
+
+    auto lock = std::scoped_lock(mtx_);
+    auto& buffer = threads_.emplace_back(std::make_unique<ThreadBuffer>());
+    buffers.emplace_back(id_, buffer.get());
+    return *buffer;
+}
+
+void
+CpuProfiler::record(const char* name, uint64_t begin_ns, uint64_t end_ns) noexcept {
+    auto& buffer = thread_buffer();
+    auto idx = buffer.head.load(std::memory_order_relaxed);
+    // a reader seeing any of the stores below also sees the head before them
+    std::atomic_thread_fence(std::memory_order_release);
+    auto& slot = buffer.slots[idx % ring_size];
+    slot.name.store(name, std::memory_order_relaxed);
+    slot.begin_ns.store(begin_ns, std::memory_order_relaxed);
+    slot.end_ns.store(end_ns, std::memory_order_relaxed);
+    buffer.head.store(idx + 1, std::memory_order_release);
+}
+
+void
+CpuProfiler::mark_frame() noexcept {
+    auto frame = frame_count_.load(std::memory_order_relaxed);
+    frame_starts_[frame % max_frames].store(now_ns(), std::memory_order_relaxed);
+    frame_count_.store(frame + 1, std::memory_order_release);
+}
+
+std::vector<std::vector<CpuProfiler::Event>>
+CpuProfiler::collect(size_t frame_count) const {
+    auto cutoff_ns = uint64_t{0};
+    auto frames = frame_count_.load(std::memory_order_acquire);
+    if (frame_count > 0 && frames > 0) {
+        auto n = std::min<uint64_t>({frame_count, frames, max_frames});
+        cutoff_ns = frame_starts_[(frames - n) % max_frames].load(std::memory_order_relaxed);
+    }
+
+    auto lock = std::scoped_lock(mtx_);
+    auto ret = std::vector<std::vector<Event>>{};
+    ret.reserve(threads_.size());
+    for (auto& buffer : threads_) {
+        auto& events = ret.emplace_back();
+        auto head = buffer->head.load(std::memory_order_acquire);
+        auto first = head > ring_size ? head - ring_size : 0;
+        events.reserve(static_cast<size_t>(head - first));
+        for (auto i=first; i<head; ++i) {
+            auto& slot = buffer->slots[i % ring_size];
+            events.push_back(Event{
+                slot.name.load(std::memory_order_relaxed),
+                slot.begin_ns.load(std::memory_order_relaxed),
+                slot.end_ns.load(std::memory_order_relaxed)
+            });
+        }
+
+        // the slots of everything written meanwhile, and of the event being
+        // written now, can't be trusted
+        std::atomic_thread_fence(std::memory_order_acquire);
+        auto new_head = buffer->head.load(std::memory_order_relaxed);
+        auto valid = new_head + 1 > ring_size ? new_head + 1 - ring_size : 0;
+        if (valid > first) {
+            auto overwritten = static_cast<size_t>(std::min<uint64_t>(valid - first, events.size()));
+            events.erase(events.begin(), events.begin() + static_cast<std::ptrdiff_t>(overwritten));
+        }
+        std::erase_if(events, [cutoff_ns](const Event& ev) { return ev.end_ns < cutoff_ns; });
+    }
+    return ret;
+}
+
+void
+CpuProfiler::write_trace(std::ostream& os, size_t frame_count) const {
+    auto threads = collect(frame_count);
+    auto is_first = true;
+    os << "{\"traceEvents\":[";
+    for (size_t tid=0; tid<threads.size(); ++tid) {
+        for (auto& ev : threads[tid]) {
+            os << (is_first ? "\n" : ",\n");
+            is_first = false;
+            os << "{\"name\":\"";
+            write_escaped(os, ev.name);
+            os << "\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":0,\"tid\":" << tid << ",\"ts\":";
+            write_us(os, ev.begin_ns);
+            os << ",\"dur\":";
+            write_us(os, ev.end_ns - ev.begin_ns);
+            os << '}';
+        }
+    }
+    os << "\n],\"displayTimeUnit\":\"ns\"}\n";
+}
+
+bool
+CpuProfiler::write_trace(const std::filesystem::path& fpath, size_t frame_count) const {
+    auto file = std::ofstream(fpath);
+    if (!file) {
+        return false;
+    }
+    write_trace(file, frame_count);
+    file.flush();
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+// Scoped CPU zones with nanosecond timestamps. Every thread writes the zones
+// it closes into a ring buffer of its own without locking; only the first
+// zone of a thread takes a lock to register the buffer. The recorded frames
+// can be written as Chrome trace_event JSON, for chrome://tracing or Perfetto.
+class CpuProfiler {
+    public:
+        // per thread, older zones are overwritten
+        static constexpr size_t ring_size = 64*1024;
+        static constexpr size_t max_frames = 1024;
+
+        struct Event {
+            // a string literal, or at least alive until the trace is written
+            const char* name;
+            uint64_t begin_ns;
+            uint64_t end_ns;
+        };
+
+        class [[nodiscard]] Zone {
+            public:
+                Zone(CpuProfiler& profiler, const char* name) noexcept :
+                    profiler_{profiler}, name_{name}, begin_ns_{profiler.now_ns()} {}
+                ~Zone() {
+                    profiler_.record(name_, begin_ns_, profiler_.now_ns());
+                }
+                Zone(const Zone&) = delete;
+                Zone& operator=(const Zone&) = delete;
+            private:
+                CpuProfiler& profiler_;
+                const char* name_;
+                uint64_t begin_ns_;
+        };
+
+        CpuProfiler();
+        CpuProfiler(const CpuProfiler&) = delete;
+        CpuProfiler& operator=(const CpuProfiler&) = delete;
+
+        Zone zone(const char* name) noexcept {
+            return Zone(*this, name);
+        }
+
+        // since construction
+        uint64_t now_ns() const noexcept {
+            return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start_).count());
+        }
+
+        void record(const char* name, uint64_t begin_ns, uint64_t end_ns) noexcept;
+
+        // start of a frame, called by one thread
+        void mark_frame() noexcept;
+
+        // The zones that ended after the start of the `frame_count`th last
+        // frame, or all of them for 0, per thread, oldest first. Zones being
+        // overwritten while copying are left out.
+        std::vector<std::vector<Event>> collect(size_t frame_count) const;
+
+        void write_trace(std::ostream& os, size_t frame_count) const;
+        // false if the file can't be written
+        bool write_trace(const std::filesystem::path& fpath, size_t frame_count) const;
+    private:
+        using clock = std::chrono::steady_clock;
+
+        // atomics, so the writer may overwrite a slot while it is read
+        struct Slot {
+            std::atomic<const char*> name{nullptr};
+            std::atomic<uint64_t> begin_ns{0};
+            std::atomic<uint64_t> end_ns{0};
+        };
+
+        struct ThreadBuffer {
+            std::unique_ptr<Slot[]> slots = std::make_unique<Slot[]>(ring_size);
+            // number of events ever written
+            std::atomic<uint64_t> head{0};
+        };
+
+        ThreadBuffer& thread_buffer();
+
+        // tells thread local buffers of different profilers apart
+        uint64_t id_;
+        clock::time_point start_;
+        // guards `threads_`, not the buffers
+        mutable std::mutex mtx_;
+        std::vector<std::unique_ptr<ThreadBuffer>> threads_;
+        std::array<std::atomic<uint64_t>, max_frames> frame_starts_ = {};
+        std::atomic<uint64_t> frame_count_{0};
+};
+
+// the profiler of the application, usable from any thread
+inline CpuProfiler&
+cpu_profiler() noexcept {
+    static auto profiler = CpuProfiler{};
+    return profiler;
+}
@@ -0,0 +1,117 @@
+#include "culling.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include "simd.h"
+
+Frustum
+Frustum::from_matrix(const glm::mat4& view_proj) noexcept {
+    // glm is column major, m[c][r]
+    auto row = [&](int r) {
+        return glm::vec4(view_proj[0][r], view_proj[1][r], view_proj[2][r], view_proj[3][r]);
+    };
+    auto ret = Frustum{};
+    ret.planes[Left] = row(3) + row(0);
+    ret.planes[Right] = row(3) - row(0);
+    ret.planes[Bottom] = row(3) + row(1);
+    ret.planes[Top] = row(3) - row(1);
+    ret.planes[Near] = row(3) + row(2);
+    ret.planes[Far] = row(3) - row(2);
+    for (auto& plane : ret.planes) {
+        plane /= glm::length(glm::vec3(plane));
+    }
+    return ret;
+}
+
+size_t
+BoundsList::push_back(const BoundingBox& box, const BoundingSphere& sphere) {
+    auto idx = size_++;
+    if (idx % 4 == 0) {
+        for (auto& comp : sphere_) {
+            comp.resize(comp.size() + 4, 0.f);
+        }
+        for (int c=0; c<3; ++c) {
+            box_lo_[c].resize(box_lo_[c].size() + 4, 0.f);
+            box_hi_[c].resize(box_hi_[c].size() + 4, 0.f);
+        }
+    }
+    set(idx, box, sphere);
+    return idx;
+}
+
+void
+BoundsList::set(size_t idx, const BoundingBox& box, const BoundingSphere& sphere) noexcept {
+    assert(idx < size_);
+    for (int c=0; c<3; ++c) {
+        sphere_[c][idx] = sphere.center[c];
+        box_lo_[c][idx] = box.lo[c];
+        box_hi_[c][idx] = box.hi[c];
+    }
+    sphere_[3][idx] = sphere.radius;
+}
+
+size_t
+BoundsList::cull(const Frustum& frustum, std::span<uint8_t> visible) const noexcept {
+    using simd::Float4;
+    assert(visible.size() >= size_);
+
+    auto ret = size_t{0};
+    for (size_t i=0; i<size_; i+=4) {
+        auto cx = Float4::load(&sphere_[0][i]);
+        auto cy = Float4::load(&sphere_[1][i]);
+        auto cz = Float4::load(&sphere_[2][i]);
+        auto neg_radius = Float4(0.f) - Float4::load(&sphere_[3][i]);
+        const Float4 lo[3] = {Float4::load(&box_lo_[0][i]), Float4::load(&box_lo_[1][i]), Float4::load(&box_lo_[2][i])};
+        const Float4 hi[3] = {Float4::load(&box_hi_[0][i]), Float4::load(&box_hi_[1][i]), Float4::load(&box_hi_[2][i])};
+
+        auto inside = ~0;
+        for (const auto& plane : frustum.planes) {
+            auto dist = Float4(plane.x)*cx + Float4(plane.y)*cy + Float4(plane.z)*cz + Float4(plane.w);
+            // the corner of the box furthest along the plane normal
+            auto px = (plane.x > 0.f) ? hi[0] : lo[0];
+            auto py = (plane.y > 0.f) ? hi[1] : lo[1];
+            auto pz = (plane.z > 0.f) ? hi[2] : lo[2];
+            auto box_dist = Float4(plane.x)*px + Float4(plane.y)*py + Float4(plane.z)*pz + Float4(plane.w);
+            inside &= ((dist >= neg_radius) & (box_dist >= Float4(0.f))).bits();
+            if (inside == 0) {
+                break;
+            }
+        }
+
+        auto lanes = std::min<size_t>(4, size_-i);
+        for (size_t lane=0; lane<lanes; ++lane) {
+            visible[i+lane] = static_cast<uint8_t>((inside >> lane) & 1);
+            ret += visible[i+lane];
+        }
+    }
+    return ret;
+}
+
+size_t
+BoundsList::cull_scalar(const Frustum& frustum, std::span<uint8_t> visible) const noexcept {
+    assert(visible.size() >= size_);
+
+    auto ret = size_t{0};
+    for (size_t i=0; i<size_; ++i) {
+        auto center = glm::vec3(sphere_[0][i], sphere_[1][i], sphere_[2][i]);
+        auto lo = glm::vec3(box_lo_[0][i], box_lo_[1][i], box_lo_[2][i]);
+        auto hi = glm::vec3(box_hi_[0][i], box_hi_[1][i], box_hi_[2][i]);
+        auto inside = true;
+        for (const auto& plane : frustum.planes) {
+            auto normal = glm::vec3(plane);
+            auto corner = glm::vec3(
+                (plane.x > 0.f) ? hi.x : lo.x,
+                (plane.y > 0.f) ? hi.y : lo.y,
+                (plane.z > 0.f) ? hi.z : lo.z
+            );
+            if ((glm::dot(normal, center) + plane.w < -sphere_[3][i]) || (glm::dot(normal, corner) + plane.w < 0.f)) {
+                inside = false;
+                break;
+            }
+        }
+        visible[i] = inside ? 1 : 0;
+        ret += visible[i];
+    }
+    return ret;
+}
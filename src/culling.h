@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "bounds.h"
+#include "scene.h"
+
+// Planes of a view frustum as (normal, distance), points `p` with
+// `dot(normal, p) + distance >= 0` are inside. Normals are unit length, so
+// the plane equation gives the signed distance.
+struct Frustum {
+    enum Plane : size_t { Left, Right, Bottom, Top, Near, Far };
+
+    // Gribb/Hartmann plane extraction from an OpenGL style (clip z in
+    // [-w, w]) view projection matrix
+    static Frustum from_matrix(const glm::mat4& view_proj) noexcept;
+
+    static Frustum from_camera(const Camera& cam) noexcept {
+        return from_matrix(cam.get_proj_matrix()*cam.get_view_matrix());
+    }
+
+    std::array<glm::vec4, 6> planes;
+};
+
+struct CullStats {
+    size_t culled = 0;
+    size_t drawn = 0;
+};
+
+// Bounds of many objects in SoA layout, so the frustum test runs on 4
+// objects per iteration. Every object has a sphere and a box: the sphere
+// test is cheap and rejects most invisible objects, the box test catches
+// elongated objects the sphere overestimates.
+class BoundsList {
+    public:
+        size_t size() const noexcept {
+            return size_;
+        }
+
+        // returns the index of the object
+        size_t push_back(const BoundingBox& box, const BoundingSphere& sphere);
+        // replaces the bounds of object `idx`
+        void set(size_t idx, const BoundingBox& box, const BoundingSphere& sphere) noexcept;
+
+        // Sets `visible[i]` to 1 for every object intersecting `frustum`, to 0
+        // for the others. Objects close to a frustum corner may be reported
+        // visible although they are not. Returns the number of visible objects.
+        size_t cull(const Frustum& frustum, std::span<uint8_t> visible) const noexcept;
+        // portable implementation of `cull`
+        size_t cull_scalar(const Frustum& frustum, std::span<uint8_t> visible) const noexcept;
+
+    private:
+        // padded to a multiple of 4 with empty objects
+        std::vector<float> sphere_[4];   // center x, y, z, radius
+        std::vector<float> box_lo_[3];
+        std::vector<float> box_hi_[3];
+        size_t size_ = 0;
+};
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <cassert>
+#include <climits>
+#include <cstddef>
+#include <span>
+
+#include <glm/glm.hpp>
+#include <GL/glew.h>
+
+#include "buffer.h"
+#include "framebuffer.h"
+#include "gl_state.h"
+#include "mesh.h"
+#include "renderer.h"
+#include "scene.h"
+#include "uniform_blocks.h"
+
+// Lights the scene after drawing it. The geometry pass writes albedo,
+// octahedral normals and specularity into a G-buffer, see res/gbuffer.frag.glsl.
+// The lighting passes then shade each pixel once for the ambient and diffuse
+// light of `Scene`, and once more for every point light whose volume (a
+// sphere) covers it. The cost grows with lit pixels instead of objects times
+// lights.
+//
+// The programs `ambient_program` and `point_program` have to be added to the
+// renderer's `ShaderManager`, see res/deferred*.glsl.
+class DeferredShading {
+    public:
+        static constexpr const char* ambient_program = "deferred_ambient";
+        static constexpr const char* point_program = "deferred_point";
+        // of the `PointLight` array in res/deferred_point.*.glsl
+        static constexpr GLuint point_light_binding = 1;
+
+        // color attachments of the G-buffer
+        enum Target : size_t {
+            Albedo,
+            NormalSpec,
+        };
+
+        explicit DeferredShading(Renderer& renderer) :
+                renderer_{renderer},
+                gbuffer_{1, 1, {GL_RGBA8, GL_RGBA16F}},
+                light_buffer_{1, 1, {GL_RGBA16F}} {
+            glGenVertexArrays(1, &screen_vao_);
+
+            auto sphere = generate_icosphere(1);
+            glGenVertexArrays(1, &volume_vao_);
+            gl_state().bind_vertex_array(volume_vao_);
+            volume_vbo_.bind();
+            volume_vbo_.set_data(sphere.vertex_data.data(), sphere.vertex_data.size()*sizeof(Vertex), GL_STATIC_DRAW);
+            volume_ibo_.bind();
+            volume_ibo_.set_data(sphere.index_data.data(), sphere.index_data.size()*sizeof(uint32_t), GL_STATIC_DRAW);
+            // location 0 in res/deferred_point.vert.glsl
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), reinterpret_cast<const void*>(offsetof(Vertex, pos)));
+            glEnableVertexAttribArray(0);
+            assert(sphere.index_data.size() < INT_MAX);
+            volume_index_count_ = static_cast<GLsizei>(sphere.index_data.size());
+        }
+
+        DeferredShading(const DeferredShading&) = delete;
+        DeferredShading& operator=(const DeferredShading&) = delete;
+
+        ~DeferredShading() {
+            gl_state().forget_vertex_array(screen_vao_);
+            gl_state().forget_vertex_array(volume_vao_);
+            glDeleteVertexArrays(1, &screen_vao_);
+            glDeleteVertexArrays(1, &volume_vao_);
+        }
+
+        // Binds and clears the G-buffer, sized like the window. Draws up to
+        // `light` have to write it like res/gbuffer.frag.glsl. The framebuffer
+        // bound before, e.g. an offscreen target, receives the lit image.
+        void begin_geometry() {
+            auto target = GLint{0};
+            glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &target);
+            target_fbo_ = static_cast<GLuint>(target);
+            auto dim = renderer_.get_viewport_dim();
+            gbuffer_.resize(dim.width, dim.height);
+            light_buffer_.resize(dim.width, dim.height);
+            gbuffer_.bind();
+            gl_state().set_depth_mask(true);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            // alpha would blend normals
+            gl_state().set_enabled(Capability::Blend, false);
+        }
+
+        // Lights the G-buffer and copies the result to the framebuffer that
+        // was bound before `begin_geometry`, which is bound afterwards. Needs
+        // the `Frame` and `Lights` uniform blocks of this frame. Returns false
+        // while the programs aren't loaded yet, the target is left as it was
+        // then.
+        bool light(const Scene& scene) {
+            auto& shaders = renderer_.shader_manager();
+            auto ambient_hndl = shaders.find(ambient_program);
+            auto point_hndl = shaders.find(point_program);
+            auto& state = gl_state();
+            if (!ambient_hndl || !point_hndl) {
+                glBindFramebuffer(GL_FRAMEBUFFER, target_fbo_);
+                state.set_enabled(Capability::Blend, true);
+                return false;
+            }
+
+            renderer_.set_uniform_block(DeferredUniforms::from_camera(
+                scene.cam,
+                glm::vec2(static_cast<float>(gbuffer_.width()), static_cast<float>(gbuffer_.height()))));
+            state.bind_texture(0, gbuffer_.color_texture(Albedo));
+            state.bind_texture(1, gbuffer_.color_texture(NormalSpec));
+            state.bind_texture(2, gbuffer_.depth_texture());
+
+            // the light volumes are depth tested against the scene, but the
+            // G-buffer can't be drawn to while it's sampled
+            gbuffer_.blit_depth(light_buffer_);
+            light_buffer_.bind();
+            glClear(GL_COLOR_BUFFER_BIT);
+            state.set_depth_mask(false);
+
+            state.set_enabled(Capability::DepthTest, false);
+            const auto& ambient = shaders.get(*ambient_hndl);
+            ambient.use();
+            set_gbuffer_samplers(ambient);
+            state.bind_vertex_array(screen_vao_);
+            glDrawArrays(GL_TRIANGLES, 0, 3);
+
+            if (!scene.point_lights.empty()) {
+                renderer_.set_storage_block(point_light_binding, std::span(scene.point_lights));
+
+                // The back faces of each volume, where they are behind the
+                // scene: only pixels in front of them can be lit. Clamped
+                // so volumes reaching past the far plane still count.
+                state.set_enabled(Capability::DepthTest, true);
+                state.set_depth_func(GL_GEQUAL);
+                state.set_enabled(Capability::DepthClamp, true);
+                state.set_cull_face(GL_FRONT);
+                state.set_enabled(Capability::Blend, true);
+                state.set_blend_func(GL_ONE, GL_ONE);
+
+                const auto& point = shaders.get(*point_hndl);
+                point.use();
+                set_gbuffer_samplers(point);
+                state.bind_vertex_array(volume_vao_);
+                assert(scene.point_lights.size() < INT_MAX);
+                glDrawElementsInstanced(
+                    GL_TRIANGLES,
+                    volume_index_count_,
+                    GL_UNSIGNED_INT,
+                    nullptr,
+                    static_cast<GLsizei>(scene.point_lights.size()));
+
+                state.set_depth_func(GL_LESS);
+                state.set_enabled(Capability::DepthClamp, false);
+                state.set_cull_face(GL_BACK);
+            }
+
+            // back to the state of `Renderer::init`
+            state.set_enabled(Capability::DepthTest, true);
+            state.set_enabled(Capability::Blend, true);
+            state.set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            state.set_depth_mask(true);
+
+            auto dim = renderer_.get_viewport_dim();
+            light_buffer_.blit_color(0, target_fbo_, dim.width, dim.height);
+            return true;
+        }
+
+        const Framebuffer& gbuffer() const noexcept {
+            return gbuffer_;
+        }
+    private:
+        static void set_gbuffer_samplers(const Program& prog) noexcept {
+            prog.set_uniform("g_albedo", GLint{0});
+            prog.set_uniform("g_normal_spec", GLint{1});
+            prog.set_uniform("g_depth", GLint{2});
+        }
+
+        Renderer& renderer_;
+        // `Target`s and depth
+        Framebuffer gbuffer_;
+        // the lit image, and a copy of the G-buffer's depth to test against
+        Framebuffer light_buffer_;
+        GLuint screen_vao_ = 0;
+        GLuint volume_vao_ = 0;
+        Buffer<BufferType::Array> volume_vbo_;
+        Buffer<BufferType::ElementArray> volume_ibo_;
+        GLsizei volume_index_count_ = 0;
+        // bound when `begin_geometry` was called
+        GLuint target_fbo_ = 0;
+};
@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "gl_state.h"
+#include "utils.h"
+
+// Offscreen render target whose color and depth attachments are 2D textures,
+// so later passes can sample them. While bound, everything drawn goes here
+// instead of the window.
+class Framebuffer {
+    struct FramebufferDeleter {
+        void operator()(GLuint hndl) const noexcept {
+            glDeleteFramebuffers(1, &hndl);
+        }
+    };
+    struct TextureDeleter {
+        void operator()(GLuint hndl) const noexcept {
+            gl_state().forget_texture(hndl);
+            glDeleteTextures(1, &hndl);
+        }
+    };
+    using UniqueFramebufferHandle = UniqueHandle<GLuint, FramebufferDeleter>;
+    using UniqueTextureHandle = UniqueHandle<GLuint, TextureDeleter>;
+
+    public:
+        // `color_formats` are the internal formats of the color attachments,
+        // in attachment order; all of them are drawn to
+        Framebuffer(
+                GLsizei width,
+                GLsizei height,
+                std::vector<GLenum> color_formats = {GL_RGBA8},
+                GLenum depth_format = GL_DEPTH_COMPONENT24) :
+            width_{width},
+            height_{height},
+            color_formats_{std::move(color_formats)},
+            depth_format_{depth_format} {
+            auto fbo = UniqueFramebufferHandle::value_type{};
+            glGenFramebuffers(1, &fbo);
+            fbo_.reset(fbo);
+            color_.reserve(color_formats_.size());
+            for (size_t i=0; i<color_formats_.size(); ++i) {
+                color_.emplace_back(make_texture());
+            }
+            depth_.reset(make_texture());
+            allocate();
+
+            glBindFramebuffer(GL_FRAMEBUFFER, fbo_.get());
+            auto draw_buffers = std::vector<GLenum>{};
+            for (size_t i=0; i<color_.size(); ++i) {
+                auto attachment = static_cast<GLenum>(GL_COLOR_ATTACHMENT0 + i);
+                glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, color_[i].get(), 0);
+                draw_buffers.push_back(attachment);
+            }
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, depth_.get(), 0);
+            glDrawBuffers(static_cast<GLsizei>(draw_buffers.size()), draw_buffers.data());
+            auto status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            if (status != GL_FRAMEBUFFER_COMPLETE) {
+                throw GLSBError("offscreen framebuffer incomplete");
+            }
+        }
+
+        // reallocates the attachments, their contents are undefined afterwards
+        void resize(GLsizei width, GLsizei height) {
+            if ((width == width_) && (height == height_)) {
+                return;
+            }
+            width_ = width;
+            height_ = height;
+            allocate();
+        }
+
+        void bind() const noexcept {
+            glBindFramebuffer(GL_FRAMEBUFFER, fbo_.get());
+        }
+
+        void unbind() const noexcept {
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        }
+
+        // copies the depth attachment to `dst`'s, which has the same size and format
+        void blit_depth(const Framebuffer& dst) const noexcept {
+            assert((dst.width_ == width_) && (dst.height_ == height_) && (dst.depth_format_ == depth_format_));
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo_.get());
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, dst.fbo_.get());
+            glBlitFramebuffer(0, 0, width_, height_, 0, 0, width_, height_, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        }
+
+        // copies color attachment `idx` to the framebuffer `dst_fbo` (0 for
+        // the window's), which is bound afterwards
+        void blit_color(size_t idx, GLuint dst_fbo, GLsizei dst_width, GLsizei dst_height) const noexcept {
+            assert(idx < color_.size());
+            glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo_.get());
+            glReadBuffer(static_cast<GLenum>(GL_COLOR_ATTACHMENT0 + idx));
+            glBindFramebuffer(GL_DRAW_FRAMEBUFFER, dst_fbo);
+            glBlitFramebuffer(0, 0, width_, height_, 0, 0, dst_width, dst_height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+            glBindFramebuffer(GL_FRAMEBUFFER, dst_fbo);
+        }
+
+        GLuint color_texture(size_t idx) const noexcept {
+            assert(idx < color_.size());
+            return color_[idx].get();
+        }
+
+        GLuint depth_texture() const noexcept {
+            return depth_.get();
+        }
+
+        GLsizei width() const noexcept {
+            return width_;
+        }
+
+        GLsizei height() const noexcept {
+            return height_;
+        }
+    private:
+        GLuint make_texture() const noexcept {
+            auto tex = UniqueTextureHandle::value_type{};
+            glGenTextures(1, &tex);
+            gl_state().bind_texture(0, tex);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            return tex;
+        }
+
+        void allocate() const noexcept {
+            // the format and type only describe the (missing) data
+            for (size_t i=0; i<color_.size(); ++i) {
+                gl_state().bind_texture(0, color_[i].get());
+                glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(color_formats_[i]), width_, height_, 0, GL_RGBA, GL_FLOAT, nullptr);
+            }
+            gl_state().bind_texture(0, depth_.get());
+            glTexImage2D(GL_TEXTURE_2D, 0, static_cast<GLint>(depth_format_), width_, height_, 0, GL_DEPTH_COMPONENT, GL_FLOAT, nullptr);
+        }
+
+        GLsizei width_;
+        GLsizei height_;
+        std::vector<GLenum> color_formats_;
+        GLenum depth_format_;
+        UniqueFramebufferHandle fbo_;
+        std::vector<UniqueTextureHandle> color_;
+        UniqueTextureHandle depth_;
+};
@@ -0,0 +1,201 @@
+#include "geometry_arena.h"
+
+#include <algorithm>
+#include <array>
+#include <span>
+#include <utility>
+
+namespace {
+
+// headroom kept after growing or compacting, so the next few meshes fit
+size_t
+grown_capacity(size_t capacity, size_t required) noexcept {
+    return std::max(capacity*2, required + required/2);
+}
+
+// Allocates through the copy target, binding an element array buffer would
+// change whichever vertex array is bound.
+template <BufferType Type>
+void
+allocate(const Buffer<Type>& buf, size_t capacity) {
+    assert((capacity < PTRDIFF_MAX));
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buf.handle());
+    glBufferData(GL_COPY_WRITE_BUFFER, static_cast<GLsizeiptr>(capacity), nullptr, GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+// Replaces `buf` by a new buffer of `capacity` bytes and copies the
+// (src, dst, size) ranges of `copies` over on the GPU.
+template <BufferType Type>
+void
+reallocate(Buffer<Type>& buf, size_t capacity, std::span<const std::array<size_t, 3>> copies) {
+    auto ret = Buffer<Type>{};
+    allocate(ret, capacity);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, ret.handle());
+    glBindBuffer(GL_COPY_READ_BUFFER, buf.handle());
+    for (const auto& [src_offset, dst_offset, size] : copies) {
+        if (size > 0) {
+            glCopyBufferSubData(
+                GL_COPY_READ_BUFFER,
+                GL_COPY_WRITE_BUFFER,
+                static_cast<GLintptr>(src_offset),
+                static_cast<GLintptr>(dst_offset),
+                static_cast<GLsizeiptr>(size));
+        }
+    }
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    // the old buffer is deleted with `ret`
+    std::swap(buf, ret);
+}
+
+}
+
+GeometryArena::GeometryArena(
+        size_t vertex_size,
+        std::vector<VertexDescriptor> vertex_desc,
+        const Program& prog,
+        size_t vertex_capacity,
+        size_t index_capacity) :
+            vertex_size_{vertex_size},
+            vertex_desc_{std::move(vertex_desc)},
+            prog_{prog},
+            vertices_{vertex_capacity},
+            indices_{index_capacity} {
+    glGenVertexArrays(1, &vao_);
+    allocate(vbo_, vertex_capacity*vertex_size_);
+    allocate(ibo_, index_capacity*sizeof(uint32_t));
+    set_attrib_pointers();
+}
+
+GeometryArena::~GeometryArena() {
+    gl_state().forget_vertex_array(vao_);
+    glDeleteVertexArrays(1, &vao_);
+}
+
+GeometryArena::range_id
+GeometryArena::add(const void* vertices, size_t vertex_count, std::span<const uint32_t> indices) {
+    auto alloc = [](RangeAllocator& allocator, size_t count, auto&& grow) {
+        if (count == 0) {
+            return size_t{0};
+        }
+        auto offset = allocator.allocate(count);
+        if (!offset) {
+            // the free space may be fragmented, only the range at the end grows
+            grow(grown_capacity(allocator.capacity(), allocator.capacity_for(count)));
+            offset = allocator.allocate(count);
+        }
+        assert(offset);
+        return *offset;
+    };
+    auto range = Range{
+        alloc(vertices_, vertex_count, [this](size_t cap) { grow_vertices(cap); }),
+        vertex_count,
+        alloc(indices_, indices.size(), [this](size_t cap) { grow_indices(cap); }),
+        indices.size()
+    };
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, vbo_.handle());
+    glBufferSubData(
+        GL_COPY_WRITE_BUFFER,
+        static_cast<GLintptr>(range.first_vertex*vertex_size_),
+        static_cast<GLsizeiptr>(vertex_count*vertex_size_),
+        vertices);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, ibo_.handle());
+    glBufferSubData(
+        GL_COPY_WRITE_BUFFER,
+        static_cast<GLintptr>(range.first_index*sizeof(uint32_t)),
+        static_cast<GLsizeiptr>(indices.size_bytes()),
+        indices.data());
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    if (!free_ids_.empty()) {
+        auto id = free_ids_.back();
+        free_ids_.pop_back();
+        ranges_[id] = range;
+        return id;
+    }
+    ranges_.push_back(range);
+    return static_cast<range_id>(ranges_.size()-1);
+}
+
+void
+GeometryArena::remove(range_id id) {
+    auto& range = ranges_[id];
+    vertices_.free(range.first_vertex, range.vertex_count);
+    indices_.free(range.first_index, range.index_count);
+    range = Range{0, 0, 0, 0};
+    free_ids_.push_back(id);
+}
+
+void
+GeometryArena::compact() {
+    // ranges in buffer order, so moving them to the front never overlaps
+    auto by_vertex = std::vector<range_id>(ranges_.size());
+    auto by_index = std::vector<range_id>(ranges_.size());
+    for (range_id i=0; i<ranges_.size(); ++i) {
+        by_vertex[i] = i;
+        by_index[i] = i;
+    }
+    std::sort(by_vertex.begin(), by_vertex.end(), [this](range_id a, range_id b) {
+        return ranges_[a].first_vertex < ranges_[b].first_vertex;
+    });
+    std::sort(by_index.begin(), by_index.end(), [this](range_id a, range_id b) {
+        return ranges_[a].first_index < ranges_[b].first_index;
+    });
+
+    auto vertex_copies = std::vector<std::array<size_t, 3>>{};
+    auto vertex_end = size_t{0};
+    for (auto id : by_vertex) {
+        auto& range = ranges_[id];
+        vertex_copies.push_back({range.first_vertex*vertex_size_, vertex_end*vertex_size_, range.vertex_count*vertex_size_});
+        range.first_vertex = vertex_end;
+        vertex_end += range.vertex_count;
+    }
+    auto index_copies = std::vector<std::array<size_t, 3>>{};
+    auto index_end = size_t{0};
+    for (auto id : by_index) {
+        auto& range = ranges_[id];
+        index_copies.push_back({range.first_index*sizeof(uint32_t), index_end*sizeof(uint32_t), range.index_count*sizeof(uint32_t)});
+        range.first_index = index_end;
+        index_end += range.index_count;
+    }
+
+    auto vertex_capacity = grown_capacity(0, vertex_end);
+    auto index_capacity = grown_capacity(0, index_end);
+    reallocate(vbo_, vertex_capacity*vertex_size_, vertex_copies);
+    reallocate(ibo_, index_capacity*sizeof(uint32_t), index_copies);
+    vertices_ = RangeAllocator(vertex_capacity);
+    vertices_.reset(vertex_end);
+    indices_ = RangeAllocator(index_capacity);
+    indices_.reset(index_end);
+    set_attrib_pointers();
+}
+
+void
+GeometryArena::set_attrib_pointers() {
+    gl_state().bind_vertex_array(vao_);
+    vbo_.bind();
+    for (const auto& desc : vertex_desc_) {
+        prog_.set_attrib_pointer(desc);
+    }
+    ibo_.bind();
+}
+
+void
+GeometryArena::grow_vertices(size_t capacity) {
+    auto size = vertices_.capacity()*vertex_size_;
+    auto copy = std::array<size_t, 3>{0, 0, size};
+    reallocate(vbo_, capacity*vertex_size_, std::span(&copy, 1));
+    vertices_.grow(capacity);
+    set_attrib_pointers();
+}
+
+void
+GeometryArena::grow_indices(size_t capacity) {
+    auto size = indices_.capacity()*sizeof(uint32_t);
+    auto copy = std::array<size_t, 3>{0, 0, size};
+    reallocate(ibo_, capacity*sizeof(uint32_t), std::span(&copy, 1));
+    indices_.grow(capacity);
+    set_attrib_pointers();
+}
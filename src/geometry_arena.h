@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "buffer.h"
+#include "mesh.h"
+#include "range_allocator.h"
+#include "shader.h"
+
+// Vertex and index data of many meshes of one vertex format in a single
+// vertex and a single index buffer behind one vertex array. Meshes get ranges
+// of both buffers from free lists and are drawn with a base vertex, so their
+// indices stay relative to the mesh. The buffers grow when full; `compact`
+// closes the gaps left by removed meshes.
+class GeometryArena {
+    public:
+        using range_id = uint32_t;
+
+        struct Range {
+            size_t first_vertex;
+            size_t vertex_count;
+            size_t first_index;
+            size_t index_count;
+        };
+
+        // `prog` provides the attribute locations, it has to outlive the arena
+        GeometryArena(
+            size_t vertex_size,
+            std::vector<VertexDescriptor> vertex_desc,
+            const Program& prog,
+            size_t vertex_capacity = 64*1024,
+            size_t index_capacity = 256*1024);
+
+        template <typename VertexT>
+        static GeometryArena for_format(const Program& prog) {
+            return GeometryArena(sizeof(VertexT), VertexT::get_vertex_desc(), prog);
+        }
+
+        GeometryArena(const GeometryArena&) = delete;
+        GeometryArena& operator=(const GeometryArena&) = delete;
+        ~GeometryArena();
+
+        template <typename VertexT>
+        range_id add(MeshView<VertexT> mesh) {
+            assert(sizeof(VertexT) == vertex_size_);
+            return add(mesh.vertex_data.data(), mesh.vertex_data.size(), mesh.index_data);
+        }
+        range_id add(const void* vertices, size_t vertex_count, std::span<const uint32_t> indices);
+        // the id may be handed out again by `add`
+        void remove(range_id id);
+
+        // offsets change with `compact`, look them up at draw time
+        const Range& range(range_id id) const noexcept {
+            return ranges_[id];
+        }
+
+        GLuint vao() const noexcept {
+            return vao_;
+        }
+
+        // Moves all ranges to the front of their buffers. Copies happen on the
+        // GPU, into new buffers sized for the data plus some headroom.
+        void compact();
+
+        // unused vertices between and after ranges, in bytes, including the
+        // headroom at the end
+        size_t free_bytes() const noexcept {
+            return (vertices_.capacity() - vertices_.used())*vertex_size_ + (indices_.capacity() - indices_.used())*sizeof(uint32_t);
+        }
+
+        // number of gaps in both buffers, compaction gets it down to at most 2
+        size_t fragments() const noexcept {
+            return vertices_.free_range_count() + indices_.free_range_count();
+        }
+    private:
+        // rebinds the attributes after the vertex buffer changed
+        void set_attrib_pointers();
+        void grow_vertices(size_t capacity);
+        void grow_indices(size_t capacity);
+
+        size_t vertex_size_;
+        std::vector<VertexDescriptor> vertex_desc_;
+        const Program& prog_;
+        GLuint vao_ = 0;
+        Buffer<BufferType::Array> vbo_;
+        Buffer<BufferType::ElementArray> ibo_;
+        RangeAllocator vertices_;
+        RangeAllocator indices_;
+        std::vector<Range> ranges_;
+        // ids of removed ranges
+        std::vector<range_id> free_ids_;
+};
@@ -0,0 +1,399 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <map>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "utils.h"
+
+enum class BufferType : GLenum {
+    Array = GL_ARRAY_BUFFER,
+    ElementArray = GL_ELEMENT_ARRAY_BUFFER,
+    DrawIndirect = GL_DRAW_INDIRECT_BUFFER,
+    ShaderStorage = GL_SHADER_STORAGE_BUFFER,
+    Uniform = GL_UNIFORM_BUFFER,
+};
+
+template <>
+struct BindingPointTraits<BufferType> {
+    static void binding_fn(GLenum tgt, GLuint buf) noexcept {
+        glBindBuffer(tgt, buf);
+    }
+};
+
+enum class TextureTarget : GLenum {
+    Texture2D = GL_TEXTURE_2D,
+};
+
+template <>
+struct BindingPointTraits<TextureTarget> {
+    static constexpr auto binding_fn = glBindTexture;
+};
+
+using TextureBindingPoint = BindingPoint<TextureTarget, GLuint>;
+
+// Programs, vertex arrays and the active texture unit have a single binding
+// point each, the target only selects the binding function.
+enum class ProgramTarget : GLenum {
+    Program,
+};
+
+template <>
+struct BindingPointTraits<ProgramTarget> {
+    static void binding_fn(GLenum, GLuint prog) noexcept {
+        glUseProgram(prog);
+    }
+};
+
+enum class VertexArrayTarget : GLenum {
+    VertexArray,
+};
+
+template <>
+struct BindingPointTraits<VertexArrayTarget> {
+    static void binding_fn(GLenum, GLuint vao) noexcept {
+        glBindVertexArray(vao);
+    }
+};
+
+enum class TextureUnitTarget : GLenum {
+    Active,
+};
+
+template <>
+struct BindingPointTraits<TextureUnitTarget> {
+    static void binding_fn(GLenum, GLuint unit) noexcept {
+        glActiveTexture(GL_TEXTURE0 + unit);
+    }
+};
+
+enum class Capability : GLenum {
+    Blend = GL_BLEND,
+    CullFace = GL_CULL_FACE,
+    DepthClamp = GL_DEPTH_CLAMP,
+    DepthTest = GL_DEPTH_TEST,
+    ScissorTest = GL_SCISSOR_TEST,
+};
+
+struct GLStateStats {
+    BindingStats programs;
+    BindingStats vertex_arrays;
+    BindingStats buffers;
+    // including switches of the active unit
+    BindingStats textures;
+    BindingStats raster;
+
+    BindingStats total() const noexcept {
+        auto ret = programs;
+        ret += vertex_arrays;
+        ret += buffers;
+        ret += textures;
+        ret += raster;
+        return ret;
+    }
+};
+
+// Shadow copy of the GL state the renderer changes: the program, the vertex
+// array, buffers per target, 2D textures per unit and some raster state.
+// Setting what is current already doesn't call GL. Code that changes this
+// state directly has to `invalidate` the cache afterwards; the ImGui backend
+// restores everything it touches, so it doesn't.
+//
+// There is a single GL context, see `gl_state()`.
+class GLState {
+    public:
+        static constexpr GLuint texture_unit_count = 16;
+
+        bool use_program(GLuint prog) noexcept {
+            return program_.bind(prog);
+        }
+
+        bool bind_vertex_array(GLuint vao) noexcept {
+            if (!vertex_array_.bind(vao)) {
+                return false;
+            }
+            // the element array binding is part of the vertex array
+            buffer_point(BufferType::ElementArray).invalidate();
+            return true;
+        }
+
+        bool bind_buffer(BufferType type, GLuint buf) noexcept {
+            return buffer_point(type).bind(buf);
+        }
+
+        bool is_bound(BufferType type, GLuint buf) noexcept {
+            const auto& point = buffer_point(type);
+            return point.is_known() && (point.bound() == buf);
+        }
+
+        // glBindBufferBase, which also binds `buf` to the generic binding point
+        bool bind_buffer_base(BufferType type, GLuint index, GLuint buf) noexcept {
+            return bind_indexed(type, index, IndexedBinding{buf, 0, 0});
+        }
+
+        // glBindBufferRange, which also binds `buf` to the generic binding point
+        bool bind_buffer_range(BufferType type, GLuint index, GLuint buf, size_t offset, size_t size) noexcept {
+            assert(size > 0);
+            return bind_indexed(type, index, IndexedBinding{buf, offset, size});
+        }
+
+        // Selects `unit` as the active texture unit and returns its binding
+        // point. Binds through it only go to `unit` until another unit is
+        // selected.
+        TextureBindingPoint& texture_unit(GLuint unit) noexcept {
+            assert(unit < texture_unit_count);
+            active_unit_.bind(unit);
+            return texture_units_[unit];
+        }
+
+        bool bind_texture(GLuint unit, GLuint tex) noexcept {
+            return texture_unit(unit).bind(tex);
+        }
+
+        void set_enabled(Capability cap, bool enabled) noexcept {
+            auto& current = capabilities_[capability_index(cap)];
+            if (current == enabled) {
+                ++raster_stats_.avoided;
+                return;
+            }
+            if (enabled) {
+                glEnable(static_cast<GLenum>(cap));
+            } else {
+                glDisable(static_cast<GLenum>(cap));
+            }
+            current = enabled;
+            ++raster_stats_.issued;
+        }
+
+        void set_blend_func(GLenum src, GLenum dst) noexcept {
+            auto func = std::make_pair(src, dst);
+            if (blend_func_ == func) {
+                ++raster_stats_.avoided;
+                return;
+            }
+            glBlendFunc(src, dst);
+            blend_func_ = func;
+            ++raster_stats_.issued;
+        }
+
+        void set_cull_face(GLenum mode) noexcept {
+            if (cull_face_ == mode) {
+                ++raster_stats_.avoided;
+                return;
+            }
+            glCullFace(mode);
+            cull_face_ = mode;
+            ++raster_stats_.issued;
+        }
+
+        void set_depth_func(GLenum func) noexcept {
+            if (depth_func_ == func) {
+                ++raster_stats_.avoided;
+                return;
+            }
+            glDepthFunc(func);
+            depth_func_ = func;
+            ++raster_stats_.issued;
+        }
+
+        void set_depth_mask(bool enabled) noexcept {
+            if (depth_mask_ == enabled) {
+                ++raster_stats_.avoided;
+                return;
+            }
+            glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+            depth_mask_ = enabled;
+            ++raster_stats_.issued;
+        }
+
+        // to be called when the object is deleted, GL reverts its bindings to 0
+        void forget_program(GLuint prog) noexcept {
+            program_.forget(prog);
+        }
+
+        void forget_vertex_array(GLuint vao) noexcept {
+            if (vertex_array_.is_known() && (vertex_array_.bound() == vao)) {
+                buffer_point(BufferType::ElementArray).invalidate();
+            }
+            vertex_array_.forget(vao);
+        }
+
+        void forget_buffer(GLuint buf) noexcept {
+            for (auto& point : buffers_) {
+                point.forget(buf);
+            }
+            for (auto& [key, bound] : indexed_buffers_) {
+                if (bound.buf == buf) {
+                    bound = IndexedBinding{};
+                }
+            }
+        }
+
+        void forget_texture(GLuint tex) noexcept {
+            for (auto& point : texture_units_) {
+                point.forget(tex);
+            }
+        }
+
+        // for state changed outside the cache: everything is set again once
+        void invalidate() noexcept {
+            program_.invalidate();
+            vertex_array_.invalidate();
+            for (auto& point : buffers_) {
+                point.invalidate();
+            }
+            indexed_buffers_.clear();
+            active_unit_.invalidate();
+            for (auto& point : texture_units_) {
+                point.invalidate();
+            }
+            capabilities_ = {};
+            blend_func_.reset();
+            cull_face_.reset();
+            depth_func_.reset();
+            depth_mask_.reset();
+        }
+
+        // counts since the last `end_frame`
+        GLStateStats stats() const noexcept {
+            auto ret = GLStateStats{};
+            ret.programs = program_.stats();
+            ret.vertex_arrays = vertex_array_.stats();
+            for (const auto& point : buffers_) {
+                ret.buffers += point.stats();
+            }
+            ret.buffers += indexed_stats_;
+            ret.textures = active_unit_.stats();
+            for (const auto& point : texture_units_) {
+                ret.textures += point.stats();
+            }
+            ret.raster = raster_stats_;
+            return ret;
+        }
+
+        // counts of the last complete frame
+        const GLStateStats& frame_stats() const noexcept {
+            return frame_stats_;
+        }
+
+        void end_frame() noexcept {
+            frame_stats_ = stats();
+            program_.reset_stats();
+            vertex_array_.reset_stats();
+            for (auto& point : buffers_) {
+                point.reset_stats();
+            }
+            indexed_stats_ = BindingStats{};
+            active_unit_.reset_stats();
+            for (auto& point : texture_units_) {
+                point.reset_stats();
+            }
+            raster_stats_ = BindingStats{};
+        }
+    private:
+        using BufferBindingPoint = BindingPoint<BufferType, GLuint>;
+
+        // the whole buffer if `size` is 0
+        struct IndexedBinding {
+            GLuint buf = 0;
+            size_t offset = 0;
+            size_t size = 0;
+
+            bool operator==(const IndexedBinding&) const = default;
+        };
+
+        bool bind_indexed(BufferType type, GLuint index, const IndexedBinding& binding) noexcept {
+            auto& point = buffer_point(type);
+            auto key = std::make_pair(type, index);
+            auto it = indexed_buffers_.find(key);
+            if ((it != indexed_buffers_.end()) && (it->second == binding) && point.is_known() && (point.bound() == binding.buf)) {
+                ++indexed_stats_.avoided;
+                return false;
+            }
+            if (binding.size == 0) {
+                glBindBufferBase(static_cast<GLenum>(type), index, binding.buf);
+            } else {
+                assert((binding.offset < PTRDIFF_MAX) && (binding.size < PTRDIFF_MAX));
+                glBindBufferRange(
+                    static_cast<GLenum>(type),
+                    index,
+                    binding.buf,
+                    static_cast<GLintptr>(binding.offset),
+                    static_cast<GLsizeiptr>(binding.size));
+            }
+            indexed_buffers_[key] = binding;
+            point.set_bound(binding.buf);
+            ++indexed_stats_.issued;
+            return true;
+        }
+
+        BufferBindingPoint& buffer_point(BufferType type) noexcept {
+            switch (type) {
+                case BufferType::Array:
+                    return buffers_[0];
+                case BufferType::ElementArray:
+                    return buffers_[1];
+                case BufferType::DrawIndirect:
+                    return buffers_[2];
+                case BufferType::ShaderStorage:
+                    return buffers_[3];
+                case BufferType::Uniform:
+                    return buffers_[4];
+            }
+            abort();
+        }
+
+        static size_t capability_index(Capability cap) noexcept {
+            switch (cap) {
+                case Capability::Blend:
+                    return 0;
+                case Capability::CullFace:
+                    return 1;
+                case Capability::DepthClamp:
+                    return 2;
+                case Capability::DepthTest:
+                    return 3;
+                case Capability::ScissorTest:
+                    return 4;
+            }
+            abort();
+        }
+
+        BindingPoint<ProgramTarget, GLuint> program_{ProgramTarget::Program};
+        BindingPoint<VertexArrayTarget, GLuint> vertex_array_{VertexArrayTarget::VertexArray};
+        std::array<BufferBindingPoint, 5> buffers_{
+            BufferBindingPoint(BufferType::Array),
+            BufferBindingPoint(BufferType::ElementArray),
+            BufferBindingPoint(BufferType::DrawIndirect),
+            BufferBindingPoint(BufferType::ShaderStorage),
+            BufferBindingPoint(BufferType::Uniform),
+        };
+        std::map<std::pair<BufferType, GLuint>, IndexedBinding> indexed_buffers_;
+        BindingStats indexed_stats_;
+        BindingPoint<TextureUnitTarget, GLuint> active_unit_{TextureUnitTarget::Active};
+        std::vector<TextureBindingPoint> texture_units_ = std::vector<TextureBindingPoint>(
+            texture_unit_count, TextureBindingPoint(TextureTarget::Texture2D));
+        // unknown until set the first time
+        std::array<std::optional<bool>, 5> capabilities_ = {};
+        std::optional<std::pair<GLenum, GLenum>> blend_func_;
+        std::optional<GLenum> cull_face_;
+        std::optional<GLenum> depth_func_;
+        std::optional<bool> depth_mask_;
+        BindingStats raster_stats_;
+        GLStateStats frame_stats_;
+};
+
+// the cache of the one GL context, must only be used on the render thread
+inline GLState&
+gl_state() noexcept {
+    static auto state = GLState{};
+    return state;
+}
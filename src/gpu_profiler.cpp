@@ -0,0 +1,139 @@
+#include "gpu_profiler.h"
+
+#include <algorithm>
+#include <cassert>
+
+#include <imgui.h>
+
+GpuProfiler::~GpuProfiler() {
+    for (auto& frame : frames_) {
+        if (!frame.queries.empty()) {
+            glDeleteQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+        }
+    }
+}
+
+void
+GpuProfiler::begin_frame() {
+    auto now = clock::now();
+    if (has_last_frame_) {
+        cpu_frame_ms_.push(std::chrono::duration<float, std::milli>(now - last_frame_begin_).count());
+    }
+    last_frame_begin_ = now;
+    has_last_frame_ = true;
+
+    frame_ = (frame_ + 1) % frame_latency;
+    collect(frames_[frame_]);
+    begin_zone("Frame");
+}
+
+void
+GpuProfiler::end_frame() {
+    end_zone();
+    assert(open_zones_.empty());
+}
+
+void
+GpuProfiler::begin_zone(const char* name) {
+    parent_path_lengths_.push_back(path_.size());
+    if (!path_.empty()) {
+        path_ += '/';
+    }
+    path_ += name;
+    auto [it, is_new] = zone_indices_.try_emplace(path_, zones_.size());
+    if (is_new) {
+        zones_.push_back(ZoneStats{path_, open_zones_.size()});
+    }
+
+    auto& frame = frames_[frame_];
+    auto begin_query = next_query();
+    auto end_query = next_query();
+    glQueryCounter(begin_query, GL_TIMESTAMP);
+    open_zones_.push_back(frame.zones.size());
+    frame.zones.push_back(PendingZone{it->second, begin_query, end_query, clock::now(), 0.f});
+}
+
+void
+GpuProfiler::end_zone() {
+    assert(!open_zones_.empty());
+    auto& zone = frames_[frame_].zones[open_zones_.back()];
+    glQueryCounter(zone.end_query, GL_TIMESTAMP);
+    zone.cpu_ms = std::chrono::duration<float, std::milli>(clock::now() - zone.cpu_begin).count();
+    open_zones_.pop_back();
+    path_.resize(parent_path_lengths_.back());
+    parent_path_lengths_.pop_back();
+}
+
+GLuint
+GpuProfiler::next_query() {
+    auto& frame = frames_[frame_];
+    if (frame.used_queries == frame.queries.size()) {
+        auto count = std::max(frame.queries.size(), size_t{16});
+        frame.queries.resize(frame.queries.size() + count);
+        glGenQueries(static_cast<GLsizei>(count), frame.queries.data() + frame.used_queries);
+    }
+    return frame.queries[frame.used_queries++];
+}
+
+void
+GpuProfiler::collect(Frame& frame) {
+    if (!frame.zones.empty()) {
+        // timestamps are written in order, the last one is the frame's end
+        auto available = GLint{GL_FALSE};
+        glGetQueryObjectiv(frame.zones.front().end_query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available == GL_TRUE) {
+            for (const auto& zone : frame.zones) {
+                auto begin = GLuint64{0};
+                auto end = GLuint64{0};
+                glGetQueryObjectui64v(zone.begin_query, GL_QUERY_RESULT, &begin);
+                glGetQueryObjectui64v(zone.end_query, GL_QUERY_RESULT, &end);
+                auto& stats = zones_[zone.stats_idx];
+                stats.gpu_ms.push(static_cast<float>(end - begin)*1e-6f);
+                stats.cpu_ms.push(zone.cpu_ms);
+            }
+        } else {
+            ++dropped_frames_;
+        }
+    }
+    frame.zones.clear();
+    frame.used_queries = 0;
+}
+
+void
+GpuProfiler::draw_window() const {
+    ImGui::Begin("Profiler", nullptr, ImGuiWindowFlags_::ImGuiWindowFlags_AlwaysAutoResize);
+    ImGui::Text(
+        "CPU frame: %.2f ms (p50 %.2f, p95 %.2f, p99 %.2f)",
+        static_cast<double>(cpu_frame_ms_.mean()),
+        static_cast<double>(cpu_frame_ms_.percentile(.5f)),
+        static_cast<double>(cpu_frame_ms_.percentile(.95f)),
+        static_cast<double>(cpu_frame_ms_.percentile(.99f)));
+    ImGui::Text("Dropped GPU frames: %zu", dropped_frames_);
+    if (ImGui::BeginTable("zones", 6, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("Zone");
+        ImGui::TableSetupColumn("GPU avg");
+        ImGui::TableSetupColumn("GPU p50");
+        ImGui::TableSetupColumn("GPU p95");
+        ImGui::TableSetupColumn("GPU p99");
+        ImGui::TableSetupColumn("CPU avg");
+        ImGui::TableHeadersRow();
+        for (const auto& zone : zones_) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            // the last path component, indented by depth
+            auto name = zone.path.substr(zone.path.rfind('/') + 1);
+            ImGui::Text("%*s%s", static_cast<int>(2*zone.depth), "", name.c_str());
+            for (auto value : {
+                    zone.gpu_ms.mean(),
+                    zone.gpu_ms.percentile(.5f),
+                    zone.gpu_ms.percentile(.95f),
+                    zone.gpu_ms.percentile(.99f),
+                    zone.cpu_ms.mean()}) {
+                ImGui::TableNextColumn();
+                ImGui::Text("%.3f ms", static_cast<double>(value));
+            }
+        }
+        ImGui::EndTable();
+    }
+    ImGui::End();
+}
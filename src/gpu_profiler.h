@@ -0,0 +1,115 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "rolling_stats.h"
+
+// Measures named zones of a frame on the GPU with GL_TIMESTAMP queries, and
+// on the CPU. Zones nest; each is kept under its path, e.g. "Frame/Sandbox/
+// static". Queries are read `frame_latency` frames later; if the GPU hasn't
+// got there yet the frame's results are dropped instead of waiting.
+class GpuProfiler {
+    public:
+        static constexpr size_t frame_latency = 4;
+        // frames in the rolling statistics
+        static constexpr size_t window = 120;
+
+        struct ZoneStats {
+            std::string path;
+            // 0 for the frame itself
+            size_t depth;
+            RollingStats gpu_ms{window};
+            RollingStats cpu_ms{window};
+        };
+
+        // ends the zone when it goes out of scope
+        class [[nodiscard]] Zone {
+            public:
+                Zone(GpuProfiler& profiler, const char* name) : profiler_{profiler} {
+                    profiler_.begin_zone(name);
+                }
+                ~Zone() {
+                    profiler_.end_zone();
+                }
+                Zone(const Zone&) = delete;
+                Zone& operator=(const Zone&) = delete;
+            private:
+                GpuProfiler& profiler_;
+        };
+
+        GpuProfiler() = default;
+        GpuProfiler(const GpuProfiler&) = delete;
+        GpuProfiler& operator=(const GpuProfiler&) = delete;
+        ~GpuProfiler();
+
+        // between `begin_frame` and `end_frame`
+        Zone zone(const char* name) {
+            return Zone(*this, name);
+        }
+
+        // reads the results of the frame `frame_latency` frames ago and opens
+        // the "Frame" zone
+        void begin_frame();
+        void end_frame();
+
+        // in order of first use
+        const std::vector<ZoneStats>& zones() const noexcept {
+            return zones_;
+        }
+
+        // wall time from one `begin_frame` to the next
+        const RollingStats& cpu_frame_ms() const noexcept {
+            return cpu_frame_ms_;
+        }
+
+        // frames whose queries weren't available in time
+        size_t dropped_frames() const noexcept {
+            return dropped_frames_;
+        }
+
+        // ImGui window with the rolling averages and percentiles
+        void draw_window() const;
+    private:
+        using clock = std::chrono::steady_clock;
+
+        struct PendingZone {
+            size_t stats_idx;
+            GLuint begin_query;
+            GLuint end_query;
+            clock::time_point cpu_begin;
+            float cpu_ms;
+        };
+
+        struct Frame {
+            std::vector<PendingZone> zones;
+            // reused every `frame_latency` frames, grown on demand
+            std::vector<GLuint> queries;
+            size_t used_queries = 0;
+        };
+
+        void begin_zone(const char* name);
+        void end_zone();
+        GLuint next_query();
+        void collect(Frame& frame);
+
+        std::array<Frame, frame_latency> frames_;
+        size_t frame_ = 0;
+        // indices into the current frame's zones
+        std::vector<size_t> open_zones_;
+        // length of `path_` before each open zone was appended
+        std::vector<size_t> parent_path_lengths_;
+        std::vector<ZoneStats> zones_;
+        std::unordered_map<std::string, size_t> zone_indices_;
+        std::string path_;
+        RollingStats cpu_frame_ms_{window};
+        clock::time_point last_frame_begin_;
+        bool has_last_frame_ = false;
+        size_t dropped_frames_ = 0;
+};
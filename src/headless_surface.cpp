@@ -0,0 +1,163 @@
+#include "headless_surface.h"
+
+#include <cstring>
+#include <string>
+using namespace std::string_literals;
+
+#include <GL/glew.h>
+#ifdef GLSB_HAS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
+
+#include "utils.h"
+
+#ifdef GLSB_HAS_EGL
+
+namespace {
+
+// `extensions` is a space separated list
+bool
+has_extension(const char* extensions, const char* name) noexcept {
+    if (extensions == nullptr) {
+        return false;
+    }
+    auto len = std::strlen(name);
+    for (auto p = std::strstr(extensions, name); p != nullptr; p = std::strstr(p + len, name)) {
+        auto starts = (p == extensions) || (p[-1] == ' ');
+        auto ends = (p[len] == ' ') || (p[len] == '\0');
+        if (starts && ends) {
+            return true;
+        }
+    }
+    return false;
+}
+
+EGLDisplay
+open_display() {
+    auto client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    auto get_platform_display = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+        eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (!has_extension(client_extensions, "EGL_EXT_platform_base") || (get_platform_display == nullptr)) {
+        throw GLSBError("EGL lacks EGL_EXT_platform_base");
+    }
+
+    if (has_extension(client_extensions, "EGL_MESA_platform_surfaceless")) {
+        auto display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, nullptr, nullptr);
+        if (display != EGL_NO_DISPLAY) {
+            return display;
+        }
+    }
+    if (has_extension(client_extensions, "EGL_EXT_platform_device")) {
+        auto query_devices = reinterpret_cast<PFNEGLQUERYDEVICESEXTPROC>(eglGetProcAddress("eglQueryDevicesEXT"));
+        auto device = EGLDeviceEXT{};
+        auto device_count = EGLint{0};
+        if ((query_devices != nullptr) && query_devices(1, &device, &device_count) && (device_count > 0)) {
+            auto display = get_platform_display(EGL_PLATFORM_DEVICE_EXT, device, nullptr);
+            if (display != EGL_NO_DISPLAY) {
+                return display;
+            }
+        }
+    }
+    throw GLSBError("no EGL display without a window system, needs EGL_MESA_platform_surfaceless or EGL_EXT_platform_device");
+}
+
+}
+
+HeadlessSurface::HeadlessSurface(int width, int height) : size_{width, height} {
+    auto display = open_display();
+    auto major = EGLint{0};
+    auto minor = EGLint{0};
+    if (!eglInitialize(display, &major, &minor)) {
+        throw GLSBError("error initializing EGL");
+    }
+    display_ = display;
+
+    try {
+        if (!has_extension(eglQueryString(display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context")) {
+            throw GLSBError("EGL lacks EGL_KHR_surfaceless_context");
+        }
+        if (!eglBindAPI(EGL_OPENGL_API)) {
+            throw GLSBError("EGL doesn't support desktop OpenGL");
+        }
+
+        const EGLint config_attribs[] = {
+            EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_NONE
+        };
+        auto config = EGLConfig{};
+        auto config_count = EGLint{0};
+        if (!eglChooseConfig(display, config_attribs, &config, 1, &config_count) || (config_count == 0)) {
+            throw GLSBError("no EGL config for desktop OpenGL");
+        }
+
+        const EGLint context_attribs[] = {
+            EGL_CONTEXT_MAJOR_VERSION, 4,
+            EGL_CONTEXT_MINOR_VERSION, 3,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+#ifndef NDEBUG
+            EGL_CONTEXT_OPENGL_DEBUG, EGL_TRUE,
+#endif // NDEBUG
+            EGL_NONE
+        };
+        auto context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attribs);
+        if (context == EGL_NO_CONTEXT) {
+            throw GLSBError("error creating an OpenGL 4.3 core context with EGL");
+        }
+        context_ = context;
+
+        if (!eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+            throw GLSBError("error making the EGL context current");
+        }
+    }
+    catch (...) {
+        release();
+        throw;
+    }
+}
+
+HeadlessSurface::~HeadlessSurface() {
+    release();
+}
+
+void
+HeadlessSurface::swap_buffers() {
+    glFlush();
+}
+
+void
+HeadlessSurface::release() noexcept {
+    if (display_ == nullptr) {
+        return;
+    }
+    eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (context_ != nullptr) {
+        eglDestroyContext(display_, context_);
+        context_ = nullptr;
+    }
+    eglTerminate(display_);
+    eglReleaseThread();
+    display_ = nullptr;
+}
+
+#else
+
+HeadlessSurface::HeadlessSurface(int width, int height) : size_{width, height} {
+    throw GLSBError("headless rendering needs EGL, which this build lacks");
+}
+
+HeadlessSurface::~HeadlessSurface() {
+    release();
+}
+
+void
+HeadlessSurface::swap_buffers() {
+    glFlush();
+}
+
+void
+HeadlessSurface::release() noexcept {
+}
+
+#endif // GLSB_HAS_EGL
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "surface.h"
+
+// OpenGL 4.3 core context without a window or display server, for benchmarks
+// on machines without a screen: EGL on Mesa's surfaceless platform, or on the
+// first GPU through EGL_EXT_platform_device. Made current on construction,
+// load the GL functions with `glewInit` afterwards.
+//
+// There is no default framebuffer to draw to, something has to bind an
+// offscreen one of `framebuffer_size()` first, e.g. `BenchmarkLayer`. Throws
+// `GLSBError` if no such context can be created, or on platforms without EGL.
+class HeadlessSurface final : public Surface {
+    public:
+        HeadlessSurface(int width, int height);
+        ~HeadlessSurface() override;
+
+        HeadlessSurface(const HeadlessSurface&) = delete;
+        HeadlessSurface& operator=(const HeadlessSurface&) = delete;
+
+        Extent2D<int> framebuffer_size() const noexcept override {
+            return size_;
+        }
+
+        // no events without a window
+        void poll_events() override {}
+
+        // nothing to present, submits the frame's commands like a swap would
+        void swap_buffers() override;
+
+        bool should_close() const noexcept override {
+            return should_close_;
+        }
+
+        void request_close() noexcept override {
+            should_close_ = true;
+        }
+    private:
+        void release() noexcept;
+
+        Extent2D<int> size_;
+        // EGLDisplay and EGLContext, EGL stays out of the header
+        void* display_ = nullptr;
+        void* context_ = nullptr;
+        bool should_close_ = false;
+};
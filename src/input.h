@@ -45,6 +45,18 @@ enum class KeyCode : int {
     KEY_9 = GLFW_KEY_9,
     KEY_ESC = GLFW_KEY_ESCAPE,
     KEY_TAB = GLFW_KEY_TAB,
+    KEY_F1 = GLFW_KEY_F1,
+    KEY_F2 = GLFW_KEY_F2,
+    KEY_F3 = GLFW_KEY_F3,
+    KEY_F4 = GLFW_KEY_F4,
+    KEY_F5 = GLFW_KEY_F5,
+    KEY_F6 = GLFW_KEY_F6,
+    KEY_F7 = GLFW_KEY_F7,
+    KEY_F8 = GLFW_KEY_F8,
+    KEY_F9 = GLFW_KEY_F9,
+    KEY_F10 = GLFW_KEY_F10,
+    KEY_F11 = GLFW_KEY_F11,
+    KEY_F12 = GLFW_KEY_F12,
     KEY_LSHIFT = GLFW_KEY_LEFT_SHIFT,
     KEY_RSHIFT = GLFW_KEY_RIGHT_SHIFT,
     KEY_LCTRL = GLFW_KEY_LEFT_CONTROL,
@@ -207,3 +219,15 @@ class GLFWInputManager : public InputManager {
         std::vector<mouse_button_handler_type> mouse_button_handlers_;
         std::vector<mouse_scroll_handler_type> mouse_scroll_handlers_;
 };
+
+// without a window: no key is ever pressed, the handlers are never called
+class NullInputManager final : public InputManager {
+    public:
+        KeyState key_state(KeyCode) const override {
+            return KeyState::Released;
+        }
+
+        void register_key_handler(key_handler_type) override {}
+        void register_mouse_button_handler(mouse_button_handler_type) override {}
+        void register_mouse_scroll_handler(mouse_scroll_handler_type) override {}
+};
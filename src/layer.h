@@ -1,13 +1,13 @@
 #pragma once
 
+#include <algorithm>
+#include <chrono>
 #include <deque>
 #include <memory>
 
-#define GLFW_INCLUDE_NONE
-#include <GLFW/glfw3.h>
-
 #include "imgui/imgui_glfw.h"
 #include "imgui/imgui_ogl3.h"
+#include "surface.h"
 
 class Application;
 
@@ -16,6 +16,9 @@ class Layer {
         Layer(Application& app) : app_{app} {}
         virtual ~Layer() = default;
 
+        // names the layer's zone in the profiler
+        virtual const char* name() const noexcept = 0;
+
         virtual void init() = 0;
         virtual void cleanup() = 0;
 
@@ -26,9 +29,15 @@ class Layer {
         Application& app_;
 };
 
+// Without a window (see `Surface::window`) ImGui still draws, sized like the
+// surface, but gets no input.
 class ImGuiLayer final : public Layer {
     public:
-        ImGuiLayer(Application& app, GLFWwindow* win) : Layer{app}, win_{win}, is_initialized_{false} {}
+        ImGuiLayer(Application& app, Surface& surface) : Layer{app}, surface_{surface}, is_initialized_{false} {}
+
+        const char* name() const noexcept override {
+            return "ImGui";
+        }
 
         void init() override {
             IMGUI_CHECKVERSION();
@@ -37,21 +46,37 @@ class ImGuiLayer final : public Layer {
             (void)io;
 
             ImGui::StyleColorsDark();
-            ImGui_ImplGlfw_InitForOpenGL(win_, true);
+            if (auto win = surface_.window()) {
+                ImGui_ImplGlfw_InitForOpenGL(win, true);
+            }
             ImGui_ImplOpenGL3_Init("#version 330 core");
             is_initialized_ = true;
         }
 
         void prepare_frame() override {
             ImGui_ImplOpenGL3_NewFrame();
-            ImGui_ImplGlfw_NewFrame();
+            if (surface_.window()) {
+                ImGui_ImplGlfw_NewFrame();
+            } else {
+                // what the GLFW backend sets up otherwise
+                auto now = clock::now();
+                auto size = surface_.framebuffer_size();
+                auto& io = ImGui::GetIO();
+                io.DisplaySize = ImVec2(static_cast<float>(size.width), static_cast<float>(size.height));
+                io.DeltaTime = (last_frame_ == clock::time_point{})
+                    ? 1.f/60.f
+                    : std::max(std::chrono::duration<float>(now - last_frame_).count(), 1e-6f);
+                last_frame_ = now;
+            }
             ImGui::NewFrame();
         }
 
         void cleanup() override {
             if (is_initialized_) {
                 ImGui_ImplOpenGL3_Shutdown();
-                ImGui_ImplGlfw_Shutdown();
+                if (surface_.window()) {
+                    ImGui_ImplGlfw_Shutdown();
+                }
                 ImGui::DestroyContext();
             }
         }
@@ -64,8 +89,11 @@ class ImGuiLayer final : public Layer {
             ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
         }
     private:
-        GLFWwindow* win_;
+        using clock = std::chrono::steady_clock;
+
+        Surface& surface_;
         bool is_initialized_;
+        clock::time_point last_frame_;
 };
 
 using LayerStack = std::deque<std::unique_ptr<Layer>>;
@@ -0,0 +1,70 @@
+#include "light_clusters.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace {
+
+uint32_t
+clamp_cell(float pos, uint32_t count) noexcept {
+    auto cell = std::floor(pos*static_cast<float>(count));
+    return static_cast<uint32_t>(std::clamp(cell, 0.f, static_cast<float>(count - 1)));
+}
+
+}
+
+ClusterGrid
+ClusterGrid::from_camera(const Camera& cam, glm::uvec3 size) noexcept {
+    assert((size.x > 0) && (size.y > 0) && (size.z > 0));
+    assert((cam.clip_dist.first > 0.f) && (cam.clip_dist.first < cam.clip_dist.second));
+    return ClusterGrid{
+        size,
+        cam.clip_dist.first,
+        cam.clip_dist.second,
+        std::tan(glm::radians(cam.fov)*.5f),
+        cam.aspect
+    };
+}
+
+float
+ClusterGrid::slice_depth(uint32_t k) const noexcept {
+    return z_near*std::pow(z_far/z_near, static_cast<float>(k)/static_cast<float>(size.z));
+}
+
+uint32_t
+ClusterGrid::slice(float depth) const noexcept {
+    if (depth <= z_near) {
+        return 0;
+    }
+    return clamp_cell(std::log(depth/z_near)/std::log(z_far/z_near), size.z);
+}
+
+glm::uvec3
+ClusterGrid::cluster_of(const glm::vec3& view_pos) const noexcept {
+    // behind the near plane the tiles are meaningless, the first slice
+    // is the nearest cluster anyway
+    auto depth = std::max(-view_pos.z, z_near);
+    auto ndc = glm::vec2(view_pos.x/(tan_half_fov*aspect), view_pos.y/tan_half_fov)/depth;
+    return glm::uvec3(
+        clamp_cell((ndc.x + 1.f)*.5f, size.x),
+        clamp_cell((ndc.y + 1.f)*.5f, size.y),
+        slice(depth)
+    );
+}
+
+BoundingBox
+ClusterGrid::bounds(const glm::uvec3& cluster) const noexcept {
+    assert((cluster.x < size.x) && (cluster.y < size.y) && (cluster.z < size.z));
+    auto ndc_lo = glm::vec2(cluster.x, cluster.y)/glm::vec2(size.x, size.y)*2.f - 1.f;
+    auto ndc_hi = glm::vec2(cluster.x + 1, cluster.y + 1)/glm::vec2(size.x, size.y)*2.f - 1.f;
+    auto half_extent = glm::vec2(tan_half_fov*aspect, tan_half_fov);
+    auto ret = BoundingBox::empty();
+    // the tile's corners on the near and far plane of the slice
+    for (auto depth : {slice_depth(cluster.z), slice_depth(cluster.z + 1)}) {
+        for (auto ndc : {ndc_lo, glm::vec2(ndc_hi.x, ndc_lo.y), glm::vec2(ndc_lo.x, ndc_hi.y), ndc_hi}) {
+            ret.grow(glm::vec3(ndc*half_extent*depth, -depth));
+        }
+    }
+    return ret;
+}
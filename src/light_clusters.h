@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+
+#include "bounds.h"
+#include "scene.h"
+
+// Froxel grid over the view frustum of a camera for clustered shading: the
+// screen is split into `size.x` by `size.y` tiles, the view depth into
+// `size.z` slices growing exponentially from the near to the far plane, so
+// clusters are roughly as deep as they are wide. The same math runs in
+// res/cluster_lights.comp.glsl and res/clustered.frag.glsl.
+//
+// Positions are in view space, looking down -z; depths are distances in
+// front of the camera.
+struct ClusterGrid {
+    // 16:9 tiles, 3456 clusters in all
+    static constexpr glm::uvec3 default_size = glm::uvec3(16, 9, 24);
+
+    static ClusterGrid from_camera(const Camera& cam, glm::uvec3 size = default_size) noexcept;
+
+    size_t cluster_count() const noexcept {
+        return size_t{size.x}*size.y*size.z;
+    }
+
+    // the near depth of slice `k`, the far plane for `size.z`
+    float slice_depth(uint32_t k) const noexcept;
+
+    // the slice containing `depth`, clamped to the grid
+    uint32_t slice(float depth) const noexcept;
+
+    // the cluster containing `view_pos`, clamped to the grid
+    glm::uvec3 cluster_of(const glm::vec3& view_pos) const noexcept;
+
+    // x fastest, then y, then z
+    size_t index(const glm::uvec3& cluster) const noexcept {
+        return (size_t{cluster.z}*size.y + cluster.y)*size.x + cluster.x;
+    }
+
+    // axis aligned box around the cluster in view space
+    BoundingBox bounds(const glm::uvec3& cluster) const noexcept;
+
+    glm::uvec3 size;
+    float z_near;
+    float z_far;
+    // half extent of the view at depth 1
+    float tan_half_fov;
+    float aspect;
+};
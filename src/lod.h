@@ -0,0 +1,101 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "bounds.h"
+#include "mesh.h"
+#include "mesh_optimizer.h"
+#include "mesh_simplifier.h"
+#include "scene.h"
+
+struct LodSettings {
+    // triangle count of each generated level relative to the full mesh
+    std::vector<float> reduction_targets = {.5f, .25f, .125f};
+    // generation stops once a level removes less than this fraction of the
+    // previous level's triangles
+    float min_reduction = .1f;
+};
+
+struct MeshLod {
+    size_t index_offset;
+    size_t index_count;
+    // deviation from the full mesh in mesh units
+    float error;
+};
+
+// Levels of detail sharing one vertex buffer, `mesh.index_data` holds the
+// index ranges of all levels back to back, finest first.
+template <typename VertexT>
+struct LodMesh {
+    using vertex_type = VertexT;
+
+    MeshView<vertex_type> view() const noexcept {
+        return mesh.view();
+    }
+
+    MeshView<vertex_type> view(size_t level) const noexcept {
+        return MeshView<vertex_type>{
+            mesh.vertex_data,
+            std::span<const uint32_t>(mesh.index_data).subspan(lods[level].index_offset, lods[level].index_count)
+        };
+    }
+
+    Mesh<vertex_type> mesh;
+    std::vector<MeshLod> lods;
+};
+
+template <typename VertexT>
+LodMesh<VertexT> generate_lods(Mesh<VertexT> mesh, const LodSettings& settings = {}) {
+    auto positions = std::vector<glm::vec3>{};
+    positions.reserve(mesh.vertex_data.size());
+    for (const auto& vert : mesh.vertex_data) {
+        positions.push_back(vert.pos);
+    }
+
+    auto ret = LodMesh<VertexT>{};
+    ret.lods.push_back(MeshLod{0, mesh.index_data.size(), 0.f});
+    auto all_indices = mesh.index_data;
+    auto triangle_count = static_cast<float>(mesh.index_data.size()/3);
+    for (auto target : settings.reduction_targets) {
+        auto target_count = static_cast<size_t>(triangle_count*target)*3;
+        auto error = 0.f;
+        // always simplify the full mesh, so the error is relative to it
+        auto indices = simplify(mesh.index_data, positions, target_count, &error);
+        auto prev_count = static_cast<float>(ret.lods.back().index_count);
+        if (static_cast<float>(indices.size()) > prev_count*(1.f-settings.min_reduction)) {
+            break;
+        }
+        optimize_vertex_cache(indices, positions.size());
+        ret.lods.push_back(MeshLod{all_indices.size(), indices.size(), std::max(error, ret.lods.back().error)});
+        all_indices.insert(all_indices.end(), indices.begin(), indices.end());
+    }
+
+    mesh.index_data = std::move(all_indices);
+    ret.mesh = std::move(mesh);
+    return ret;
+}
+
+// Picks the coarsest level whose error, projected to the screen at the
+// distance of the closest point of `bounds`, stays below `max_screen_error`
+// pixels.
+inline size_t select_lod(
+        std::span<const MeshLod> lods,
+        const BoundingSphere& bounds,
+        const Camera& cam,
+        float viewport_height,
+        float max_screen_error) noexcept {
+    auto dist = std::max(glm::length(bounds.center - cam.pos) - bounds.radius, cam.clip_dist.first);
+    // pixels per mesh unit at distance 1
+    auto proj_scale = viewport_height / (2.f*std::tan(glm::radians(cam.fov)*.5f));
+    for (auto level = lods.size(); level > 1; --level) {
+        if (lods[level-1].error*proj_scale/dist <= max_screen_error) {
+            return level-1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,103 @@
+#include "mapped_file.h"
+
+#include <string>
+using namespace std::string_literals;
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "utils.h"
+
+#ifdef _WIN32
+
+MappedFile::MappedFile(const std::filesystem::path& fpath) {
+    auto file = CreateFileW(
+        fpath.c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+        nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw GLSBError(("Error opening file: "s + fpath.string()).c_str());
+    }
+
+    auto size = LARGE_INTEGER{};
+    if (!GetFileSizeEx(file, &size)) {
+        CloseHandle(file);
+        throw GLSBError(("Error reading file size: "s + fpath.string()).c_str());
+    }
+    size_ = static_cast<size_t>(size.QuadPart);
+    if (size_ == 0) {
+        CloseHandle(file);
+        return;
+    }
+
+    auto mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr) {
+        throw GLSBError(("Error mapping file: "s + fpath.string()).c_str());
+    }
+    data_ = static_cast<const std::byte*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    CloseHandle(mapping);
+    if (data_ == nullptr) {
+        throw GLSBError(("Error mapping file: "s + fpath.string()).c_str());
+    }
+}
+
+void
+MappedFile::unmap() noexcept {
+    if (data_ != nullptr) {
+        UnmapViewOfFile(data_);
+    }
+}
+
+#else
+
+MappedFile::MappedFile(const std::filesystem::path& fpath) {
+    auto fd = open(fpath.c_str(), O_RDONLY);
+    if (fd == -1) {
+        throw GLSBError(("Error opening file: "s + fpath.string()).c_str());
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        close(fd);
+        throw GLSBError(("Error reading file size: "s + fpath.string()).c_str());
+    }
+    size_ = static_cast<size_t>(st.st_size);
+    if (size_ == 0) {
+        close(fd);
+        return;
+    }
+
+    auto ptr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (ptr == MAP_FAILED) {
+        size_ = 0;
+        throw GLSBError(("Error mapping file: "s + fpath.string()).c_str());
+    }
+    data_ = static_cast<const std::byte*>(ptr);
+}
+
+void
+MappedFile::unmap() noexcept {
+    if (data_ != nullptr) {
+        munmap(const_cast<std::byte*>(data_), size_);
+    }
+}
+
+#endif
+
+MappedFile::~MappedFile() {
+    unmap();
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <utility>
+
+// Read-only memory mapping of a whole file.
+class MappedFile {
+    public:
+        MappedFile() = default;
+        MappedFile(const std::filesystem::path& fpath);
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        MappedFile(MappedFile&& other) noexcept :
+            data_{std::exchange(other.data_, nullptr)},
+            size_{std::exchange(other.size_, 0)} {}
+        MappedFile& operator=(MappedFile&& other) noexcept {
+            if (this != &other) {
+                unmap();
+                data_ = std::exchange(other.data_, nullptr);
+                size_ = std::exchange(other.size_, 0);
+            }
+            return *this;
+        }
+
+        const std::byte* data() const noexcept {
+            return data_;
+        }
+
+        size_t size() const noexcept {
+            return size_;
+        }
+
+        std::span<const std::byte> bytes() const noexcept {
+            return {data_, size_};
+        }
+    private:
+        void unmap() noexcept;
+
+        const std::byte* data_ = nullptr;
+        size_t size_ = 0;
+};
@@ -0,0 +1,357 @@
+#include "mesh.h"
+#include "mesh_cache.h"
+#include "mesh_optimizer.h"
+#include "obj_parser.h"
+
+#include <algorithm>
+#include <cassert>
+#include <fstream>
+#include <string>
+using namespace std::string_literals;
+
+#define TINYOBJLOADER_IMPLEMENTATION
+#include <tiny_obj_loader.h>
+
+#include <spdlog/spdlog.h>
+
+namespace {
+
+struct ObjIndexKey {
+    int vertex_index;
+    int normal_index;
+    int texcoord_index;
+
+    bool operator==(const ObjIndexKey&) const noexcept = default;
+};
+
+struct ObjIndexKeyHash {
+    size_t operator()(const ObjIndexKey& key) const noexcept {
+        auto seed = std::hash<int>{}(key.vertex_index);
+        seed = details::hash_combine(seed, std::hash<int>{}(key.normal_index));
+        seed = details::hash_combine(seed, std::hash<int>{}(key.texcoord_index));
+        return seed;
+    }
+};
+
+// rough size of an entry in the welding lookup, including the node overhead
+constexpr size_t lookup_entry_size = sizeof(ObjIndexKey) + sizeof(uint32_t) + 4*sizeof(void*);
+
+// allocated for the attribute arrays
+size_t
+attribute_bytes(const tinyobj::attrib_t& attrib) noexcept {
+    return (attrib.vertices.capacity() + attrib.normals.capacity() + attrib.texcoords.capacity())*sizeof(tinyobj::real_t);
+}
+
+Vertex
+make_vertex(const tinyobj::attrib_t& attrib, const tinyobj::index_t& idx) {
+    assert(idx.vertex_index >= 0);
+    assert(idx.normal_index >= 0);
+    assert(idx.texcoord_index >= 0);
+    auto vert_idx = static_cast<size_t>(idx.vertex_index);
+    auto norm_idx = static_cast<size_t>(idx.normal_index);
+    auto tex_coord_idx = static_cast<size_t>(idx.texcoord_index);
+    return Vertex{
+        {
+            attrib.vertices[(vert_idx*3) + 0],
+            attrib.vertices[(vert_idx*3) + 1],
+            attrib.vertices[(vert_idx*3) + 2],
+        }, {
+            attrib.normals[(norm_idx*3) + 0],
+            attrib.normals[(norm_idx*3) + 1],
+            attrib.normals[(norm_idx*3) + 2],
+        }, {
+            attrib.texcoords[(tex_coord_idx*2) + 0],
+            1.f - attrib.texcoords[(tex_coord_idx*2) + 1],
+        }
+    };
+}
+
+}
+
+Mesh<Vertex>
+generate_quad(float xscale, float yscale) {
+    auto x_half = xscale/2.f;
+    auto y_half = yscale/2.f;
+    return Mesh<Vertex>{
+        {
+            {{-x_half, -y_half, 0.f}, {0.f, 0.f, 1.0f}, {0.0f, 0.0f}},
+            {{ x_half, -y_half, 0.f}, {0.f, 0.f, 1.0f}, {1.0f, 0.0f}},
+            {{ x_half,  y_half, 0.f}, {0.f, 0.f, 1.0f}, {1.0f, 1.0f}},
+            {{-x_half,  y_half, 0.f}, {0.f, 0.f, 1.0f}, {0.0f, 1.0f}},
+        },
+        {0, 1, 2, 2, 3, 0}
+    };
+}
+
+Mesh<Vertex>
+generate_icosphere(unsigned subdivisions) {
+    const auto t = (1.f + std::sqrt(5.f))/2.f;
+    auto positions = std::vector<glm::vec3>{
+        {-1.f, t, 0.f}, {1.f, t, 0.f}, {-1.f, -t, 0.f}, {1.f, -t, 0.f},
+        {0.f, -1.f, t}, {0.f, 1.f, t}, {0.f, -1.f, -t}, {0.f, 1.f, -t},
+        {t, 0.f, -1.f}, {t, 0.f, 1.f}, {-t, 0.f, -1.f}, {-t, 0.f, 1.f},
+    };
+    for (auto& pos : positions) {
+        pos = glm::normalize(pos);
+    }
+    auto indices = std::vector<uint32_t>{
+        0, 11, 5,   0, 5, 1,    0, 1, 7,    0, 7, 10,   0, 10, 11,
+        1, 5, 9,    5, 11, 4,   11, 10, 2,  10, 7, 6,   7, 1, 8,
+        3, 9, 4,    3, 4, 2,    3, 2, 6,    3, 6, 8,    3, 8, 9,
+        4, 9, 5,    2, 4, 11,   6, 2, 10,   8, 6, 7,    9, 8, 1,
+    };
+
+    for (unsigned level=0; level<subdivisions; ++level) {
+        // the midpoint of each edge, shared by the two faces on it
+        auto midpoints = std::unordered_map<uint64_t, uint32_t>{};
+        auto midpoint = [&](uint32_t a, uint32_t b) {
+            auto key = (uint64_t{std::min(a, b)} << 32) | std::max(a, b);
+            auto [it, is_new] = midpoints.try_emplace(key, static_cast<uint32_t>(positions.size()));
+            if (is_new) {
+                positions.push_back(glm::normalize(positions[a] + positions[b]));
+            }
+            return it->second;
+        };
+
+        auto subdivided = std::vector<uint32_t>{};
+        subdivided.reserve(indices.size()*4);
+        for (size_t i=0; i<indices.size(); i+=3) {
+            auto a = indices[i];
+            auto b = indices[i + 1];
+            auto c = indices[i + 2];
+            auto ab = midpoint(a, b);
+            auto bc = midpoint(b, c);
+            auto ca = midpoint(c, a);
+            subdivided.insert(subdivided.end(), {a, ab, ca, b, bc, ab, c, ca, bc, ab, bc, ca});
+        }
+        indices = std::move(subdivided);
+    }
+
+    // the faces cut into the unit sphere, push them out until none does
+    auto min_dist = 1.f;
+    for (size_t i=0; i<indices.size(); i+=3) {
+        const auto& a = positions[indices[i]];
+        auto n = glm::normalize(glm::cross(positions[indices[i + 1]] - a, positions[indices[i + 2]] - a));
+        min_dist = std::min(min_dist, glm::dot(n, a));
+    }
+
+    auto mesh = Mesh<Vertex>{};
+    mesh.vertex_data.reserve(positions.size());
+    for (const auto& pos : positions) {
+        mesh.vertex_data.push_back(Vertex{pos/min_dist, pos, {0.f, 0.f}});
+    }
+    mesh.index_data = std::move(indices);
+    return mesh;
+}
+
+Mesh<Vertex>
+load_obj(const std::filesystem::path& fpath, const ObjLoadOptions& opts, WeldStats* stats) {
+    auto cache_path = mesh_cache_path(fpath);
+    auto options_hash = obj_options_hash(opts);
+    if (opts.use_cache && is_mesh_cache_fresh(cache_path, fpath)) {
+        if (auto cached = map_mesh_cache<Vertex>(cache_path, options_hash)) {
+            auto mesh = cached->to_mesh();
+            spdlog::info(
+                "loaded \"{}\" from cache: {} vertices, {} indices",
+                fpath.string(),
+                mesh.vertex_data.size(),
+                mesh.index_data.size());
+            if (stats) {
+                *stats = WeldStats{cached->corner_count(), mesh.vertex_data.size()};
+            }
+            return mesh;
+        }
+    }
+
+    auto attrib = tinyobj::attrib_t{};
+    auto shapes = std::vector<tinyobj::shape_t>{};
+
+    if (opts.use_tinyobjloader) {
+        auto materials = std::vector<tinyobj::material_t>{};
+        auto err = std::string{};
+
+        auto ifs = std::ifstream(fpath);
+
+        if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &err, &ifs)) {
+            throw GLSBError(("Error loading obj file: "s + err).c_str());
+        }
+    } else {
+        try {
+            parse_obj_file(fpath, attrib, shapes, opts.parser_threads);
+        }
+        catch (const GLSBError& ex) {
+            throw GLSBError(("Error loading obj file: "s + ex.what()).c_str());
+        }
+    }
+
+    auto corner_count = size_t{0};
+    for (const auto& shape : shapes) {
+        corner_count += shape.mesh.indices.size();
+    }
+
+    auto mesh = Mesh<Vertex>{};
+    mesh.index_data.reserve(corner_count);
+
+    if (opts.weld) {
+        auto lookup = std::unordered_map<ObjIndexKey, uint32_t, ObjIndexKeyHash>{};
+        lookup.reserve(corner_count);
+        for (const auto& shape : shapes) {
+            for (const auto& idx : shape.mesh.indices) {
+                auto key = ObjIndexKey{idx.vertex_index, idx.normal_index, idx.texcoord_index};
+                auto [it, inserted] = lookup.try_emplace(key, static_cast<uint32_t>(mesh.vertex_data.size()));
+                if (inserted) {
+                    mesh.vertex_data.push_back(make_vertex(attrib, idx));
+                }
+                mesh.index_data.push_back(it->second);
+            }
+        }
+    } else {
+        mesh.vertex_data.reserve(corner_count);
+        for (const auto& shape : shapes) {
+            for (const auto& idx : shape.mesh.indices) {
+                mesh.vertex_data.push_back(make_vertex(attrib, idx));
+                mesh.index_data.push_back(static_cast<uint32_t>(mesh.index_data.size()));
+            }
+        }
+    }
+
+    if (opts.weld_epsilon > 0.f) {
+        weld_vertices(mesh, opts.weld_epsilon);
+    }
+
+    spdlog::info(
+        "loaded \"{}\": {} vertices ({} before welding), {} indices",
+        fpath.string(),
+        mesh.vertex_data.size(),
+        corner_count,
+        mesh.index_data.size());
+    if (stats) {
+        *stats = WeldStats{corner_count, mesh.vertex_data.size()};
+    }
+
+    if (opts.optimize) {
+        auto opt_stats = optimize_mesh(mesh);
+        spdlog::info(
+            "optimized \"{}\": ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}",
+            fpath.string(),
+            opt_stats.before.acmr,
+            opt_stats.after.acmr,
+            opt_stats.before.atvr,
+            opt_stats.after.atvr);
+    }
+
+    if (opts.use_cache) {
+        try {
+            write_mesh_cache(cache_path, mesh.view(), options_hash, corner_count);
+        }
+        catch (const std::exception& ex) {
+            spdlog::warn("could not write mesh cache \"{}\": {}", cache_path.string(), ex.what());
+        }
+    }
+
+    return mesh;
+}
+
+ObjStreamStats
+stream_obj(const std::filesystem::path& fpath, MeshSink& sink, const ObjStreamOptions& opts) {
+    // a sixteenth for the text, as the parsed faces may be larger than it, a
+    // quarter for the batch, the rest for the attribute arrays
+    auto budget = std::max(opts.memory_budget, obj_min_stream_budget);
+    auto chunk_size = budget/16;
+    auto batch_budget = budget/4;
+
+    auto stats = ObjStreamStats{};
+    auto attrib = tinyobj::attrib_t{};
+    auto batch = Mesh<Vertex>{};
+    auto lookup = std::unordered_map<ObjIndexKey, uint32_t, ObjIndexKeyHash>{};
+
+    // worst case growth of a batch by one triangle, with a lookup entry and
+    // bucket per corner when welding
+    auto triangle_bytes = 3*(sizeof(Vertex) + sizeof(uint32_t));
+    if (opts.weld) {
+        triangle_bytes += 3*(lookup_entry_size + sizeof(void*));
+    }
+    // reserved once and kept by `flush`, so the batch never reallocates
+    auto batch_corners = 3*(batch_budget/triangle_bytes);
+    batch.vertex_data.reserve(batch_corners);
+    batch.index_data.reserve(batch_corners);
+    if (opts.weld) {
+        lookup.reserve(batch_corners);
+    }
+
+    auto batch_bytes = [&batch, &lookup]() {
+        return batch.vertex_data.capacity()*sizeof(Vertex) +
+            batch.index_data.capacity()*sizeof(uint32_t) +
+            lookup.size()*lookup_entry_size +
+            lookup.bucket_count()*sizeof(void*);
+    };
+    // of a full batch
+    auto max_batch_bytes = batch_bytes() + (opts.weld ? batch_corners*lookup_entry_size : 0);
+
+    auto flush = [&]() {
+        if (batch.index_data.empty()) {
+            return;
+        }
+        for (auto& idx : batch.index_data) {
+            idx += static_cast<uint32_t>(stats.vertex_count);
+        }
+        sink.append(batch.vertex_data, batch.index_data);
+
+        stats.vertex_count += batch.vertex_data.size();
+        stats.index_count += batch.index_data.size();
+        ++stats.batch_count;
+        batch.vertex_data.clear();
+        batch.index_data.clear();
+        lookup.clear();
+    };
+
+    auto on_faces = [&](const tinyobj::attrib_t& attributes, std::span<const tinyobj::index_t> corners) {
+        auto piece_bytes = chunk_size + corners.size_bytes() + attribute_bytes(attributes);
+        if (piece_bytes + max_batch_bytes > budget) {
+            throw GLSBError((
+                "the attributes read so far ("s + std::to_string(attribute_bytes(attributes)/1024) +
+                " KiB) exceed the memory budget of " + std::to_string(budget/1024) + " KiB").c_str());
+        }
+        for (size_t i=0; i<corners.size(); i+=3) {
+            // triangles are never split between batches
+            if (batch.index_data.size() + 3 > batch_corners) {
+                flush();
+            }
+            for (size_t k=0; k<3; ++k) {
+                const auto& idx = corners[i+k];
+                if (opts.weld) {
+                    auto key = ObjIndexKey{idx.vertex_index, idx.normal_index, idx.texcoord_index};
+                    auto [it, inserted] = lookup.try_emplace(key, static_cast<uint32_t>(batch.vertex_data.size()));
+                    if (inserted) {
+                        batch.vertex_data.push_back(make_vertex(attributes, idx));
+                    }
+                    batch.index_data.push_back(it->second);
+                } else {
+                    batch.index_data.push_back(static_cast<uint32_t>(batch.vertex_data.size()));
+                    batch.vertex_data.push_back(make_vertex(attributes, idx));
+                }
+            }
+        }
+        stats.peak_bytes = std::max(stats.peak_bytes, piece_bytes + batch_bytes());
+    };
+
+    try {
+        parse_obj_stream(fpath, attrib, chunk_size, on_faces);
+    }
+    catch (const GLSBError& ex) {
+        throw GLSBError(("Error loading obj file: "s + ex.what()).c_str());
+    }
+    flush();
+    sink.finish();
+
+    stats.attribute_bytes = attribute_bytes(attrib);
+    spdlog::info(
+        "streamed \"{}\": {} vertices, {} indices in {} batches, peak {} KiB ({} KiB attributes)",
+        fpath.string(),
+        stats.vertex_count,
+        stats.index_count,
+        stats.batch_count,
+        stats.peak_bytes/1024,
+        stats.attribute_bytes/1024);
+    return stats;
+}
@@ -1,18 +1,18 @@
 #pragma once
 
+#include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <filesystem>
-#include <fstream>
-#include <string>
-using namespace std::string_literals;
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
 #include <vector>
 
-#define TINYOBJLOADER_IMPLEMENTATION
-#include <tiny_obj_loader.h>
-
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
 
-#include "renderer.h"
 #include "shader.h"
 #include "utils.h"
 
@@ -36,6 +36,13 @@ struct Vertex {
     }
 };
 
+// Transforms positions by `tmat` and normals by its inverse transpose, like
+// `Vertex::transform`, but computes the normal matrix only once and processes
+// several vertices per iteration with SSE/AVX where available.
+void transform_vertices(std::span<Vertex> vertices, const glm::mat4& tmat) noexcept;
+// portable implementation of `transform_vertices`
+void transform_vertices_scalar(std::span<Vertex> vertices, const glm::mat4& tmat) noexcept;
+
 struct FlatVertex {
     glm::vec3 pos;
     glm::vec4 color;
@@ -52,6 +59,15 @@ struct FlatVertex {
     }
 };
 
+// non-owning view on vertex and index data, e.g. of a `Mesh` or a mapped mesh cache
+template <typename VertexT>
+struct MeshView {
+    using vertex_type = VertexT;
+
+    std::span<const vertex_type> vertex_data;
+    std::span<const uint32_t> index_data;
+};
+
 template <typename VertexT>
 struct Mesh {
     using vertex_type = VertexT;
@@ -60,66 +76,175 @@ struct Mesh {
     std::vector<uint32_t> index_data;
 
     Mesh<vertex_type>& transform(glm::mat4 tmat) noexcept {
-        for (auto& vert : vertex_data) {
-            vert.transform(tmat);
+        if constexpr (std::is_same_v<vertex_type, Vertex>) {
+            transform_vertices(vertex_data, tmat);
+        } else {
+            for (auto& vert : vertex_data) {
+                vert.transform(tmat);
+            }
         }
         return *this;
     }
+
+    MeshView<vertex_type> view() const noexcept {
+        return {vertex_data, index_data};
+    }
+};
+
+struct WeldStats {
+    size_t vertices_before;
+    size_t vertices_after;
 };
 
-Mesh<Vertex> generate_quad(float xscale, float yscale) {
-    auto x_half = xscale/2.f;
-    auto y_half = yscale/2.f;
-    return Mesh<Vertex>{
-        {
-            {{-x_half, -y_half, 0.f}, {0.f, 0.f, 1.0f}, {0.0f, 0.0f}},
-            {{ x_half, -y_half, 0.f}, {0.f, 0.f, 1.0f}, {1.0f, 0.0f}},
-            {{ x_half,  y_half, 0.f}, {0.f, 0.f, 1.0f}, {1.0f, 1.0f}},
-            {{-x_half,  y_half, 0.f}, {0.f, 0.f, 1.0f}, {0.0f, 1.0f}},
-        },
-        {0, 1, 2, 2, 3, 0}
-    };
+namespace details {
+
+inline size_t hash_combine(size_t seed, size_t val) noexcept {
+    return seed ^ (val + 0x9e3779b97f4a7c15ull + (seed << 6) + (seed >> 2));
 }
 
-Mesh<Vertex> load_obj(const std::filesystem::path& fpath) {
-    auto attrib = tinyobj::attrib_t{};
-    auto shapes = std::vector<tinyobj::shape_t>{};
-    auto materials = std::vector<tinyobj::material_t>{};
-    auto err = std::string{};
+template <typename VertexT>
+struct QuantizedVertexKey {
+    static constexpr size_t component_count = sizeof(VertexT)/sizeof(float);
 
-    auto ifs = std::ifstream(fpath);
+    int64_t components[component_count];
+
+    bool operator==(const QuantizedVertexKey& other) const noexcept {
+        return std::memcmp(components, other.components, sizeof(components)) == 0;
+    }
+};
 
-    if (!tinyobj::LoadObj(&attrib, &shapes, &materials, &err, &ifs)) {
-        throw GLSBError(("Error loading obj file: "s + err).c_str());
+template <typename VertexT>
+struct QuantizedVertexKeyHash {
+    size_t operator()(const QuantizedVertexKey<VertexT>& key) const noexcept {
+        auto seed = size_t{0};
+        for (auto comp : key.components) {
+            seed = hash_combine(seed, std::hash<int64_t>{}(comp));
+        }
+        return seed;
     }
+};
+
+}
 
-    auto mesh = Mesh<Vertex>{};
-
-    for (const auto& shape : shapes) {
-        for (const auto& idx : shape.mesh.indices) {
-            assert(idx.vertex_index >= 0);
-            assert(idx.normal_index >= 0);
-            assert(idx.texcoord_index >= 0);
-            auto vert_idx = static_cast<size_t>(idx.vertex_index);
-            auto norm_idx = static_cast<size_t>(idx.normal_index);
-            auto tex_coord_idx = static_cast<size_t>(idx.texcoord_index);
-            mesh.vertex_data.emplace_back(Vertex{
-                {
-                    attrib.vertices[(vert_idx*3) + 0],
-                    attrib.vertices[(vert_idx*3) + 1],
-                    attrib.vertices[(vert_idx*3) + 2],
-                }, {
-                    attrib.normals[(norm_idx*3) + 0],
-                    attrib.normals[(norm_idx*3) + 1],
-                    attrib.normals[(norm_idx*3) + 2],
-                }, {
-                    attrib.texcoords[(tex_coord_idx*2) + 0],
-                    1.f - attrib.texcoords[(tex_coord_idx*2) + 1],
-                }
-            });
-            mesh.index_data.push_back(static_cast<uint32_t>(mesh.index_data.size()));
+// Merges vertices whose components are equal after snapping them to a grid of
+// size `epsilon` (or bitwise equal for `epsilon == 0`) and remaps `index_data`.
+template <typename VertexT>
+WeldStats weld_vertices(Mesh<VertexT>& mesh, float epsilon = 0.f) {
+    static_assert(std::is_trivially_copyable_v<VertexT>);
+    static_assert(sizeof(VertexT) % sizeof(float) == 0, "vertex has to consist of floats only");
+    using key_type = details::QuantizedVertexKey<VertexT>;
+
+    auto stats = WeldStats{mesh.vertex_data.size(), 0};
+
+    auto lookup = std::unordered_map<key_type, uint32_t, details::QuantizedVertexKeyHash<VertexT>>{};
+    lookup.reserve(mesh.vertex_data.size());
+    auto remap = std::vector<uint32_t>(mesh.vertex_data.size());
+    auto welded = std::vector<VertexT>{};
+    welded.reserve(mesh.vertex_data.size());
+
+    for (size_t i=0; i<mesh.vertex_data.size(); ++i) {
+        float comps[key_type::component_count];
+        std::memcpy(comps, &mesh.vertex_data[i], sizeof(VertexT));
+
+        auto key = key_type{};
+        for (size_t c=0; c<key_type::component_count; ++c) {
+            if (epsilon > 0.f) {
+                key.components[c] = static_cast<int64_t>(std::floor(comps[c]/epsilon + .5f));
+            } else {
+                // -0.f and 0.f should still be welded
+                auto bits = uint32_t{};
+                auto val = (comps[c] == 0.f) ? 0.f : comps[c];
+                std::memcpy(&bits, &val, sizeof(bits));
+                key.components[c] = bits;
+            }
         }
+
+        auto [it, inserted] = lookup.try_emplace(key, static_cast<uint32_t>(welded.size()));
+        if (inserted) {
+            welded.push_back(mesh.vertex_data[i]);
+        }
+        remap[i] = it->second;
+    }
+
+    for (auto& idx : mesh.index_data) {
+        idx = remap[idx];
     }
+    mesh.vertex_data = std::move(welded);
 
-    return mesh;
+    stats.vertices_after = mesh.vertex_data.size();
+    return stats;
 }
+
+struct ObjLoadOptions {
+    // share one vertex between all face corners referencing the same
+    // (position, normal, texcoord) index triple
+    bool weld = true;
+    // if > 0, additionally merge vertices whose attributes are equal after
+    // quantization to this grid size (see `weld_vertices`)
+    float weld_epsilon = 0.f;
+    // reorder triangles and vertices for post-transform cache, overdraw and
+    // vertex fetch efficiency (see mesh_optimizer.h)
+    bool optimize = true;
+    // load from / store to a binary cache next to the .obj file (see mesh_cache.h)
+    bool use_cache = true;
+    // threads for parsing the .obj file, 0 uses one per hardware thread
+    unsigned parser_threads = 0;
+    // parse with tinyobjloader's (single threaded) parser instead of `parse_obj`
+    bool use_tinyobjloader = false;
+};
+
+Mesh<Vertex> generate_quad(float xscale, float yscale);
+
+// Sphere around the origin made by subdividing an icosahedron, e.g. a light
+// volume. Its faces lie on or outside the unit sphere, so it covers all of
+// it; normals point outwards.
+Mesh<Vertex> generate_icosphere(unsigned subdivisions);
+
+Mesh<Vertex> load_obj(
+    const std::filesystem::path& fpath,
+    const ObjLoadOptions& opts = {},
+    WeldStats* stats = nullptr);
+
+// Receives the vertex/index batches of `stream_obj`. Indices are absolute:
+// they count the vertices of all preceding batches.
+class MeshSink {
+    public:
+        virtual ~MeshSink() = default;
+
+        virtual void append(std::span<const Vertex> vertices, std::span<const uint32_t> indices) = 0;
+        // called once after the last batch
+        virtual void finish() {}
+};
+
+inline constexpr size_t obj_min_stream_budget = 64*1024;
+
+struct ObjStreamOptions {
+    // bound for the memory used for the text being parsed, its faces, the
+    // batch being assembled and the attribute arrays
+    size_t memory_budget = 64*1024*1024;
+    // share vertices between face corners with the same index triple, only
+    // within a batch
+    bool weld = true;
+};
+
+struct ObjStreamStats {
+    size_t vertex_count;
+    size_t index_count;
+    size_t batch_count;
+    // largest working set accounted for by `ObjStreamOptions::memory_budget`,
+    // including the attributes
+    size_t peak_bytes;
+    // allocated for the attribute arrays, kept for the whole file as faces
+    // may refer to any preceding attribute
+    size_t attribute_bytes;
+};
+
+// Imports `fpath` piece by piece and passes the resulting vertices and
+// indices to `sink` in batches, so the whole mesh is never held in memory.
+// Unlike `load_obj` there is no welding across batches, no optimization
+// and no caching (see `MeshCacheSink` for the latter). The attributes have to
+// fit in the budget as well, throws `GLSBError` once they outgrow it.
+ObjStreamStats stream_obj(
+    const std::filesystem::path& fpath,
+    MeshSink& sink,
+    const ObjStreamOptions& opts = {});
@@ -0,0 +1,264 @@
+#include "mesh_cache.h"
+
+#include <cassert>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+using namespace std::string_literals;
+
+#include <spdlog/spdlog.h>
+
+#include "utils.h"
+
+namespace {
+
+constexpr uint64_t fnv_offset = 0xcbf29ce484222325ull;
+constexpr uint64_t fnv_prime = 0x100000001b3ull;
+
+uint64_t
+fnv1a(uint64_t hash, const void* data, size_t size) noexcept {
+    auto bytes = static_cast<const unsigned char*>(data);
+    for (size_t i=0; i<size; ++i) {
+        hash = (hash ^ bytes[i]) * fnv_prime;
+    }
+    return hash;
+}
+
+template <typename T>
+uint64_t
+fnv1a(uint64_t hash, const T& val) noexcept {
+    static_assert(std::is_trivially_copyable_v<T>);
+    return fnv1a(hash, &val, sizeof(T));
+}
+
+constexpr uint64_t
+align_up(uint64_t val, uint64_t alignment) noexcept {
+    return (val + alignment - 1) / alignment * alignment;
+}
+
+MeshCacheHeader
+make_header(uint64_t layout_hash, uint64_t options_hash, size_t vertex_size) noexcept {
+    auto hdr = MeshCacheHeader{};
+    std::memcpy(hdr.magic, mesh_cache_magic, sizeof(hdr.magic));
+    hdr.version = mesh_cache_version;
+    hdr.byte_order = mesh_cache_byte_order;
+    hdr.layout_hash = layout_hash;
+    hdr.options_hash = options_hash;
+    hdr.vertex_size = static_cast<uint32_t>(vertex_size);
+    hdr.vertex_offset = align_up(sizeof(MeshCacheHeader), mesh_cache_alignment);
+    return hdr;
+}
+
+void
+write_padding(std::ofstream& ofs, uint64_t target) {
+    static constexpr char zeros[mesh_cache_alignment] = {};
+    auto pos = static_cast<uint64_t>(ofs.tellp());
+    assert(target >= pos);
+    assert(target - pos <= sizeof(zeros));
+    ofs.write(zeros, static_cast<std::streamsize>(target - pos));
+}
+
+}
+
+uint64_t
+vertex_layout_hash(const std::vector<VertexDescriptor>& descs, size_t vertex_size) noexcept {
+    auto hash = fnv1a(fnv_offset, uint64_t{vertex_size});
+    for (const auto& desc : descs) {
+        hash = fnv1a(hash, desc.name, std::strlen(desc.name));
+        hash = fnv1a(hash, desc.count);
+        hash = fnv1a(hash, desc.stride);
+        hash = fnv1a(hash, uint64_t{desc.offset});
+        hash = fnv1a(hash, desc.is_normalized);
+        hash = fnv1a(hash, desc.type);
+    }
+    return hash;
+}
+
+uint64_t
+obj_options_hash(const ObjLoadOptions& opts) noexcept {
+    auto hash = fnv1a(fnv_offset, opts.weld);
+    hash = fnv1a(hash, opts.weld_epsilon);
+    hash = fnv1a(hash, opts.optimize);
+    return hash;
+}
+
+std::filesystem::path
+mesh_cache_path(const std::filesystem::path& fpath) {
+    auto ret = fpath;
+    ret.replace_extension(".glsbmesh");
+    return ret;
+}
+
+bool
+is_mesh_cache_fresh(const std::filesystem::path& cache, const std::filesystem::path& source) {
+    auto ec = std::error_code{};
+    auto cache_time = std::filesystem::last_write_time(cache, ec);
+    if (ec) {
+        return false;
+    }
+    auto source_time = std::filesystem::last_write_time(source, ec);
+    if (ec) {
+        return false;
+    }
+    return cache_time >= source_time;
+}
+
+void
+write_mesh_cache(
+        const std::filesystem::path& fpath,
+        uint64_t layout_hash,
+        uint64_t options_hash,
+        std::span<const std::byte> vertex_data,
+        size_t vertex_size,
+        std::span<const uint32_t> index_data,
+        size_t corner_count) {
+    assert(vertex_size > 0);
+    assert(vertex_data.size() % vertex_size == 0);
+
+    auto hdr = make_header(layout_hash, options_hash, vertex_size);
+    hdr.vertex_count = vertex_data.size() / vertex_size;
+    hdr.index_count = index_data.size();
+    hdr.corner_count = corner_count;
+    hdr.index_offset = align_up(hdr.vertex_offset + vertex_data.size_bytes(), mesh_cache_alignment);
+
+    // write to a temporary file first, so a concurrent reader never sees a partial cache
+    auto tmp_path = fpath;
+    tmp_path += ".tmp";
+    {
+        auto ofs = std::ofstream(tmp_path, std::ios::binary | std::ios::trunc);
+        if (!ofs) {
+            throw GLSBError(("Error writing mesh cache: "s + tmp_path.string()).c_str());
+        }
+        ofs.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+        write_padding(ofs, hdr.vertex_offset);
+        ofs.write(reinterpret_cast<const char*>(vertex_data.data()), static_cast<std::streamsize>(vertex_data.size_bytes()));
+        write_padding(ofs, hdr.index_offset);
+        ofs.write(reinterpret_cast<const char*>(index_data.data()), static_cast<std::streamsize>(index_data.size_bytes()));
+        if (!ofs) {
+            throw GLSBError(("Error writing mesh cache: "s + tmp_path.string()).c_str());
+        }
+    }
+    std::filesystem::rename(tmp_path, fpath);
+}
+
+MeshCacheSink::MeshCacheSink(const std::filesystem::path& fpath, uint64_t options_hash) :
+        fpath_{fpath},
+        tmp_path_{fpath},
+        index_path_{fpath},
+        hdr_{make_header(vertex_layout_hash(Vertex::get_vertex_desc(), sizeof(Vertex)), options_hash, sizeof(Vertex))} {
+    tmp_path_ += ".tmp";
+    index_path_ += ".idx.tmp";
+    ofs_.open(tmp_path_, std::ios::binary | std::ios::trunc);
+    index_ofs_.open(index_path_, std::ios::binary | std::ios::trunc);
+    if (!ofs_ || !index_ofs_) {
+        throw GLSBError(("Error writing mesh cache: "s + tmp_path_.string()).c_str());
+    }
+    // placeholder, the header is rewritten once the counts are known
+    ofs_.write(reinterpret_cast<const char*>(&hdr_), sizeof(hdr_));
+    write_padding(ofs_, hdr_.vertex_offset);
+}
+
+MeshCacheSink::~MeshCacheSink() {
+    if (!is_finished_) {
+        ofs_.close();
+        index_ofs_.close();
+        auto ec = std::error_code{};
+        std::filesystem::remove(tmp_path_, ec);
+        std::filesystem::remove(index_path_, ec);
+    }
+}
+
+void
+MeshCacheSink::append(std::span<const Vertex> vertices, std::span<const uint32_t> indices) {
+    assert(!is_finished_);
+    ofs_.write(reinterpret_cast<const char*>(vertices.data()), static_cast<std::streamsize>(vertices.size_bytes()));
+    index_ofs_.write(reinterpret_cast<const char*>(indices.data()), static_cast<std::streamsize>(indices.size_bytes()));
+    if (!ofs_ || !index_ofs_) {
+        throw GLSBError(("Error writing mesh cache: "s + tmp_path_.string()).c_str());
+    }
+    hdr_.vertex_count += vertices.size();
+    hdr_.index_count += indices.size();
+    // every corner of the source is one index, welding only merges vertices
+    hdr_.corner_count += indices.size();
+}
+
+void
+MeshCacheSink::finish() {
+    assert(!is_finished_);
+    index_ofs_.close();
+    hdr_.index_offset = align_up(hdr_.vertex_offset + hdr_.vertex_count*hdr_.vertex_size, mesh_cache_alignment);
+    write_padding(ofs_, hdr_.index_offset);
+
+    {
+        auto ifs = std::ifstream(index_path_, std::ios::binary);
+        auto buffer = std::vector<char>(64*1024);
+        while (ifs) {
+            ifs.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+            ofs_.write(buffer.data(), ifs.gcount());
+        }
+    }
+    ofs_.seekp(0);
+    ofs_.write(reinterpret_cast<const char*>(&hdr_), sizeof(hdr_));
+    ofs_.close();
+    if (!ofs_) {
+        throw GLSBError(("Error writing mesh cache: "s + tmp_path_.string()).c_str());
+    }
+
+    std::filesystem::remove(index_path_);
+    std::filesystem::rename(tmp_path_, fpath_);
+    is_finished_ = true;
+}
+
+std::optional<MeshCacheHeader>
+map_mesh_cache(
+        const std::filesystem::path& fpath,
+        uint64_t layout_hash,
+        uint64_t options_hash,
+        size_t vertex_size,
+        MappedFile& file) {
+    try {
+        file = MappedFile(fpath);
+    }
+    catch (const GLSBError&) {
+        return std::nullopt;
+    }
+
+    auto hdr = MeshCacheHeader{};
+    if (file.size() < sizeof(hdr)) {
+        spdlog::warn("mesh cache \"{}\" is truncated", fpath.string());
+        return std::nullopt;
+    }
+    std::memcpy(&hdr, file.data(), sizeof(hdr));
+
+    if (std::memcmp(hdr.magic, mesh_cache_magic, sizeof(hdr.magic)) != 0 ||
+            hdr.byte_order != mesh_cache_byte_order) {
+        spdlog::warn("\"{}\" is not a mesh cache", fpath.string());
+        return std::nullopt;
+    }
+    if (hdr.version != mesh_cache_version ||
+            hdr.layout_hash != layout_hash ||
+            hdr.options_hash != options_hash ||
+            hdr.vertex_size != vertex_size) {
+        spdlog::info("mesh cache \"{}\" is outdated", fpath.string());
+        return std::nullopt;
+    }
+
+    // Any value may be stored in a corrupt header. The counts are checked
+    // against the space after their offsets, so that neither the sizes nor
+    // the ends computed from them can overflow.
+    auto fits = [&file](uint64_t offset, uint64_t count, uint64_t element_size) {
+        return (offset <= file.size()) && (count <= (file.size() - offset) / element_size);
+    };
+    if ((hdr.vertex_offset % mesh_cache_alignment != 0) ||
+            (hdr.index_offset % mesh_cache_alignment != 0) ||
+            (hdr.vertex_offset < sizeof(hdr)) ||
+            !fits(hdr.vertex_offset, hdr.vertex_count, hdr.vertex_size) ||
+            !fits(hdr.index_offset, hdr.index_count, sizeof(uint32_t)) ||
+            (hdr.index_offset < hdr.vertex_offset + hdr.vertex_count * hdr.vertex_size)) {
+        spdlog::warn("mesh cache \"{}\" is corrupt", fpath.string());
+        return std::nullopt;
+    }
+
+    return hdr;
+}
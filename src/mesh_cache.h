@@ -0,0 +1,167 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "mapped_file.h"
+#include "mesh.h"
+#include "shader.h"
+
+// Binary mesh cache file:
+//
+//   MeshCacheHeader
+//   padding up to `vertex_offset`
+//   vertex_count * vertex_size bytes of vertex data
+//   padding up to `index_offset`
+//   index_count * uint32_t indices
+//
+// Both payloads are aligned to `mesh_cache_alignment`, so they can be handed
+// to `Buffer::set_data` (or used as `VertexT`/`uint32_t` arrays) right from
+// the mapping. All values are stored in host byte order, files written on a
+// host with a different byte order are rejected.
+struct MeshCacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t layout_hash;
+    uint64_t options_hash;
+    uint32_t vertex_size;
+    uint32_t reserved;
+    uint64_t vertex_count;
+    uint64_t index_count;
+    // corners of the source mesh before welding, 0 if unknown
+    uint64_t corner_count;
+    uint64_t vertex_offset;
+    uint64_t index_offset;
+};
+
+inline constexpr char mesh_cache_magic[8] = {'G', 'L', 'S', 'B', 'M', 'E', 'S', 'H'};
+inline constexpr uint32_t mesh_cache_version = 2;
+inline constexpr uint32_t mesh_cache_byte_order = 0x01020304;
+inline constexpr size_t mesh_cache_alignment = 64;
+
+// identifies the memory layout of a vertex type, caches of another layout are rejected
+uint64_t vertex_layout_hash(const std::vector<VertexDescriptor>& descs, size_t vertex_size) noexcept;
+
+// hash of the load options affecting the cached data
+uint64_t obj_options_hash(const ObjLoadOptions& opts) noexcept;
+
+// "foo/bar.obj" => "foo/bar.glsbmesh"
+std::filesystem::path mesh_cache_path(const std::filesystem::path& fpath);
+
+// true if the cache exists and is at least as new as `source`
+bool is_mesh_cache_fresh(const std::filesystem::path& cache, const std::filesystem::path& source);
+
+void write_mesh_cache(
+    const std::filesystem::path& fpath,
+    uint64_t layout_hash,
+    uint64_t options_hash,
+    std::span<const std::byte> vertex_data,
+    size_t vertex_size,
+    std::span<const uint32_t> index_data,
+    size_t corner_count = 0);
+
+// `corner_count`: the corners `mesh` was welded from, see `MeshCacheHeader`
+template <typename VertexT>
+void write_mesh_cache(const std::filesystem::path& fpath, MeshView<VertexT> mesh, uint64_t options_hash = 0, size_t corner_count = 0) {
+    static_assert(std::is_trivially_copyable_v<VertexT>);
+    static_assert(mesh_cache_alignment % alignof(VertexT) == 0);
+    write_mesh_cache(
+        fpath,
+        vertex_layout_hash(VertexT::get_vertex_desc(), sizeof(VertexT)),
+        options_hash,
+        std::as_bytes(mesh.vertex_data),
+        sizeof(VertexT),
+        mesh.index_data,
+        corner_count);
+}
+
+// Writes the batches of `stream_obj` into a mesh cache at `fpath` without
+// holding the mesh in memory. Indices are buffered in a temporary file until
+// the vertex count is known. The cache only replaces `fpath` in `finish`.
+class MeshCacheSink final : public MeshSink {
+    public:
+        MeshCacheSink(const std::filesystem::path& fpath, uint64_t options_hash = 0);
+        ~MeshCacheSink() override;
+
+        MeshCacheSink(const MeshCacheSink&) = delete;
+        MeshCacheSink& operator=(const MeshCacheSink&) = delete;
+
+        void append(std::span<const Vertex> vertices, std::span<const uint32_t> indices) override;
+        void finish() override;
+    private:
+        std::filesystem::path fpath_;
+        std::filesystem::path tmp_path_;
+        std::filesystem::path index_path_;
+        std::ofstream ofs_;
+        std::ofstream index_ofs_;
+        MeshCacheHeader hdr_;
+        bool is_finished_ = false;
+};
+
+// Validated, read-only mapping of a mesh cache; the payload is used in place.
+template <typename VertexT>
+class MappedMesh {
+    public:
+        using vertex_type = VertexT;
+
+        MappedMesh(MappedFile file, const MeshCacheHeader& hdr) :
+                file_{std::move(file)},
+                corner_count_{static_cast<size_t>(hdr.corner_count)} {
+            vertices_ = std::span<const vertex_type>(
+                reinterpret_cast<const vertex_type*>(file_.data() + hdr.vertex_offset),
+                static_cast<size_t>(hdr.vertex_count));
+            indices_ = std::span<const uint32_t>(
+                reinterpret_cast<const uint32_t*>(file_.data() + hdr.index_offset),
+                static_cast<size_t>(hdr.index_count));
+        }
+
+        MeshView<vertex_type> view() const noexcept {
+            return {vertices_, indices_};
+        }
+
+        // before welding, 0 if unknown
+        size_t corner_count() const noexcept {
+            return corner_count_;
+        }
+
+        Mesh<vertex_type> to_mesh() const {
+            return Mesh<vertex_type>{
+                {vertices_.begin(), vertices_.end()},
+                {indices_.begin(), indices_.end()},
+            };
+        }
+    private:
+        MappedFile file_;
+        size_t corner_count_;
+        std::span<const vertex_type> vertices_;
+        std::span<const uint32_t> indices_;
+};
+
+// maps `fpath` and validates its header, returns the header on success
+std::optional<MeshCacheHeader> map_mesh_cache(
+    const std::filesystem::path& fpath,
+    uint64_t layout_hash,
+    uint64_t options_hash,
+    size_t vertex_size,
+    MappedFile& file);
+
+template <typename VertexT>
+std::optional<MappedMesh<VertexT>> map_mesh_cache(const std::filesystem::path& fpath, uint64_t options_hash = 0) {
+    static_assert(std::is_trivially_copyable_v<VertexT>);
+    auto file = MappedFile{};
+    auto hdr = map_mesh_cache(
+        fpath,
+        vertex_layout_hash(VertexT::get_vertex_desc(), sizeof(VertexT)),
+        options_hash,
+        sizeof(VertexT),
+        file);
+    if (!hdr) {
+        return std::nullopt;
+    }
+    return MappedMesh<VertexT>(std::move(file), *hdr);
+}
@@ -0,0 +1,308 @@
+#include "mesh_optimizer.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+namespace {
+
+constexpr uint32_t invalid_index = std::numeric_limits<uint32_t>::max();
+
+// Forsyth's tuning values
+constexpr int forsyth_cache_size = 32;
+constexpr float cache_decay_power = 1.5f;
+constexpr float last_triangle_score = .75f;
+constexpr float valence_boost_scale = 2.f;
+constexpr float valence_boost_power = .5f;
+
+float
+forsyth_vertex_score(int cache_pos, uint32_t remaining_triangles) noexcept {
+    if (remaining_triangles == 0) {
+        // no triangle needs this vertex anymore
+        return -1.f;
+    }
+
+    auto score = 0.f;
+    if (cache_pos >= 0) {
+        if (cache_pos < 3) {
+            // used by the last triangle, the score is fixed to not favour
+            // any of its vertices
+            score = last_triangle_score;
+        } else {
+            auto scaler = 1.f / (forsyth_cache_size - 3);
+            score = std::pow(1.f - static_cast<float>(cache_pos - 3) * scaler, cache_decay_power);
+        }
+    }
+    // bonus for vertices with few triangles left, so they get finished first
+    score += valence_boost_scale * std::pow(static_cast<float>(remaining_triangles), -valence_boost_power);
+    return score;
+}
+
+struct TriangleAdjacency {
+    // CSR layout: triangles of vertex v are triangles[offsets[v]..offsets[v]+counts[v]]
+    std::vector<uint32_t> counts;
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> triangles;
+
+    TriangleAdjacency(std::span<const uint32_t> indices, size_t vertex_count) :
+            counts(vertex_count, 0), offsets(vertex_count, 0), triangles(indices.size()) {
+        for (auto idx : indices) {
+            assert(idx < vertex_count);
+            ++counts[idx];
+        }
+        auto offset = uint32_t{0};
+        for (size_t v=0; v<vertex_count; ++v) {
+            offsets[v] = offset;
+            offset += counts[v];
+        }
+        auto fill = counts;
+        std::fill(fill.begin(), fill.end(), 0);
+        for (size_t i=0; i<indices.size(); ++i) {
+            auto v = indices[i];
+            triangles[offsets[v] + fill[v]++] = static_cast<uint32_t>(i/3);
+        }
+    }
+
+    void remove(uint32_t vertex, uint32_t triangle) noexcept {
+        auto begin = triangles.begin() + offsets[vertex];
+        auto end = begin + counts[vertex];
+        auto it = std::find(begin, end, triangle);
+        assert(it != end);
+        std::iter_swap(it, end - 1);
+        --counts[vertex];
+    }
+};
+
+}
+
+VertexCacheStats
+analyze_vertex_cache(std::span<const uint32_t> indices, size_t vertex_count, unsigned cache_size) {
+    assert(cache_size > 0);
+    // timestamp based FIFO: a vertex is cached if it was inserted less than
+    // `cache_size` insertions ago
+    auto timestamps = std::vector<size_t>(vertex_count, 0);
+    auto time = size_t{cache_size + 1};
+    auto transformed = size_t{0};
+
+    for (auto idx : indices) {
+        assert(idx < vertex_count);
+        if (time - timestamps[idx] > cache_size) {
+            timestamps[idx] = time++;
+            ++transformed;
+        }
+    }
+
+    auto stats = VertexCacheStats{transformed, 0.f, 0.f};
+    if (indices.size() >= 3) {
+        stats.acmr = static_cast<float>(transformed) / static_cast<float>(indices.size()/3);
+    }
+    if (vertex_count > 0) {
+        stats.atvr = static_cast<float>(transformed) / static_cast<float>(vertex_count);
+    }
+    return stats;
+}
+
+void
+optimize_vertex_cache(std::span<uint32_t> indices, size_t vertex_count) {
+    assert(indices.size() % 3 == 0);
+    auto triangle_count = indices.size()/3;
+    if (triangle_count == 0) {
+        return;
+    }
+
+    auto input = std::vector<uint32_t>(indices.begin(), indices.end());
+    auto adjacency = TriangleAdjacency(input, vertex_count);
+
+    auto cache_pos = std::vector<int>(vertex_count, -1);
+    auto vertex_scores = std::vector<float>(vertex_count);
+    for (size_t v=0; v<vertex_count; ++v) {
+        vertex_scores[v] = forsyth_vertex_score(-1, adjacency.counts[v]);
+    }
+
+    auto is_emitted = std::vector<bool>(triangle_count, false);
+
+    // three extra slots for the vertices pushed out by the newest triangle
+    auto cache = std::array<uint32_t, forsyth_cache_size + 3>{};
+    auto cache_count = size_t{0};
+    auto new_cache = std::array<uint32_t, forsyth_cache_size + 3>{};
+
+    auto best_triangle = invalid_index;
+    auto scan_pos = size_t{0};
+    auto out = size_t{0};
+
+    for (size_t emitted=0; emitted<triangle_count; ++emitted) {
+        if (best_triangle == invalid_index) {
+            // nothing adjacent to the cache: continue with the next triangle
+            // in input order, isolated triangles all score the same
+            while (is_emitted[scan_pos]) {
+                ++scan_pos;
+            }
+            best_triangle = static_cast<uint32_t>(scan_pos);
+        }
+        assert(best_triangle != invalid_index);
+
+        const auto tri = &input[size_t{best_triangle}*3];
+        indices[out++] = tri[0];
+        indices[out++] = tri[1];
+        indices[out++] = tri[2];
+        is_emitted[best_triangle] = true;
+
+        // move the triangle's vertices to the front of the LRU cache
+        auto new_count = size_t{0};
+        for (size_t k=0; k<3; ++k) {
+            new_cache[new_count++] = tri[k];
+            adjacency.remove(tri[k], best_triangle);
+        }
+        for (size_t c=0; c<cache_count; ++c) {
+            auto v = cache[c];
+            if ((v != tri[0]) && (v != tri[1]) && (v != tri[2])) {
+                new_cache[new_count++] = v;
+            }
+        }
+        std::swap(cache, new_cache);
+        cache_count = new_count;
+
+        // rescore affected vertices and their triangles
+        for (size_t c=0; c<cache_count; ++c) {
+            auto v = cache[c];
+            cache_pos[v] = (c < forsyth_cache_size) ? static_cast<int>(c) : -1;
+            vertex_scores[v] = forsyth_vertex_score(cache_pos[v], adjacency.counts[v]);
+        }
+        best_triangle = invalid_index;
+        auto best_score = -std::numeric_limits<float>::max();
+        for (size_t c=0; c<cache_count; ++c) {
+            auto v = cache[c];
+            auto begin = adjacency.triangles.begin() + adjacency.offsets[v];
+            for (auto it=begin; it!=begin + adjacency.counts[v]; ++it) {
+                // only triangles next to the cache can win, so their
+                // scores are computed on the spot rather than kept up to date
+                auto t = size_t{*it};
+                auto score =
+                    vertex_scores[input[t*3 + 0]] +
+                    vertex_scores[input[t*3 + 1]] +
+                    vertex_scores[input[t*3 + 2]];
+                if (score > best_score) {
+                    best_score = score;
+                    best_triangle = static_cast<uint32_t>(t);
+                }
+            }
+        }
+        cache_count = std::min(cache_count, size_t{forsyth_cache_size});
+    }
+}
+
+void
+optimize_overdraw(std::span<uint32_t> indices, std::span<const glm::vec3> positions, float threshold) {
+    assert(indices.size() % 3 == 0);
+    auto triangle_count = indices.size()/3;
+    if (triangle_count == 0) {
+        return;
+    }
+
+    // split into clusters: at hard boundaries (all three vertices miss the
+    // cache) and at soft boundaries, where the cluster's ACMR is low enough
+    // that starting over costs less than `threshold` allows
+    auto target_acmr = analyze_vertex_cache(indices, positions.size()).acmr * threshold;
+    auto cluster_starts = std::vector<size_t>{0};
+    {
+        auto timestamps = std::vector<size_t>(positions.size(), 0);
+        auto time = size_t{default_vertex_cache_size + 1};
+        auto cluster_misses = size_t{0};
+        auto cluster_begin = size_t{0};
+        for (size_t t=0; t<triangle_count; ++t) {
+            auto misses = size_t{0};
+            for (size_t k=0; k<3; ++k) {
+                auto idx = indices[t*3 + k];
+                if (time - timestamps[idx] > default_vertex_cache_size) {
+                    timestamps[idx] = time++;
+                    ++misses;
+                }
+            }
+
+            auto cluster_size = t - cluster_begin;
+            auto is_hard_boundary = (misses == 3);
+            auto is_soft_boundary = (misses > 0) && (cluster_size > 0) &&
+                (static_cast<float>(cluster_misses) / static_cast<float>(cluster_size) <= target_acmr) &&
+                (cluster_size >= 2*default_vertex_cache_size);
+            if ((t > 0) && (is_hard_boundary || is_soft_boundary)) {
+                cluster_starts.push_back(t);
+                cluster_begin = t;
+                cluster_misses = 0;
+            }
+            cluster_misses += misses;
+        }
+    }
+    auto cluster_count = cluster_starts.size();
+    cluster_starts.push_back(triangle_count);
+
+    // area weighted centroid and normal of every cluster and of the whole mesh
+    auto centroids = std::vector<glm::vec3>(cluster_count, glm::vec3(0.f));
+    auto normals = std::vector<glm::vec3>(cluster_count, glm::vec3(0.f));
+    auto mesh_centroid = glm::vec3(0.f);
+    auto mesh_area = 0.f;
+    for (size_t c=0; c<cluster_count; ++c) {
+        auto cluster_area = 0.f;
+        for (auto t=cluster_starts[c]; t<cluster_starts[c+1]; ++t) {
+            const auto& p0 = positions[indices[t*3 + 0]];
+            const auto& p1 = positions[indices[t*3 + 1]];
+            const auto& p2 = positions[indices[t*3 + 2]];
+            auto normal = glm::cross(p1 - p0, p2 - p0);
+            auto area = glm::length(normal);
+            centroids[c] += (p0 + p1 + p2) * (area / 3.f);
+            normals[c] += normal;
+            cluster_area += area;
+        }
+        mesh_centroid += centroids[c];
+        mesh_area += cluster_area;
+        if (cluster_area > 0.f) {
+            centroids[c] /= cluster_area;
+        }
+        auto len = glm::length(normals[c]);
+        if (len > 0.f) {
+            normals[c] /= len;
+        }
+    }
+    if (mesh_area > 0.f) {
+        mesh_centroid /= mesh_area;
+    }
+
+    // clusters facing away from the center are likely to occlude the others
+    auto sort_keys = std::vector<float>(cluster_count);
+    for (size_t c=0; c<cluster_count; ++c) {
+        sort_keys[c] = glm::dot(centroids[c] - mesh_centroid, normals[c]);
+    }
+    auto order = std::vector<size_t>(cluster_count);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&sort_keys](size_t a, size_t b) {
+        return sort_keys[a] > sort_keys[b];
+    });
+
+    auto input = std::vector<uint32_t>(indices.begin(), indices.end());
+    auto out = indices.begin();
+    for (auto c : order) {
+        out = std::copy(
+            input.begin() + static_cast<ptrdiff_t>(cluster_starts[c]*3),
+            input.begin() + static_cast<ptrdiff_t>(cluster_starts[c+1]*3),
+            out);
+    }
+}
+
+std::vector<uint32_t>
+optimize_vertex_fetch_remap(std::span<uint32_t> indices, size_t vertex_count) {
+    auto new_index = std::vector<uint32_t>(vertex_count, invalid_index);
+    auto remap = std::vector<uint32_t>{};
+    remap.reserve(vertex_count);
+
+    for (auto& idx : indices) {
+        assert(idx < vertex_count);
+        if (new_index[idx] == invalid_index) {
+            new_index[idx] = static_cast<uint32_t>(remap.size());
+            remap.push_back(idx);
+        }
+        idx = new_index[idx];
+    }
+    return remap;
+}
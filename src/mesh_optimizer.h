@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "mesh.h"
+
+// FIFO size used for statistics, matches the post-transform cache of typical GPUs
+inline constexpr unsigned default_vertex_cache_size = 16;
+
+struct VertexCacheStats {
+    size_t vertices_transformed;
+    // average cache miss ratio: transformed vertices per triangle (0.5 - 3)
+    float acmr;
+    // average transform to vertex ratio: transformed vertices per vertex (>= 1)
+    float atvr;
+};
+
+// simulates a FIFO post-transform cache of `cache_size` entries
+VertexCacheStats analyze_vertex_cache(
+    std::span<const uint32_t> indices,
+    size_t vertex_count,
+    unsigned cache_size = default_vertex_cache_size);
+
+// Reorders triangles for post-transform cache reuse (Forsyth's linear-speed
+// vertex cache optimisation).
+void optimize_vertex_cache(std::span<uint32_t> indices, size_t vertex_count);
+
+// Splits the (vertex cache optimized) triangle list into clusters and sorts
+// them so outward facing clusters come first, which reduces overdraw from most
+// view points (Sander et al., "Fast Triangle Reordering for Vertex Locality
+// and Reduced Overdraw"). `threshold` is the ACMR increase relative to the
+// input that is allowed for the reordered index buffer.
+void optimize_overdraw(
+    std::span<uint32_t> indices,
+    std::span<const glm::vec3> positions,
+    float threshold = 1.05f);
+
+// computes the vertex order by first use in `indices` and rewrites the indices,
+// returns the old index of each new vertex; unreferenced vertices are dropped
+std::vector<uint32_t> optimize_vertex_fetch_remap(std::span<uint32_t> indices, size_t vertex_count);
+
+template <typename VertexT>
+void optimize_overdraw(Mesh<VertexT>& mesh, float threshold = 1.05f) {
+    auto positions = std::vector<glm::vec3>{};
+    positions.reserve(mesh.vertex_data.size());
+    for (const auto& vert : mesh.vertex_data) {
+        positions.push_back(vert.pos);
+    }
+    optimize_overdraw(mesh.index_data, positions, threshold);
+}
+
+template <typename VertexT>
+void optimize_vertex_fetch(Mesh<VertexT>& mesh) {
+    auto remap = optimize_vertex_fetch_remap(mesh.index_data, mesh.vertex_data.size());
+    auto vertices = std::vector<VertexT>{};
+    vertices.reserve(remap.size());
+    for (auto old_idx : remap) {
+        vertices.push_back(mesh.vertex_data[old_idx]);
+    }
+    mesh.vertex_data = std::move(vertices);
+}
+
+struct MeshOptimizationStats {
+    VertexCacheStats before;
+    VertexCacheStats after;
+};
+
+// vertex cache, overdraw and vertex fetch optimization in one go
+template <typename VertexT>
+MeshOptimizationStats optimize_mesh(Mesh<VertexT>& mesh, float overdraw_threshold = 1.05f) {
+    auto stats = MeshOptimizationStats{};
+    stats.before = analyze_vertex_cache(mesh.index_data, mesh.vertex_data.size());
+
+    optimize_vertex_cache(mesh.index_data, mesh.vertex_data.size());
+    optimize_overdraw(mesh, overdraw_threshold);
+    optimize_vertex_fetch(mesh);
+
+    stats.after = analyze_vertex_cache(mesh.index_data, mesh.vertex_data.size());
+    return stats;
+}
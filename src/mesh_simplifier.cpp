@@ -0,0 +1,438 @@
+#include "mesh_simplifier.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <unordered_set>
+#include <utility>
+
+namespace {
+
+// border planes are weighted higher than surface planes so that open borders
+// stay in place
+constexpr float border_weight = 10.f;
+// minimum cosine between a triangle normal before and after a collapse
+constexpr float min_normal_cos = .25f;
+constexpr int max_passes = 64;
+
+struct Quadric {
+    float a2, b2, c2;
+    float ab, ac, bc;
+    float ad, bd, cd;
+    float d2;
+    // accumulated area, turns the error into a squared distance
+    float weight;
+
+    static Quadric from_plane(glm::vec3 n, float d, float w) noexcept {
+        return Quadric{
+            w*n.x*n.x, w*n.y*n.y, w*n.z*n.z,
+            w*n.x*n.y, w*n.x*n.z, w*n.y*n.z,
+            w*n.x*d, w*n.y*d, w*n.z*d,
+            w*d*d,
+            w
+        };
+    }
+
+    Quadric& operator+=(const Quadric& other) noexcept {
+        a2 += other.a2; b2 += other.b2; c2 += other.c2;
+        ab += other.ab; ac += other.ac; bc += other.bc;
+        ad += other.ad; bd += other.bd; cd += other.cd;
+        d2 += other.d2;
+        weight += other.weight;
+        return *this;
+    }
+
+    // weighted sum of squared distances of `p` to all planes
+    float eval(glm::vec3 p) const noexcept {
+        auto r = a2*p.x*p.x + b2*p.y*p.y + c2*p.z*p.z;
+        r += 2.f*(ab*p.x*p.y + ac*p.x*p.z + bc*p.y*p.z);
+        r += 2.f*(ad*p.x + bd*p.y + cd*p.z);
+        r += d2;
+        return std::max(r, 0.f);
+    }
+};
+
+enum class VertexKind : uint8_t {
+    // may collapse along any edge
+    Manifold,
+    // on an open border, may only collapse along it
+    Border,
+    Locked,
+};
+
+// between position groups
+struct Collapse {
+    uint32_t src;
+    uint32_t tgt;
+    float cost;
+    // every wedge of `src` has its counterpart at `tgt`
+    bool exact;
+};
+
+uint64_t
+edge_key(uint32_t a, uint32_t b) noexcept {
+    return (uint64_t{a} << 32) | b;
+}
+
+std::unordered_set<uint64_t>
+collect_edges(std::span<const uint32_t> indices) {
+    auto edges = std::unordered_set<uint64_t>{};
+    edges.reserve(indices.size());
+    for (size_t i=0; i<indices.size(); i+=3) {
+        for (size_t k=0; k<3; ++k) {
+            edges.insert(edge_key(indices[i+k], indices[i+(k+1)%3]));
+        }
+    }
+    return edges;
+}
+
+// Attribute seams: several vertices (wedges) at the same position. Each
+// vertex maps to the first one at its position, the simplification runs on
+// these position groups so seams collapse as a whole.
+std::vector<uint32_t>
+position_groups(std::span<const glm::vec3> positions) {
+    auto order = std::vector<uint32_t>(positions.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+        const auto& pa = positions[a];
+        const auto& pb = positions[b];
+        if (pa.x != pb.x) return pa.x < pb.x;
+        if (pa.y != pb.y) return pa.y < pb.y;
+        if (pa.z != pb.z) return pa.z < pb.z;
+        return a < b;
+    });
+    auto groups = std::vector<uint32_t>(positions.size());
+    for (size_t i=0; i<order.size(); ++i) {
+        auto first = ((i > 0) && (positions[order[i-1]] == positions[order[i]])) ? groups[order[i-1]] : order[i];
+        groups[order[i]] = first;
+    }
+    return groups;
+}
+
+// `indices` refer to position groups
+std::vector<VertexKind>
+classify_vertices(
+        std::span<const uint32_t> indices,
+        std::span<const glm::vec3> positions,
+        const std::unordered_set<uint64_t>& edges) {
+    auto kinds = std::vector<VertexKind>(positions.size(), VertexKind::Manifold);
+
+    // open borders: directed edges without their opposite
+    auto border_in = std::vector<uint8_t>(positions.size(), 0);
+    auto border_out = std::vector<uint8_t>(positions.size(), 0);
+    for (size_t i=0; i<indices.size(); i+=3) {
+        for (size_t k=0; k<3; ++k) {
+            auto a = indices[i+k];
+            auto b = indices[i+(k+1)%3];
+            if (!edges.contains(edge_key(b, a))) {
+                border_out[a] = static_cast<uint8_t>(std::min(border_out[a]+1, 2));
+                border_in[b] = static_cast<uint8_t>(std::min(border_in[b]+1, 2));
+            }
+        }
+    }
+    for (size_t v=0; v<positions.size(); ++v) {
+        if (border_in[v] + border_out[v] == 0) {
+            continue;
+        }
+        // a single border passing through, anything else is non-manifold
+        kinds[v] = ((border_in[v] == 1) && (border_out[v] == 1)) ? VertexKind::Border : VertexKind::Locked;
+    }
+    return kinds;
+}
+
+std::vector<Quadric>
+compute_quadrics(
+        std::span<const uint32_t> indices,
+        std::span<const glm::vec3> positions,
+        const std::unordered_set<uint64_t>& edges) {
+    auto quadrics = std::vector<Quadric>(positions.size(), Quadric{});
+    for (size_t i=0; i<indices.size(); i+=3) {
+        const auto& p0 = positions[indices[i+0]];
+        const auto& p1 = positions[indices[i+1]];
+        const auto& p2 = positions[indices[i+2]];
+        auto n = glm::cross(p1-p0, p2-p0);
+        auto len = glm::length(n);
+        if (len == 0.f) {
+            continue;
+        }
+        n /= len;
+
+        auto q = Quadric::from_plane(n, -glm::dot(n, p0), len*.5f);
+        for (size_t k=0; k<3; ++k) {
+            quadrics[indices[i+k]] += q;
+        }
+
+        for (size_t k=0; k<3; ++k) {
+            auto a = indices[i+k];
+            auto b = indices[i+(k+1)%3];
+            if (edges.contains(edge_key(b, a))) {
+                continue;
+            }
+            // plane through the border edge, perpendicular to the triangle
+            auto dir = positions[b] - positions[a];
+            auto edge_len = glm::length(dir);
+            if (edge_len == 0.f) {
+                continue;
+            }
+            auto bn = glm::normalize(glm::cross(dir, n));
+            auto bq = Quadric::from_plane(bn, -glm::dot(bn, positions[a]), edge_len*edge_len*border_weight);
+            quadrics[a] += bq;
+            quadrics[b] += bq;
+        }
+    }
+    return quadrics;
+}
+
+// CSR layout: triangles of vertex v are triangles[offsets[v]..offsets[v+1]]
+struct VertexTriangles {
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> triangles;
+
+    VertexTriangles(std::span<const uint32_t> indices, size_t vertex_count) :
+            offsets(vertex_count+1, 0), triangles(indices.size()) {
+        for (auto idx : indices) {
+            ++offsets[idx+1];
+        }
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+        auto fill = std::vector<uint32_t>(offsets.begin(), offsets.end()-1);
+        for (size_t i=0; i<indices.size(); ++i) {
+            triangles[fill[indices[i]]++] = static_cast<uint32_t>(i/3);
+        }
+    }
+
+    std::span<const uint32_t> of(uint32_t vertex) const noexcept {
+        return std::span<const uint32_t>(triangles).subspan(offsets[vertex], offsets[vertex+1]-offsets[vertex]);
+    }
+};
+
+}
+
+std::vector<uint32_t>
+simplify(
+        std::span<const uint32_t> indices,
+        std::span<const glm::vec3> positions,
+        size_t target_index_count,
+        float* result_error) {
+    assert(indices.size() % 3 == 0);
+    auto result = std::vector<uint32_t>(indices.begin(), indices.end());
+    auto max_error = 0.f;
+    auto target_triangles = target_index_count/3;
+
+    if (result.size() > target_index_count) {
+        // topology, quadrics and collapses work on position groups, `result`
+        // keeps the wedges
+        auto groups = position_groups(positions);
+        auto grouped = std::vector<uint32_t>(result.size());
+        for (size_t i=0; i<result.size(); ++i) {
+            grouped[i] = groups[result[i]];
+        }
+        auto edges = collect_edges(grouped);
+        auto kinds = classify_vertices(grouped, positions, edges);
+        auto quadrics = compute_quadrics(grouped, positions, edges);
+
+        // group and wedge each vertex collapses to in the current pass
+        auto remap = std::vector<uint32_t>(positions.size());
+        auto wedge_remap = std::vector<uint32_t>(positions.size());
+        auto touched = std::vector<uint8_t>(positions.size());
+        auto collapses = std::vector<Collapse>{};
+        auto wedges = std::vector<std::pair<uint32_t, uint32_t>>{};
+
+        // The wedges of group `src` paired with the wedge of group `tgt` they
+        // share a triangle with, which has the same attributes across the
+        // collapsed edge. Wedges sharing none, like the third face at a cube
+        // corner, get any wedge of `tgt`. False if that was needed.
+        constexpr auto none = std::numeric_limits<uint32_t>::max();
+        auto pair_wedges = [&](const VertexTriangles& adjacency, uint32_t src, uint32_t tgt) {
+            wedges.clear();
+            auto any_tgt = none;
+            for (auto tri : adjacency.of(src)) {
+                auto src_wedge = none;
+                auto tgt_wedge = none;
+                for (size_t k=0; k<3; ++k) {
+                    auto v = result[tri*3+k];
+                    if (groups[v] == src) {
+                        src_wedge = v;
+                    } else if (groups[v] == tgt) {
+                        tgt_wedge = v;
+                        any_tgt = v;
+                    }
+                }
+                auto it = std::find_if(wedges.begin(), wedges.end(), [&](const auto& w) { return w.first == src_wedge; });
+                if (it == wedges.end()) {
+                    wedges.emplace_back(src_wedge, tgt_wedge);
+                } else if (it->second == none) {
+                    it->second = tgt_wedge;
+                }
+            }
+            // the edge exists, so some triangle holds both groups
+            assert(any_tgt != none);
+            auto exact = true;
+            for (auto& wedge : wedges) {
+                if (wedge.second == none) {
+                    wedge.second = any_tgt;
+                    exact = false;
+                }
+            }
+            return exact;
+        };
+
+        // collapses that mix up the attributes of a seam wait until nothing
+        // else is left
+        auto allow_inexact = false;
+        for (int pass=0; (pass < max_passes) && (result.size()/3 > target_triangles); ++pass) {
+            if (pass > 0) {
+                grouped.resize(result.size());
+                for (size_t i=0; i<result.size(); ++i) {
+                    grouped[i] = groups[result[i]];
+                }
+                edges = collect_edges(grouped);
+            }
+            auto adjacency = VertexTriangles(grouped, positions.size());
+
+            collapses.clear();
+            auto has_inexact = false;
+            for (size_t i=0; i<grouped.size(); i+=3) {
+                for (size_t k=0; k<3; ++k) {
+                    auto a = grouped[i+k];
+                    auto b = grouped[i+(k+1)%3];
+                    auto is_border = !edges.contains(edge_key(b, a));
+                    if (!is_border && (a > b)) {
+                        // interior edges are seen from both triangles
+                        continue;
+                    }
+
+                    auto best = Collapse{0, 0, std::numeric_limits<float>::infinity(), false};
+                    for (auto [src, tgt] : {std::make_pair(a, b), std::make_pair(b, a)}) {
+                        if ((kinds[src] == VertexKind::Locked) || ((kinds[src] == VertexKind::Border) && !is_border)) {
+                            continue;
+                        }
+                        auto q = quadrics[src];
+                        q += quadrics[tgt];
+                        auto cost = q.eval(positions[tgt]);
+                        if (cost < best.cost) {
+                            best = Collapse{src, tgt, cost, false};
+                        }
+                    }
+                    if (best.cost < std::numeric_limits<float>::infinity()) {
+                        best.exact = pair_wedges(adjacency, best.src, best.tgt);
+                        has_inexact = has_inexact || !best.exact;
+                        if (best.exact || allow_inexact) {
+                            collapses.push_back(best);
+                        }
+                    }
+                }
+            }
+            if (collapses.empty()) {
+                if (has_inexact && !allow_inexact) {
+                    allow_inexact = true;
+                    continue;
+                }
+                break;
+            }
+            std::sort(collapses.begin(), collapses.end(), [](const auto& a, const auto& b) {
+                return a.cost < b.cost;
+            });
+
+            // a collapse removes about two triangles, allow some slack for
+            // rejected collapses but don't go for the expensive ones yet
+            auto triangles = result.size()/3;
+            auto needed = (triangles - target_triangles + 1)/2;
+            auto error_limit = collapses[std::min(collapses.size()-1, needed + needed/2)].cost;
+
+            std::iota(remap.begin(), remap.end(), 0);
+            std::iota(wedge_remap.begin(), wedge_remap.end(), 0);
+            std::fill(touched.begin(), touched.end(), 0);
+            auto collapsed = size_t{0};
+
+            for (const auto& collapse : collapses) {
+                if ((collapse.cost > error_limit) || (triangles <= target_triangles)) {
+                    break;
+                }
+                if (touched[collapse.src] || touched[collapse.tgt]) {
+                    continue;
+                }
+
+                auto removed = size_t{0};
+                auto valid = true;
+                for (auto tri : adjacency.of(collapse.src)) {
+                    auto v = std::array<uint32_t, 3>{};
+                    for (size_t k=0; k<3; ++k) {
+                        v[k] = remap[grouped[tri*3+k]];
+                    }
+                    if ((v[0] == collapse.tgt) || (v[1] == collapse.tgt) || (v[2] == collapse.tgt)) {
+                        ++removed;
+                        continue;
+                    }
+                    if ((v[0] == v[1]) || (v[1] == v[2]) || (v[0] == v[2])) {
+                        continue;
+                    }
+
+                    auto p = std::array<glm::vec3, 3>{positions[v[0]], positions[v[1]], positions[v[2]]};
+                    auto n_before = glm::cross(p[1]-p[0], p[2]-p[0]);
+                    for (size_t k=0; k<3; ++k) {
+                        if (v[k] == collapse.src) {
+                            p[k] = positions[collapse.tgt];
+                        }
+                    }
+                    auto n_after = glm::cross(p[1]-p[0], p[2]-p[0]);
+                    auto len_before = glm::length(n_before);
+                    if (len_before == 0.f) {
+                        continue;
+                    }
+                    if (glm::dot(n_before, n_after) <= min_normal_cos*len_before*glm::length(n_after)) {
+                        // the triangle would flip or degenerate
+                        valid = false;
+                        break;
+                    }
+                }
+                if (!valid) {
+                    continue;
+                }
+
+                auto weight = quadrics[collapse.src].weight + quadrics[collapse.tgt].weight;
+                if (weight > 0.f) {
+                    max_error = std::max(max_error, std::sqrt(collapse.cost/weight));
+                }
+                quadrics[collapse.tgt] += quadrics[collapse.src];
+                remap[collapse.src] = collapse.tgt;
+                pair_wedges(adjacency, collapse.src, collapse.tgt);
+                for (auto [src_wedge, tgt_wedge] : wedges) {
+                    wedge_remap[src_wedge] = tgt_wedge;
+                }
+                touched[collapse.src] = 1;
+                touched[collapse.tgt] = 1;
+                triangles -= std::min(removed, triangles);
+                ++collapsed;
+            }
+            if (collapsed == 0) {
+                if (has_inexact && !allow_inexact) {
+                    allow_inexact = true;
+                    continue;
+                }
+                break;
+            }
+
+            // apply the collapses, dropping triangles that became degenerate
+            auto out = size_t{0};
+            for (size_t i=0; i<result.size(); i+=3) {
+                auto a = wedge_remap[result[i+0]];
+                auto b = wedge_remap[result[i+1]];
+                auto c = wedge_remap[result[i+2]];
+                if ((groups[a] != groups[b]) && (groups[b] != groups[c]) && (groups[a] != groups[c])) {
+                    result[out++] = a;
+                    result[out++] = b;
+                    result[out++] = c;
+                }
+            }
+            result.resize(out);
+        }
+    }
+
+    if (result_error) {
+        *result_error = max_error;
+    }
+    return result;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Reduces the triangle list to at most `target_index_count` indices (if
+// possible) by collapsing edges in order of their quadric error (Garland &
+// Heckbert, "Surface Simplification Using Quadric Error Metrics").
+// Edges collapse onto one of their vertices, so the result references the
+// input vertices and all levels of detail can share one vertex buffer. Open
+// borders only collapse along themselves and non-manifold vertices are kept.
+// Vertices with the same position (attribute seams) collapse together, each
+// onto the vertex on its side of the seam; collapses that have to pick one
+// across the seam wait until no other is left.
+// `result_error` receives the largest deviation from the input surface in mesh
+// units.
+std::vector<uint32_t> simplify(
+    std::span<const uint32_t> indices,
+    std::span<const glm::vec3> positions,
+    size_t target_index_count,
+    float* result_error = nullptr);
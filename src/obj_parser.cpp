@@ -0,0 +1,560 @@
+#include "obj_parser.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <string>
+#include <thread>
+using namespace std::string_literals;
+
+#include "mapped_file.h"
+#include "thread_pool.h"
+#include "utils.h"
+
+namespace {
+
+// more chunks than threads even out differences in parsing cost between chunks
+constexpr size_t chunks_per_thread = 4;
+
+// Thrown by `parse_chunk`, which doesn't know where its text starts in the
+// file. Turned into a `GLSBError` with the line number by the caller.
+class ObjSyntaxError : public GLSBError {
+    public:
+        ObjSyntaxError(const char* what, const char* pos) : GLSBError(what), pos_{pos} {}
+
+        // within the line the error is in
+        const char* pos() const noexcept {
+            return pos_;
+        }
+    private:
+        const char* pos_;
+};
+
+// 1-based number of the line `pos` is in, `pos` points into `text`
+size_t
+line_number(std::string_view text, const char* pos) noexcept {
+    return 1 + static_cast<size_t>(std::count(text.data(), pos, '\n'));
+}
+
+[[noreturn]] void
+throw_with_line(const ObjSyntaxError& ex, size_t line) {
+    throw GLSBError(("line "s + std::to_string(line) + ": " + ex.what()).c_str());
+}
+
+struct ShapeStart {
+    // position in `ObjChunk::indices` the new shape starts at
+    size_t corner_offset;
+    std::string name;
+};
+
+struct IndexFixup {
+    size_t corner;
+    int tinyobj::index_t::* component;
+    enum class Attrib {
+        Vertex,
+        Normal,
+        TexCoord,
+    } attrib;
+};
+
+struct ObjChunk {
+    std::vector<tinyobj::real_t> vertices;
+    std::vector<tinyobj::real_t> normals;
+    std::vector<tinyobj::real_t> texcoords;
+
+    // triangulated face corners
+    std::vector<tinyobj::index_t> indices;
+    // negative (relative) indices are resolved against the attribute counts
+    // of this chunk only, they still need the count of all preceding chunks added
+    std::vector<IndexFixup> fixups;
+    std::vector<ShapeStart> shape_starts;
+};
+
+bool
+is_space(char c) noexcept {
+    return (c == ' ') || (c == '\t');
+}
+
+bool
+is_digit(char c) noexcept {
+    return (c >= '0') && (c <= '9');
+}
+
+const char*
+skip_space(const char* p, const char* end) noexcept {
+    while ((p != end) && is_space(*p)) {
+        ++p;
+    }
+    return p;
+}
+
+const char*
+find_token_end(const char* p, const char* end) noexcept {
+    while ((p != end) && !is_space(*p) && (*p != '\r')) {
+        ++p;
+    }
+    return p;
+}
+
+// Same arithmetic as tinyobjloader's number parser, so both parsers produce
+// bit-identical floats. Returns false for malformed numbers.
+bool
+parse_double(const char* s, const char* end, double& result) noexcept {
+    if (s == end) {
+        return false;
+    }
+
+    auto mantissa = 0.;
+    auto exponent = 0;
+    auto sign = '+';
+    auto exp_sign = '+';
+    auto cur = s;
+    auto read = 0;
+
+    if ((*cur == '+') || (*cur == '-')) {
+        sign = *cur;
+        ++cur;
+    } else if (!is_digit(*cur)) {
+        return false;
+    }
+
+    while ((cur != end) && is_digit(*cur)) {
+        mantissa *= 10;
+        mantissa += *cur - '0';
+        ++cur;
+        ++read;
+    }
+    if (read == 0) {
+        return false;
+    }
+
+    if ((cur != end) && (*cur == '.')) {
+        static constexpr double pow_lut[] = {1.0, 0.1, 0.01, 0.001, 0.0001, 0.00001, 0.000001, 0.0000001};
+        static constexpr int lut_entries = sizeof(pow_lut)/sizeof(pow_lut[0]);
+        ++cur;
+        read = 1;
+        while ((cur != end) && is_digit(*cur)) {
+            mantissa += (*cur - '0') * ((read < lut_entries) ? pow_lut[read] : std::pow(10., -read));
+            ++read;
+            ++cur;
+        }
+    }
+
+    if ((cur != end) && ((*cur == 'e') || (*cur == 'E'))) {
+        ++cur;
+        if ((cur != end) && ((*cur == '+') || (*cur == '-'))) {
+            exp_sign = *cur;
+            ++cur;
+        } else if ((cur == end) || !is_digit(*cur)) {
+            return false;
+        }
+
+        read = 0;
+        while ((cur != end) && is_digit(*cur)) {
+            exponent *= 10;
+            exponent += *cur - '0';
+            ++cur;
+            ++read;
+        }
+        exponent *= (exp_sign == '+') ? 1 : -1;
+        if (read == 0) {
+            return false;
+        }
+    }
+
+    result = ((sign == '+') ? 1 : -1) *
+        (exponent ? std::ldexp(mantissa * std::pow(5., exponent), exponent) : mantissa);
+    return true;
+}
+
+tinyobj::real_t
+parse_real(const char*& p, const char* end, double default_value = 0.) noexcept {
+    p = skip_space(p, end);
+    auto token_end = find_token_end(p, end);
+    auto val = default_value;
+    if (!parse_double(p, token_end, val)) {
+        val = default_value;
+    }
+    p = token_end;
+    return static_cast<tinyobj::real_t>(val);
+}
+
+// atoi() semantics: optional sign followed by digits, anything else ends the number
+int
+parse_int(const char* p, const char* end) noexcept {
+    auto negative = false;
+    if ((p != end) && ((*p == '+') || (*p == '-'))) {
+        negative = (*p == '-');
+        ++p;
+    }
+    auto val = 0;
+    while ((p != end) && is_digit(*p)) {
+        val = val*10 + (*p - '0');
+        ++p;
+    }
+    return negative ? -val : val;
+}
+
+const char*
+find_index_end(const char* p, const char* end) noexcept {
+    while ((p != end) && (*p != '/') && !is_space(*p) && (*p != '\r')) {
+        ++p;
+    }
+    return p;
+}
+
+struct FaceParser {
+    ObjChunk& chunk;
+    std::vector<tinyobj::index_t> face;
+    // fixups of the current face, `corner` is the position within `face`
+    std::vector<IndexFixup> face_fixups;
+
+    // start of the face being parsed
+    const char* line = nullptr;
+
+    // resolves a 1-based or relative index, records a fixup for the latter
+    int fix_index(int idx, size_t count, int tinyobj::index_t::* component, IndexFixup::Attrib attrib) {
+        if (idx > 0) {
+            return idx - 1;
+        }
+        if (idx == 0) {
+            throw ObjSyntaxError("face index 0, indices start at 1", line);
+        }
+        face_fixups.push_back(IndexFixup{face.size(), component, attrib});
+        return static_cast<int>(count) + idx;
+    }
+
+    tinyobj::index_t parse_triple(const char*& p, const char* end);
+
+    void parse(const char* p, const char* end);
+
+    void emit_corner(size_t corner) {
+        for (const auto& fixup : face_fixups) {
+            if (fixup.corner == corner) {
+                chunk.fixups.push_back(IndexFixup{chunk.indices.size(), fixup.component, fixup.attrib});
+            }
+        }
+        chunk.indices.push_back(face[corner]);
+    }
+};
+
+tinyobj::index_t
+FaceParser::parse_triple(const char*& p, const char* end) {
+    auto ret = tinyobj::index_t{-1, -1, -1};
+    auto vsize = chunk.vertices.size()/3;
+    auto vnsize = chunk.normals.size()/3;
+    auto vtsize = chunk.texcoords.size()/2;
+
+    ret.vertex_index = fix_index(
+        parse_int(p, end), vsize, &tinyobj::index_t::vertex_index, IndexFixup::Attrib::Vertex);
+    p = find_index_end(p, end);
+    if ((p == end) || (*p != '/')) {
+        return ret;
+    }
+    ++p;
+
+    // i//k
+    if ((p != end) && (*p == '/')) {
+        ++p;
+        ret.normal_index = fix_index(
+            parse_int(p, end), vnsize, &tinyobj::index_t::normal_index, IndexFixup::Attrib::Normal);
+        p = find_index_end(p, end);
+        return ret;
+    }
+
+    // i/j/k or i/j
+    ret.texcoord_index = fix_index(
+        parse_int(p, end), vtsize, &tinyobj::index_t::texcoord_index, IndexFixup::Attrib::TexCoord);
+    p = find_index_end(p, end);
+    if ((p == end) || (*p != '/')) {
+        return ret;
+    }
+    ++p;
+    ret.normal_index = fix_index(
+        parse_int(p, end), vnsize, &tinyobj::index_t::normal_index, IndexFixup::Attrib::Normal);
+    p = find_index_end(p, end);
+    return ret;
+}
+
+void
+FaceParser::parse(const char* p, const char* end) {
+    line = p;
+    face.clear();
+    face_fixups.clear();
+    p = skip_space(p, end);
+    while ((p != end) && (*p != '\r')) {
+        face.push_back(parse_triple(p, end));
+        while ((p != end) && (is_space(*p) || (*p == '\r'))) {
+            ++p;
+        }
+    }
+
+    // fan triangulation like tinyobjloader
+    for (size_t k=2; k<face.size(); ++k) {
+        emit_corner(0);
+        emit_corner(k-1);
+        emit_corner(k);
+    }
+}
+
+// throws `ObjSyntaxError` for faces with an index of 0
+void
+parse_chunk(std::string_view text, ObjChunk& chunk) {
+    auto face_parser = FaceParser{chunk, {}, {}};
+    auto p = text.data();
+    const auto text_end = text.data() + text.size();
+
+    while (p != text_end) {
+        auto line_end = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(text_end - p)));
+        if (line_end == nullptr) {
+            line_end = text_end;
+        }
+        auto next_line = (line_end == text_end) ? text_end : line_end + 1;
+        auto end = line_end;
+        if ((end != p) && (*(end-1) == '\r')) {
+            --end;
+        }
+
+        auto token = skip_space(p, end);
+        auto len = static_cast<size_t>(end - token);
+        p = next_line;
+
+        if ((len < 2) || (token[0] == '#')) {
+            continue;
+        }
+
+        if ((token[0] == 'v') && is_space(token[1])) {
+            token += 2;
+            chunk.vertices.push_back(parse_real(token, end));
+            chunk.vertices.push_back(parse_real(token, end));
+            chunk.vertices.push_back(parse_real(token, end));
+        } else if ((len > 2) && (token[0] == 'v') && (token[1] == 'n') && is_space(token[2])) {
+            token += 3;
+            chunk.normals.push_back(parse_real(token, end));
+            chunk.normals.push_back(parse_real(token, end));
+            chunk.normals.push_back(parse_real(token, end));
+        } else if ((len > 2) && (token[0] == 'v') && (token[1] == 't') && is_space(token[2])) {
+            token += 3;
+            chunk.texcoords.push_back(parse_real(token, end));
+            chunk.texcoords.push_back(parse_real(token, end));
+        } else if ((token[0] == 'f') && is_space(token[1])) {
+            face_parser.parse(token + 2, end);
+        } else if ((token[0] == 'o') && is_space(token[1])) {
+            chunk.shape_starts.push_back(ShapeStart{chunk.indices.size(), std::string(token + 2, end)});
+        } else if ((token[0] == 'g') && is_space(token[1])) {
+            // only the first group name is used
+            auto name_begin = skip_space(token + 2, end);
+            auto name_end = find_token_end(name_begin, end);
+            chunk.shape_starts.push_back(ShapeStart{chunk.indices.size(), std::string(name_begin, name_end)});
+        }
+    }
+}
+
+// resolves the relative indices of `chunk` and appends its attributes to `attrib`
+void
+append_attributes(ObjChunk& chunk, tinyobj::attrib_t& attrib) {
+    auto vertex_base = static_cast<int>(attrib.vertices.size()/3);
+    auto normal_base = static_cast<int>(attrib.normals.size()/3);
+    auto texcoord_base = static_cast<int>(attrib.texcoords.size()/2);
+    for (const auto& fixup : chunk.fixups) {
+        auto& idx = chunk.indices[fixup.corner].*(fixup.component);
+        switch (fixup.attrib) {
+            case IndexFixup::Attrib::Vertex: {
+                idx += vertex_base;
+            } break;
+            case IndexFixup::Attrib::Normal: {
+                idx += normal_base;
+            } break;
+            case IndexFixup::Attrib::TexCoord: {
+                idx += texcoord_base;
+            } break;
+        }
+    }
+
+    attrib.vertices.insert(attrib.vertices.end(), chunk.vertices.begin(), chunk.vertices.end());
+    attrib.normals.insert(attrib.normals.end(), chunk.normals.begin(), chunk.normals.end());
+    attrib.texcoords.insert(attrib.texcoords.end(), chunk.texcoords.begin(), chunk.texcoords.end());
+}
+
+std::vector<std::string_view>
+split_lines(std::string_view text, size_t chunk_count, size_t min_chunk_size) {
+    auto ret = std::vector<std::string_view>{};
+    auto target_size = std::max(text.size() / std::max(chunk_count, size_t{1}), min_chunk_size);
+
+    while (!text.empty()) {
+        if (text.size() <= target_size) {
+            ret.push_back(text);
+            break;
+        }
+        auto split = text.find('\n', target_size);
+        if (split == std::string_view::npos) {
+            ret.push_back(text);
+            break;
+        }
+        ret.push_back(text.substr(0, split + 1));
+        text.remove_prefix(split + 1);
+    }
+    return ret;
+}
+
+}
+
+void
+parse_obj(
+        std::string_view text,
+        tinyobj::attrib_t& attrib,
+        std::vector<tinyobj::shape_t>& shapes,
+        ThreadPool* pool,
+        size_t min_chunk_size) {
+    auto thread_count = (pool != nullptr) ? pool->size() : 1u;
+    auto parts = split_lines(text, thread_count * chunks_per_thread, min_chunk_size);
+    auto chunks = std::vector<ObjChunk>(parts.size());
+
+    try {
+        if ((pool != nullptr) && (parts.size() > 1)) {
+            auto pending = std::vector<std::future<void>>{};
+            pending.reserve(parts.size());
+            for (size_t i=0; i<parts.size(); ++i) {
+                pending.push_back(pool->submit([&parts, &chunks, i]() { parse_chunk(parts[i], chunks[i]); }));
+            }
+            // the tasks reference `parts` and `chunks`, so all of them have to
+            // finish before an error leaves this scope, the first one in the
+            // text is reported
+            for (auto& task : pending) {
+                task.wait();
+            }
+            for (auto& task : pending) {
+                task.get();
+            }
+        } else {
+            for (size_t i=0; i<parts.size(); ++i) {
+                parse_chunk(parts[i], chunks[i]);
+            }
+        }
+    }
+    catch (const ObjSyntaxError& ex) {
+        throw_with_line(ex, line_number(text, ex.pos()));
+    }
+
+    // merge attributes
+    auto vertex_count = size_t{0};
+    auto normal_count = size_t{0};
+    auto texcoord_count = size_t{0};
+    for (const auto& chunk : chunks) {
+        vertex_count += chunk.vertices.size();
+        normal_count += chunk.normals.size();
+        texcoord_count += chunk.texcoords.size();
+    }
+    attrib.vertices.reserve(attrib.vertices.size() + vertex_count);
+    attrib.normals.reserve(attrib.normals.size() + normal_count);
+    attrib.texcoords.reserve(attrib.texcoords.size() + texcoord_count);
+
+    // merge shapes, starting with the unnamed shape before the first "o"/"g"
+    auto shape = tinyobj::shape_t{};
+    auto flush_shape = [&shapes, &shape]() {
+        if (!shape.mesh.indices.empty()) {
+            shapes.push_back(std::move(shape));
+        }
+        shape = tinyobj::shape_t{};
+    };
+    auto append_corners = [&shape](const ObjChunk& chunk, size_t begin, size_t end) {
+        shape.mesh.indices.insert(
+            shape.mesh.indices.end(),
+            chunk.indices.begin() + static_cast<ptrdiff_t>(begin),
+            chunk.indices.begin() + static_cast<ptrdiff_t>(end));
+        auto triangle_count = (end - begin) / 3;
+        shape.mesh.num_face_vertices.insert(shape.mesh.num_face_vertices.end(), triangle_count, 3);
+        shape.mesh.material_ids.insert(shape.mesh.material_ids.end(), triangle_count, -1);
+    };
+
+    for (auto& chunk : chunks) {
+        append_attributes(chunk, attrib);
+
+        auto corner = size_t{0};
+        for (auto& start : chunk.shape_starts) {
+            append_corners(chunk, corner, start.corner_offset);
+            corner = start.corner_offset;
+            flush_shape();
+            shape.name = std::move(start.name);
+        }
+        append_corners(chunk, corner, chunk.indices.size());
+    }
+    flush_shape();
+}
+
+void
+parse_obj_file(
+        const std::filesystem::path& fpath,
+        tinyobj::attrib_t& attrib,
+        std::vector<tinyobj::shape_t>& shapes,
+        unsigned thread_count) {
+    auto file = MappedFile(fpath);
+    auto text = std::string_view(reinterpret_cast<const char*>(file.data()), file.size());
+
+    if (thread_count == 0) {
+        thread_count = std::thread::hardware_concurrency();
+    }
+    if ((thread_count > 1) && (text.size() >= 2*obj_min_chunk_size)) {
+        auto pool = ThreadPool(thread_count);
+        parse_obj(text, attrib, shapes, &pool);
+    } else {
+        parse_obj(text, attrib, shapes);
+    }
+}
+
+size_t
+parse_obj_stream(
+        const std::filesystem::path& fpath,
+        tinyobj::attrib_t& attrib,
+        size_t chunk_size,
+        const ObjFaceHandler& on_faces) {
+    auto ifs = std::ifstream(fpath, std::ios::binary);
+    if (!ifs) {
+        throw GLSBError(("Error opening file: "s + fpath.string()).c_str());
+    }
+
+    auto buffer = std::vector<char>(std::max(chunk_size, size_t{1}));
+    auto filled = size_t{0};
+    auto pieces = size_t{0};
+    // in the pieces before the current one
+    auto line_count = size_t{0};
+    auto at_eof = false;
+    while (!at_eof) {
+        ifs.read(buffer.data() + filled, static_cast<std::streamsize>(buffer.size() - filled));
+        filled += static_cast<size_t>(ifs.gcount());
+        at_eof = !ifs;
+
+        // only whole lines are parsed, the rest is kept for the next piece
+        auto text = std::string_view(buffer.data(), filled);
+        if (!at_eof) {
+            auto last_line_end = text.rfind('\n');
+            if (last_line_end == std::string_view::npos) {
+                // line longer than the buffer
+                buffer.resize(buffer.size()*2);
+                continue;
+            }
+            text = text.substr(0, last_line_end + 1);
+        }
+
+        auto chunk = ObjChunk{};
+        try {
+            parse_chunk(text, chunk);
+        }
+        catch (const ObjSyntaxError& ex) {
+            throw_with_line(ex, line_count + line_number(text, ex.pos()));
+        }
+        append_attributes(chunk, attrib);
+        on_faces(attrib, chunk.indices);
+        ++pieces;
+        line_count += static_cast<size_t>(std::count(text.begin(), text.end(), '\n'));
+
+        std::memmove(buffer.data(), buffer.data() + text.size(), filled - text.size());
+        filled -= text.size();
+    }
+    if (ifs.bad()) {
+        throw GLSBError(("Error reading file: "s + fpath.string()).c_str());
+    }
+    return pieces;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <functional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include <tiny_obj_loader.h>
+
+class ThreadPool;
+
+// chunks smaller than this are not worth a task of their own
+inline constexpr size_t obj_min_chunk_size = 256*1024;
+
+// Parses the OBJ source `text` into tinyobjloader's data structures.
+//
+// The text is split at line boundaries into chunks which are parsed on `pool`
+// (or on the calling thread if `pool` is null) and merged afterwards. The
+// result is identical to `tinyobj::LoadObj` with triangulation enabled and
+// without a material reader: `v`/`vn`/`vt`/`f`/`o`/`g` statements are
+// evaluated, everything else is skipped. Like tinyobjloader it rejects faces
+// with an index of 0, by throwing `GLSBError` with the line number.
+void parse_obj(
+    std::string_view text,
+    tinyobj::attrib_t& attrib,
+    std::vector<tinyobj::shape_t>& shapes,
+    ThreadPool* pool = nullptr,
+    size_t min_chunk_size = obj_min_chunk_size);
+
+// Maps `fpath` and parses it with `parse_obj`. A temporary pool of
+// `thread_count` workers (0: one per hardware thread) is only spun up if the
+// file is large enough to be split.
+void parse_obj_file(
+    const std::filesystem::path& fpath,
+    tinyobj::attrib_t& attrib,
+    std::vector<tinyobj::shape_t>& shapes,
+    unsigned thread_count = 0);
+
+// Receives the faces parsed by `parse_obj_stream`, once per piece: three
+// corners per triangle, none for pieces without faces. Their attribute indices
+// are absolute and valid for `attrib` as passed.
+using ObjFaceHandler = std::function<void(const tinyobj::attrib_t& attrib, std::span<const tinyobj::index_t> corners)>;
+
+// Reads `fpath` in pieces of about `chunk_size` bytes instead of mapping it as
+// a whole. Attributes are accumulated in `attrib`, as faces may refer to any
+// preceding one, but the faces of each piece are only passed to `on_faces` and
+// dropped afterwards. `o`/`g` statements are ignored. Returns the number of
+// pieces read.
+size_t parse_obj_stream(
+    const std::filesystem::path& fpath,
+    tinyobj::attrib_t& attrib,
+    size_t chunk_size,
+    const ObjFaceHandler& on_faces);
@@ -0,0 +1,116 @@
+#include "packed_vertex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <glm/gtc/packing.hpp>
+
+namespace {
+
+float
+sign_not_zero(float val) noexcept {
+    return (val >= 0.f) ? 1.f : -1.f;
+}
+
+template <typename PackedT>
+void
+pack_attributes(PackedT& out, const Vertex& vert) noexcept {
+    auto norm = oct_encode(vert.norm);
+    out.norm[0] = to_snorm16(norm.x);
+    out.norm[1] = to_snorm16(norm.y);
+    out.uv[0] = to_half(vert.uv.x);
+    out.uv[1] = to_half(vert.uv.y);
+}
+
+}
+
+glm::vec2
+oct_encode(glm::vec3 norm) noexcept {
+    auto l1 = std::abs(norm.x) + std::abs(norm.y) + std::abs(norm.z);
+    if (l1 == 0.f) {
+        return glm::vec2(0.f);
+    }
+    norm /= l1;
+    auto ret = glm::vec2(norm.x, norm.y);
+    if (norm.z < 0.f) {
+        // fold the lower hemisphere over the diagonals
+        ret = glm::vec2(
+            (1.f - std::abs(norm.y)) * sign_not_zero(norm.x),
+            (1.f - std::abs(norm.x)) * sign_not_zero(norm.y));
+    }
+    return ret;
+}
+
+glm::vec3
+oct_decode(glm::vec2 enc) noexcept {
+    auto norm = glm::vec3(enc.x, enc.y, 1.f - std::abs(enc.x) - std::abs(enc.y));
+    auto t = std::max(-norm.z, 0.f);
+    norm.x += (norm.x >= 0.f) ? -t : t;
+    norm.y += (norm.y >= 0.f) ? -t : t;
+    return glm::normalize(norm);
+}
+
+int16_t
+to_snorm16(float val) noexcept {
+    return static_cast<int16_t>(std::round(std::clamp(val, -1.f, 1.f) * 32767.f));
+}
+
+uint16_t
+to_unorm16(float val) noexcept {
+    return static_cast<uint16_t>(std::round(std::clamp(val, 0.f, 1.f) * 65535.f));
+}
+
+uint16_t
+to_half(float val) noexcept {
+    return glm::packHalf1x16(val);
+}
+
+float
+from_half(uint16_t val) noexcept {
+    return glm::unpackHalf1x16(val);
+}
+
+QuantizedMesh<PackedVertex>
+pack_mesh(const Mesh<Vertex>& mesh) {
+    auto ret = QuantizedMesh<PackedVertex>{{{}, mesh.index_data}, identity_dequantization};
+    ret.mesh.vertex_data.reserve(mesh.vertex_data.size());
+    for (const auto& vert : mesh.vertex_data) {
+        auto packed = PackedVertex{};
+        packed.pos = vert.pos;
+        pack_attributes(packed, vert);
+        ret.mesh.vertex_data.push_back(packed);
+    }
+    return ret;
+}
+
+QuantizedMesh<QuantizedVertex>
+quantize_mesh(const Mesh<Vertex>& mesh) {
+    auto bb_min = glm::vec3(std::numeric_limits<float>::max());
+    auto bb_max = glm::vec3(std::numeric_limits<float>::lowest());
+    for (const auto& vert : mesh.vertex_data) {
+        bb_min = glm::min(bb_min, vert.pos);
+        bb_max = glm::max(bb_max, vert.pos);
+    }
+    if (mesh.vertex_data.empty()) {
+        bb_min = bb_max = glm::vec3(0.f);
+    }
+
+    // a single scale for all axes keeps the quantization error uniform
+    auto extent = std::max(bb_max.x - bb_min.x, std::max(bb_max.y - bb_min.y, bb_max.z - bb_min.z));
+    auto scale = (extent > 0.f) ? extent : 1.f;
+
+    auto ret = QuantizedMesh<QuantizedVertex>{{{}, mesh.index_data}, {bb_min, glm::vec3(scale)}};
+    ret.mesh.vertex_data.reserve(mesh.vertex_data.size());
+    for (const auto& vert : mesh.vertex_data) {
+        auto packed = QuantizedVertex{};
+        auto norm_pos = (vert.pos - bb_min) / scale;
+        packed.pos[0] = to_unorm16(norm_pos.x);
+        packed.pos[1] = to_unorm16(norm_pos.y);
+        packed.pos[2] = to_unorm16(norm_pos.z);
+        packed.pos[3] = 0;
+        pack_attributes(packed, vert);
+        ret.mesh.vertex_data.push_back(packed);
+    }
+    return ret;
+}
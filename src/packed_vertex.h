@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "mesh.h"
+#include "shader.h"
+
+// Compressed counterparts of `Vertex` for use with res/packed.vert.glsl:
+//  - normals are octahedral encoded into two snorm16 components
+//  - texture coordinates are stored as half floats
+// `PackedVertex` keeps float positions (20 bytes), `QuantizedVertex` stores
+// positions as unorm16 relative to the mesh bounds (16 bytes), the shader maps
+// them back with the `u_pos_offset`/`u_pos_scale` uniforms.
+
+struct PackedVertex {
+    glm::vec3 pos;
+    int16_t norm[2];
+    uint16_t uv[2];
+
+    static std::vector<VertexDescriptor> get_vertex_desc() noexcept {
+        return std::vector<VertexDescriptor>{
+            {"v_pos", 3, sizeof(PackedVertex), offsetof(PackedVertex, pos), false, GL_FLOAT},
+            {"v_normal", 2, sizeof(PackedVertex), offsetof(PackedVertex, norm), true, GL_SHORT},
+            {"v_uv", 2, sizeof(PackedVertex), offsetof(PackedVertex, uv), false, GL_HALF_FLOAT},
+        };
+    }
+};
+static_assert(sizeof(PackedVertex) == 20);
+
+struct QuantizedVertex {
+    // the 4th component only pads the position to 8 bytes
+    uint16_t pos[4];
+    int16_t norm[2];
+    uint16_t uv[2];
+
+    static std::vector<VertexDescriptor> get_vertex_desc() noexcept {
+        return std::vector<VertexDescriptor>{
+            {"v_pos", 3, sizeof(QuantizedVertex), offsetof(QuantizedVertex, pos), true, GL_UNSIGNED_SHORT},
+            {"v_normal", 2, sizeof(QuantizedVertex), offsetof(QuantizedVertex, norm), true, GL_SHORT},
+            {"v_uv", 2, sizeof(QuantizedVertex), offsetof(QuantizedVertex, uv), false, GL_HALF_FLOAT},
+        };
+    }
+};
+static_assert(sizeof(QuantizedVertex) == 16);
+
+// maps the normalized [0, 1] positions of a `QuantizedVertex` back to object space
+struct PositionDequantization {
+    glm::vec3 offset;
+    glm::vec3 scale;
+};
+
+template <typename VertexT>
+struct QuantizedMesh {
+    Mesh<VertexT> mesh;
+    PositionDequantization dequantization;
+};
+
+// octahedral encoding of a unit vector into [-1, 1]^2
+glm::vec2 oct_encode(glm::vec3 norm) noexcept;
+glm::vec3 oct_decode(glm::vec2 enc) noexcept;
+
+int16_t to_snorm16(float val) noexcept;
+uint16_t to_unorm16(float val) noexcept;
+uint16_t to_half(float val) noexcept;
+float from_half(uint16_t val) noexcept;
+
+// dequantization for float positions
+inline constexpr PositionDequantization identity_dequantization = {{0.f, 0.f, 0.f}, {1.f, 1.f, 1.f}};
+
+QuantizedMesh<PackedVertex> pack_mesh(const Mesh<Vertex>& mesh);
+QuantizedMesh<QuantizedVertex> quantize_mesh(const Mesh<Vertex>& mesh);
@@ -0,0 +1,101 @@
+#include "range_allocator.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <utility>
+
+RangeAllocator::RangeAllocator(size_t capacity) {
+    grow(capacity);
+}
+
+std::optional<size_t>
+RangeAllocator::allocate(size_t size) {
+    if (size == 0) {
+        return std::nullopt;
+    }
+    for (auto it=free_.begin(); it!=free_.end(); ++it) {
+        auto [offset, free_size] = *it;
+        if (free_size < size) {
+            continue;
+        }
+        free_.erase(it);
+        if (free_size > size) {
+            free_.emplace(offset + size, free_size - size);
+        }
+        used_ += size;
+        return offset;
+    }
+    return std::nullopt;
+}
+
+void
+RangeAllocator::free(size_t offset, size_t size) {
+    if (size == 0) {
+        return;
+    }
+    assert(offset + size <= capacity_);
+    assert(used_ >= size);
+    used_ -= size;
+
+    auto next = free_.lower_bound(offset);
+    assert((next == free_.end()) || (offset + size <= next->first));
+    if ((next != free_.end()) && (next->first == offset + size)) {
+        size += next->second;
+        next = free_.erase(next);
+    }
+    if (next != free_.begin()) {
+        auto prev = std::prev(next);
+        assert(prev->first + prev->second <= offset);
+        if (prev->first + prev->second == offset) {
+            prev->second += size;
+            return;
+        }
+    }
+    free_.emplace_hint(next, offset, size);
+}
+
+void
+RangeAllocator::grow(size_t capacity) {
+    if (capacity <= capacity_) {
+        return;
+    }
+    auto old_capacity = std::exchange(capacity_, capacity);
+    // the new space is "freed", which merges it with a free range at the end
+    used_ += capacity - old_capacity;
+    free(old_capacity, capacity - old_capacity);
+}
+
+void
+RangeAllocator::reset(size_t used) {
+    assert(used <= capacity_);
+    free_.clear();
+    used_ = used;
+    if (used < capacity_) {
+        free_.emplace(used, capacity_ - used);
+    }
+}
+
+size_t
+RangeAllocator::largest_free_range() const noexcept {
+    auto ret = size_t{0};
+    for (const auto& range : free_) {
+        ret = std::max(ret, range.second);
+    }
+    return ret;
+}
+
+size_t
+RangeAllocator::capacity_for(size_t size) const noexcept {
+    if (largest_free_range() >= size) {
+        return capacity_;
+    }
+    auto tail = size_t{0};
+    if (!free_.empty()) {
+        auto [offset, free_size] = *free_.rbegin();
+        if (offset + free_size == capacity_) {
+            tail = free_size;
+        }
+    }
+    return capacity_ + size - tail;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <map>
+#include <optional>
+
+// First-fit allocator for ranges of a linear resource, e.g. the elements of
+// a buffer. Free ranges are kept sorted by offset and merged with adjacent
+// free ranges when they are released.
+class RangeAllocator {
+    public:
+        explicit RangeAllocator(size_t capacity = 0);
+
+        // nullopt if no free range is large enough
+        std::optional<size_t> allocate(size_t size);
+        // `offset` and `size` of an earlier allocation
+        void free(size_t offset, size_t size);
+
+        // adds [capacity(), capacity) as free space
+        void grow(size_t capacity);
+        // after the allocations have been moved together: [0, used) is
+        // allocated, the rest is one free range
+        void reset(size_t used);
+
+        size_t capacity() const noexcept {
+            return capacity_;
+        }
+
+        size_t used() const noexcept {
+            return used_;
+        }
+
+        size_t largest_free_range() const noexcept;
+
+        // the smallest capacity to `grow` to so that `allocate(size)`
+        // succeeds, the free range at the end counts towards it
+        size_t capacity_for(size_t size) const noexcept;
+
+        // number of gaps, 1 or 0 if not fragmented
+        size_t free_range_count() const noexcept {
+            return free_.size();
+        }
+    private:
+        // offset -> size
+        std::map<size_t, size_t> free_;
+        size_t capacity_ = 0;
+        size_t used_ = 0;
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+class Program;
+class Texture;
+
+// One draw call as submitted by a layer. Executed by `Renderer::flush` with
+// whatever uniforms are set on `program` at that point.
+struct DrawItem {
+    size_t mesh;
+    const Program* program;
+    // bound to texture unit 0, none if null
+    Texture* texture = nullptr;
+    bool transparent = false;
+    // distance along the view direction, see `Renderer::view_depth`
+    float depth = 0.f;
+};
+
+namespace sort_key {
+
+inline constexpr uint64_t transparent_bit = uint64_t{1} << 63;
+inline constexpr unsigned program_bits = 11;
+inline constexpr unsigned texture_bits = 12;
+
+// Upper `bits` bits of the float, which order like the float for depth >= 0.
+inline uint64_t quantize_depth(float depth, unsigned bits) noexcept {
+    auto raw = std::bit_cast<uint32_t>(std::max(depth, 0.f));
+    return raw >> (32-bits);
+}
+
+}
+
+// Packs the state of a draw into a key, so that sorting by key executes
+// opaque draws grouped by program, then texture, front to back within a group,
+// and after them transparent draws strictly back to front:
+//
+//   opaque:       0 | program:11 | texture:12 | depth:16  | mesh:24
+//   transparent:  1 | ~depth:24  | program:11 | texture:12 | mesh:16
+//
+// `program` and `texture` are small ids, equal ids for equal state. Mesh bits
+// only group draws of the same mesh and may be truncated.
+inline uint64_t
+make_sort_key(uint32_t program, uint32_t texture, size_t mesh, float depth, bool transparent) noexcept {
+    using namespace sort_key;
+    assert(program < (1u << program_bits));
+    assert(texture < (1u << texture_bits));
+    auto state = (uint64_t{program} << texture_bits) | texture;
+    if (!transparent) {
+        return (state << 40) | (quantize_depth(depth, 16) << 24) | (mesh & 0xffffff);
+    }
+    auto far_first = (~quantize_depth(depth, 24)) & 0xffffff;
+    return transparent_bit | (far_first << 39) | (state << 16) | (mesh & 0xffff);
+}
+
+// Collects the draws of a frame and orders them by `make_sort_key`.
+class RenderQueue {
+    public:
+        void submit(const DrawItem& item) {
+            auto program = id_of(programs_, item.program);
+            auto texture = id_of(textures_, item.texture);
+            keys_.push_back(Entry{make_sort_key(program, texture, item.mesh, item.depth, item.transparent), items_.size()});
+            items_.push_back(item);
+        }
+
+        size_t size() const noexcept {
+            return items_.size();
+        }
+
+        // the submitted items in execution order, valid until the next `submit`/`clear`
+        std::span<const DrawItem> sorted() {
+            std::sort(keys_.begin(), keys_.end(), [](const Entry& a, const Entry& b) {
+                return a.key < b.key;
+            });
+            sorted_.clear();
+            for (const auto& entry : keys_) {
+                sorted_.push_back(items_[entry.item]);
+            }
+            return sorted_;
+        }
+
+        // keeps the allocations for the next frame
+        void clear() noexcept {
+            items_.clear();
+            keys_.clear();
+            programs_.clear();
+            textures_.clear();
+        }
+
+    private:
+        struct Entry {
+            uint64_t key;
+            size_t item;
+        };
+
+        // ids are dense per frame, in order of first use
+        template <typename T>
+        static uint32_t id_of(std::unordered_map<const T*, uint32_t>& ids, const T* ptr) {
+            return ids.try_emplace(ptr, static_cast<uint32_t>(ids.size())).first->second;
+        }
+
+        std::vector<DrawItem> items_;
+        std::vector<Entry> keys_;
+        std::vector<DrawItem> sorted_;
+        std::unordered_map<const Program*, uint32_t> programs_;
+        std::unordered_map<const Texture*, uint32_t> textures_;
+};
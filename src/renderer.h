@@ -1,86 +1,565 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
+#include <climits>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <type_traits>
+#include <typeindex>
+#include <utility>
 #include <vector>
 
 #include <GL/glew.h>
-#define GLFW_INCLUDE_NONE
-#include <GLFW/glfw3.h>
 #include <glm/glm.hpp>
 
+#include "bounds.h"
 #include "buffer.h"
+#include "culling.h"
+#include "geometry_arena.h"
+#include "gl_state.h"
+#include "gpu_profiler.h"
+#include "lod.h"
 #include "mesh.h"
+#include "render_queue.h"
+#include "scene.h"
 #include "shader.h"
+#include "static_batch.h"
+#include "surface.h"
+#include "texture.h"
+#include "uniform_blocks.h"
 
-template <typename NumT>
-struct Extent2D {
-    NumT width;
-    NumT height;
+// Collects the batches of `stream_obj` in GPU buffers that grow as needed,
+// hand it to `Renderer::upload_mesh` afterwards. Must be used on the render
+// thread.
+class GpuMeshSink final : public MeshSink {
+    public:
+        void append(std::span<const Vertex> vertices, std::span<const uint32_t> indices) override {
+            vbo_.append(vertices.data(), vertices.size_bytes());
+            ibo_.append(indices.data(), indices.size_bytes());
+            for (const auto& vert : vertices) {
+                lo_ = glm::min(lo_, vert.pos);
+                hi_ = glm::max(hi_, vert.pos);
+            }
+        }
+
+        size_t index_count() const noexcept {
+            return ibo_.size()/sizeof(uint32_t);
+        }
+
+        BoundingSphere bounds() const noexcept {
+            if (vbo_.size() == 0) {
+                return BoundingSphere{glm::vec3(0.f), 0.f};
+            }
+            return BoundingSphere{(lo_+hi_)*.5f, glm::length(hi_-lo_)*.5f};
+        }
+
+        BoundingBox bounding_box() const noexcept {
+            return BoundingBox{lo_, hi_};
+        }
+    private:
+        friend class Renderer;
+
+        GrowableBuffer<BufferType::Array> vbo_;
+        GrowableBuffer<BufferType::ElementArray> ibo_;
+        glm::vec3 lo_ = glm::vec3(std::numeric_limits<float>::max());
+        glm::vec3 hi_ = glm::vec3(std::numeric_limits<float>::lowest());
 };
 
+// Per-instance attributes of `Renderer::render_instanced`, read by
+// res/instanced.vert.glsl. The locations are fixed, so they are the same in
+// every program; each matrix column takes one location.
+struct InstanceData {
+    static constexpr GLuint model_location = 8;
+    static constexpr GLuint normal_mat_location = 12;
+
+    glm::mat4 model;
+    glm::mat3 normal_mat;
+};
+
+// Owns the GPU data of meshes and batches and draws them. Like the GL state
+// it wraps, it must only be used on the render thread, there is no locking:
+// load on workers with `AssetLoader` and upload in its `process_uploads`.
 class Renderer {
     public:
         using handle_type = size_t;
 
-        Renderer(GLFWwindow* win) : win_{win} {}
+        explicit Renderer(Surface& surface) : surface_{surface} {
+            shader_manager_.set_block_binding(FrameUniforms::block_name, FrameUniforms::binding);
+            shader_manager_.set_block_binding(LightUniforms::block_name, LightUniforms::binding);
+            shader_manager_.set_block_binding(MaterialUniforms::block_name, MaterialUniforms::binding);
+            shader_manager_.set_block_binding(DeferredUniforms::block_name, DeferredUniforms::binding);
+            shader_manager_.set_block_binding(ClusterUniforms::block_name, ClusterUniforms::binding);
+        }
 
         void init() {
             glClearColor(0.0f, 0.0f, 0.3f, 1.0f);
             glClear(GL_COLOR_BUFFER_BIT);
-            glEnable(GL_BLEND);
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-            glEnable(GL_DEPTH_TEST);
-            glCullFace(GL_BACK);
-            glEnable(GL_CULL_FACE);
+            auto& state = gl_state();
+            state.set_enabled(Capability::Blend, true);
+            state.set_blend_func(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            state.set_enabled(Capability::DepthTest, true);
+            state.set_cull_face(GL_BACK);
+            state.set_enabled(Capability::CullFace, true);
+
+            auto alignment = GLint{0};
+            glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+            uniform_alignment_ = static_cast<size_t>(std::max(alignment, 1));
+            glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+            storage_alignment_ = static_cast<size_t>(std::max(alignment, 1));
+            viewport_dim_ = surface_.framebuffer_size();
         }
 
         void cleanup() {}
 
         template <typename VertexT>
         handle_type upload_mesh(const Mesh<VertexT>& mesh, const char* shader_name) {
+            return upload_mesh(mesh.view(), shader_name);
+        }
+
+        // all levels are stored under one handle, see `render(handle_type, const Camera&)`
+        template <typename VertexT>
+        handle_type upload_mesh(const LodMesh<VertexT>& mesh, const char* shader_name) {
+            return upload_mesh(mesh.view(), shader_name, mesh.lods);
+        }
+
+        // `lods` are index ranges into `mesh.index_data`, the whole index
+        // buffer is a single level if empty
+        template <typename VertexT>
+        handle_type upload_mesh(MeshView<VertexT> mesh, const char* shader_name, std::span<const MeshLod> lods = {}) {
             GLuint vao;
             glGenVertexArrays(1, &vao);
-            glBindVertexArray(vao);
+            gl_state().bind_vertex_array(vao);
 
             auto vbo = Buffer<BufferType::Array>{};
             vbo.bind();
             vbo.set_data(
                 mesh.vertex_data.data(),
-                mesh.vertex_data.size()*sizeof(VertexT),
+                mesh.vertex_data.size_bytes(),
                 GL_STATIC_DRAW
             );
 
             auto ibo = Buffer<BufferType::ElementArray>{};
             ibo.bind();
-            ibo.set_data(
-                mesh.index_data.data(),
-                mesh.index_data.size()*sizeof(uint32_t),
-                GL_STATIC_DRAW
-            );
+            auto index_type = GLenum{GL_UNSIGNED_INT};
+            if (mesh.vertex_data.size() <= (size_t{UINT16_MAX} + 1)) {
+                // all indices fit into 16 bits: halve the index buffer
+                auto short_indices = std::vector<uint16_t>(mesh.index_data.begin(), mesh.index_data.end());
+                ibo.set_data(
+                    short_indices.data(),
+                    short_indices.size()*sizeof(uint16_t),
+                    GL_STATIC_DRAW
+                );
+                index_type = GL_UNSIGNED_SHORT;
+            } else {
+                ibo.set_data(
+                    mesh.index_data.data(),
+                    mesh.index_data.size_bytes(),
+                    GL_STATIC_DRAW
+                );
+            }
 
             for (auto&& desc : VertexT::get_vertex_desc()) {
                 shader_manager_.get_shader(shader_name).set_attrib_pointer(desc);
             }
 
-            // TODO: locking
-            meshes_.push_back(mesh_handle{std::move(vao), std::move(vbo), std::move(ibo), mesh.index_data.size()});
-            auto ret_idx = meshes_.size()-1;
+            auto hndl = mesh_handle{
+                std::move(vao),
+                std::move(vbo),
+                std::move(ibo),
+                index_type,
+                {lods.begin(), lods.end()},
+                compute_bounding_sphere(mesh.vertex_data)
+            };
+            if (hndl.lods.empty()) {
+                hndl.lods.push_back(MeshLod{0, mesh.index_data.size(), 0.f});
+            }
+
+            return add_mesh(std::move(hndl), compute_bounding_box(mesh.vertex_data));
+        }
+
+        template <typename VertexT>
+        handle_type upload_mesh_shared(const Mesh<VertexT>& mesh, const char* shader_name) {
+            return upload_mesh_shared(mesh.view(), shader_name);
+        }
+
+        template <typename VertexT>
+        handle_type upload_mesh_shared(const LodMesh<VertexT>& mesh, const char* shader_name) {
+            return upload_mesh_shared(mesh.view(), shader_name, mesh.lods);
+        }
+
+        // Like `upload_mesh`, but suballocates the data from the
+        // `GeometryArena` of the vertex format and program. All meshes of an
+        // arena share one vertex array, so drawing them doesn't switch it.
+        template <typename VertexT>
+        handle_type upload_mesh_shared(MeshView<VertexT> mesh, const char* shader_name, std::span<const MeshLod> lods = {}) {
+            auto key = std::make_pair(std::type_index(typeid(VertexT)), std::string(shader_name));
+            auto& arena = arenas_[key];
+            if (!arena) {
+                arena = std::make_unique<GeometryArena>(
+                    sizeof(VertexT),
+                    VertexT::get_vertex_desc(),
+                    shader_manager_.get_shader(shader_name)
+                );
+            }
+            auto range = arena->add(mesh);
+
+            auto hndl = mesh_handle{
+                arena->vao(),
+                std::nullopt,
+                std::nullopt,
+                GL_UNSIGNED_INT,
+                {lods.begin(), lods.end()},
+                compute_bounding_sphere(mesh.vertex_data)
+            };
+            hndl.arena = arena.get();
+            hndl.arena_range = range;
+            if (hndl.lods.empty()) {
+                hndl.lods.push_back(MeshLod{0, mesh.index_data.size(), 0.f});
+            }
+
+            return add_mesh(std::move(hndl), compute_bounding_box(mesh.vertex_data));
+        }
+
+        // Frees the GPU data of a mesh, drawing it does nothing afterwards and
+        // culling always rejects it. The handle is handed out again by a later
+        // upload, releasing it twice is an error.
+        void release_mesh(handle_type mesh_hndl) {
+            auto& mesh = meshes_[mesh_hndl];
+            assert(!mesh.released);
+            if (mesh.released) {
+                return;
+            }
+            if (mesh.arena != nullptr) {
+                mesh.arena->remove(mesh.arena_range);
+                mesh.arena = nullptr;
+            } else if (mesh.vbo) {
+                gl_state().forget_vertex_array(mesh.vao);
+                glDeleteVertexArrays(1, &mesh.vao);
+                mesh.vbo.reset();
+                mesh.ibo.reset();
+            }
+            mesh.vao = 0;
+            mesh.lods = {MeshLod{0, 0, 0.f}};
+            mesh.released = true;
+            // outside of every frustum
+            mesh.bounds = BoundingSphere{glm::vec3(0.f), 0.f};
+            bounds_.set(mesh_hndl, BoundingBox::empty(), mesh.bounds);
+            free_handles_.push_back(mesh_hndl);
+        }
+
+        // closes the gaps released meshes left in the geometry arenas
+        void compact_geometry() {
+            for (auto& [key, arena] : arenas_) {
+                arena->compact();
+            }
+        }
+
+        // takes over the buffers of a streamed mesh
+        handle_type upload_mesh(GpuMeshSink&& mesh, const char* shader_name) {
+            GLuint vao;
+            glGenVertexArrays(1, &vao);
+            gl_state().bind_vertex_array(vao);
+
+            auto index_count = mesh.index_count();
+            auto bounds = mesh.bounds();
+            auto vbo = std::move(mesh.vbo_).release();
+            vbo.bind();
+            auto ibo = std::move(mesh.ibo_).release();
+            ibo.bind();
+
+            for (auto&& desc : Vertex::get_vertex_desc()) {
+                shader_manager_.get_shader(shader_name).set_attrib_pointer(desc);
+            }
+
+            return add_mesh(mesh_handle{
+                std::move(vao),
+                std::move(vbo),
+                std::move(ibo),
+                GL_UNSIGNED_INT,
+                {MeshLod{0, index_count, 0.f}},
+                bounds
+            }, mesh.bounding_box());
+        }
+
+        // Uploads the shared buffers of `batch`, see `render_static`. The
+        // program has to read the per-draw data like res/static.vert.glsl.
+        template <typename VertexT>
+        handle_type upload_static_batch(const StaticBatch<VertexT>& batch, const char* shader_name) {
+            GLuint vao;
+            glGenVertexArrays(1, &vao);
+            gl_state().bind_vertex_array(vao);
+
+            auto hndl = static_batch_handle{vao};
+            hndl.vbo.bind();
+            hndl.vbo.set_data(batch.vertex_data().data(), batch.vertex_data().size_bytes(), GL_STATIC_DRAW);
+            const auto& prog = shader_manager_.get_shader(shader_name);
+            for (auto&& desc : VertexT::get_vertex_desc()) {
+                prog.set_attrib_pointer(desc);
+            }
+
+            // v_draw_id advances once per instance and starts at the base
+            // instance of the command, which is the draw index
+            auto draw_ids = std::vector<uint32_t>(batch.commands().size());
+            for (uint32_t i=0; i<draw_ids.size(); ++i) {
+                draw_ids[i] = i;
+            }
+            hndl.draw_ids.bind();
+            hndl.draw_ids.set_data(draw_ids.data(), draw_ids.size()*sizeof(uint32_t), GL_STATIC_DRAW);
+            if (auto loc = prog.get_attrib_location("v_draw_id")) {
+                glVertexAttribIPointer(*loc, 1, GL_UNSIGNED_INT, sizeof(uint32_t), nullptr);
+                glVertexAttribDivisor(*loc, 1);
+                glEnableVertexAttribArray(*loc);
+            } else {
+                spdlog::info("program \"{}\" has no v_draw_id attribute", shader_name);
+            }
+
+            hndl.ibo.bind();
+            hndl.ibo.set_data(batch.index_data().data(), batch.index_data().size_bytes(), GL_STATIC_DRAW);
+            hndl.draw_data.set_data(batch.draw_data().data(), batch.draw_data().size_bytes(), GL_STATIC_DRAW);
+
+            hndl.commands.assign(batch.commands().begin(), batch.commands().end());
+            for (size_t i=0; i<batch.commands().size(); ++i) {
+                hndl.bounds.push_back(batch.draw_boxes()[i], batch.draw_spheres()[i]);
+            }
+
+            static_batches_.push_back(std::move(hndl));
+            return static_batches_.size()-1;
+        }
+
+        // Draws the commands of a static batch whose bounds intersect the
+        // view frustum of `cam` with a single glMultiDrawElementsIndirect.
+        // The counts are added to `cull_stats()`. Uses the current program.
+        void render_static(handle_type batch_hndl, const Camera& cam) {
+            auto& batch = static_batches_[batch_hndl];
+            visible_.resize(batch.bounds.size());
+            auto visible_count = batch.bounds.cull(Frustum::from_camera(cam), visible_);
+            cull_stats_.culled += batch.bounds.size() - visible_count;
+            cull_stats_.drawn += visible_count;
+            if (visible_count == 0) {
+                return;
+            }
+
+            // the visible commands go straight into this frame's part of the ring
+            auto alloc = indirect_ring_.allocate(visible_count*sizeof(DrawElementsIndirectCommand), alignof(DrawElementsIndirectCommand));
+            auto cmds = static_cast<DrawElementsIndirectCommand*>(alloc.ptr);
+            for (size_t i=0; i<batch.commands.size(); ++i) {
+                if (visible_[i]) {
+                    *cmds++ = batch.commands[i];
+                }
+            }
+
+            if (gl_state().bind_vertex_array(batch.vao)) {
+                ++state_changes_.vertex_arrays;
+            }
+            gl_state().bind_buffer_base(BufferType::ShaderStorage, static_draw_data_binding, batch.draw_data.handle());
+            assert(visible_count < INT_MAX);
+            indirect_ring_.buffer().bind();
+            glMultiDrawElementsIndirect(
+                GL_TRIANGLES,
+                GL_UNSIGNED_INT,
+                reinterpret_cast<const void*>(alloc.offset),
+                static_cast<GLsizei>(visible_count),
+                0
+            );
+        }
 
-            return ret_idx;
+        // Draws the finest level of detail once per model matrix, all in one
+        // call. The current program has to take the attributes of
+        // `InstanceData` like res/instanced.vert.glsl, with the same vertex
+        // attribute locations as the program the mesh was uploaded with.
+        void render_instanced(handle_type mesh_hndl, std::span<const glm::mat4> models) {
+            if (models.empty()) {
+                return;
+            }
+            auto& mesh = meshes_[mesh_hndl];
+            // aligned to whole instances, so the base instance selects them
+            auto alloc = instance_ring_.allocate(models.size()*sizeof(InstanceData), sizeof(InstanceData));
+            auto instances = static_cast<InstanceData*>(alloc.ptr);
+            for (size_t i=0; i<models.size(); ++i) {
+                instances[i] = InstanceData{models[i], glm::inverseTranspose(glm::mat3(models[i]))};
+            }
+
+            // the attributes point to the start of the ring buffer, which
+            // only changes when it grows
+            if (mesh.instance_generation != instance_ring_.generation()) {
+                gl_state().bind_vertex_array(mesh.vao);
+                instance_ring_.buffer().bind();
+                auto set_columns = [](GLuint location, GLint rows, GLuint columns, size_t offset) {
+                    for (GLuint col=0; col<columns; ++col) {
+                        glVertexAttribPointer(
+                            location + col,
+                            rows,
+                            GL_FLOAT,
+                            GL_FALSE,
+                            sizeof(InstanceData),
+                            reinterpret_cast<const void*>(offset + col*static_cast<size_t>(rows)*sizeof(float))
+                        );
+                        glVertexAttribDivisor(location + col, 1);
+                        glEnableVertexAttribArray(location + col);
+                    }
+                };
+                set_columns(InstanceData::model_location, 4, 4, offsetof(InstanceData, model));
+                set_columns(InstanceData::normal_mat_location, 3, 3, offsetof(InstanceData, normal_mat));
+                mesh.instance_generation = instance_ring_.generation();
+            }
+            assert(models.size() < INT_MAX);
+            assert(alloc.offset/sizeof(InstanceData) < UINT_MAX);
+            draw_level(mesh, 0, static_cast<GLsizei>(models.size()), static_cast<GLuint>(alloc.offset/sizeof(InstanceData)));
         }
 
+        // Copies `block` (one of the structs in uniform_blocks.h) to this
+        // frame's part of the uniform ring and binds it to the block's
+        // binding index. All programs read it until the block is set again,
+        // so set per-frame blocks once a frame and material blocks whenever
+        // the material changes. The ring reuses the memory after a few
+        // frames: a block has to be set in every frame that uses it.
+        template <typename BlockT>
+        void set_uniform_block(const BlockT& block) {
+            auto& data = uniform_blocks_[BlockT::binding];
+            data.resize(sizeof(BlockT));
+            std::memcpy(data.data(), &block, sizeof(BlockT));
+            upload_block(uniform_ring_, uniform_blocks_, uniform_alignment_, BlockT::binding, data);
+        }
+
+        // Like `set_uniform_block` for the `std430` shader storage buffer at
+        // `binding`, for arrays that change every frame such as the point
+        // lights. Nothing is bound for an empty array.
+        template <typename T>
+        void set_storage_block(GLuint binding, std::span<T> values) {
+            static_assert(std::is_trivially_copyable_v<T>);
+            auto& data = storage_blocks_[binding];
+            data.resize(values.size_bytes());
+            std::memcpy(data.data(), values.data(), values.size_bytes());
+            upload_block(storage_ring_, storage_blocks_, storage_alignment_, binding, data);
+        }
+
+        // frame boundaries for the per-frame ring buffers, all draws of a
+        // frame have to be issued in between
+        void begin_frame() {
+            viewport_dim_ = surface_.framebuffer_size();
+            cull_stats_ = CullStats{};
+            instance_ring_.begin_frame();
+            indirect_ring_.begin_frame();
+            uniform_ring_.begin_frame();
+            storage_ring_.begin_frame();
+            profiler_.begin_frame();
+        }
+
+        void end_frame() {
+            profiler_.end_frame();
+            instance_ring_.end_frame();
+            indirect_ring_.end_frame();
+            uniform_ring_.end_frame();
+            storage_ring_.end_frame();
+            gl_state().end_frame();
+        }
+
+        // draws the finest level of detail
         void render(handle_type mesh_hndl) const {
-            assert(meshes_[mesh_hndl].ibo_size < INT_MAX);
+            draw_level(meshes_[mesh_hndl], 0);
+        }
+
+        // draws the coarsest level of detail whose error stays below
+        // `lod_screen_error()` pixels when seen from `cam`
+        void render(handle_type mesh_hndl, const Camera& cam) const {
             const auto& mesh = meshes_[mesh_hndl];
-            glBindVertexArray(mesh.vao);
-            glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(mesh.ibo_size), GL_UNSIGNED_INT, 0);
+            auto viewport_height = static_cast<float>(viewport_dim_.height);
+            draw_level(mesh, select_lod(mesh.lods, mesh.bounds, cam, viewport_height, lod_screen_error_));
+        }
+
+        // Draws the meshes in `mesh_hndls` that intersect the view frustum of
+        // `cam`, like `render(handle_type, const Camera&)`. The bounds of all
+        // meshes are tested in one pass before drawing, the counts are added
+        // to `cull_stats()`.
+        void render(std::span<const handle_type> mesh_hndls, const Camera& cam) {
+            visible_.resize(bounds_.size());
+            bounds_.cull(Frustum::from_camera(cam), visible_);
+            for (auto hndl : mesh_hndls) {
+                if (!visible_[hndl]) {
+                    ++cull_stats_.culled;
+                    continue;
+                }
+                render(hndl, cam);
+                ++cull_stats_.drawn;
+            }
+        }
+
+        // queued until `flush`, in which draws are reordered to save state changes
+        void submit(const DrawItem& item) {
+            queue_.submit(item);
+        }
+
+        // Culls the submitted draws against the view frustum of `cam` and
+        // executes the rest in the order of `make_sort_key`. Programs,
+        // textures and vertex arrays are only bound when they change. The
+        // counts are added to `cull_stats()`.
+        void flush(const Camera& cam) {
+            visible_.resize(bounds_.size());
+            bounds_.cull(Frustum::from_camera(cam), visible_);
+            state_changes_ = StateChanges{};
+
+            auto& state = gl_state();
+            for (const auto& item : queue_.sorted()) {
+                if (!visible_[item.mesh]) {
+                    ++cull_stats_.culled;
+                    continue;
+                }
+                if (item.program->use()) {
+                    ++state_changes_.programs;
+                }
+                auto texture_changed = (item.texture != nullptr) ? item.texture->bind() : state.bind_texture(0, 0);
+                if (texture_changed) {
+                    ++state_changes_.textures;
+                }
+                render(item.mesh, cam);
+                ++cull_stats_.drawn;
+            }
+            state.bind_texture(0, 0);
+            queue_.clear();
+        }
+
+        // distance of the mesh's bounding sphere center along the view direction of `cam`
+        float view_depth(handle_type mesh_hndl, const Camera& cam) const noexcept {
+            return glm::dot(meshes_[mesh_hndl].bounds.center - cam.pos, cam.local_ccs().e_z);
+        }
+
+        // of all culled draws since `begin_frame`: `flush`,
+        // `render(std::span<const handle_type>, const Camera&)` and `render_static`
+        const CullStats& cull_stats() const noexcept {
+            return cull_stats_;
+        }
+
+        struct StateChanges {
+            size_t programs = 0;
+            size_t textures = 0;
+            size_t vertex_arrays = 0;
+        };
+
+        // of the last call to `flush`
+        const StateChanges& state_changes() const noexcept {
+            return state_changes_;
         }
 
+        float lod_screen_error() const noexcept {
+            return lod_screen_error_;
+        }
+
+        void set_lod_screen_error(float pixels) noexcept {
+            lod_screen_error_ = pixels;
+        }
+
+        // the size of the surface's framebuffer, queried once per frame in
+        // `begin_frame`
         Extent2D<int> get_viewport_dim() const noexcept {
-            auto ret = Extent2D<int>{};
-            glfwGetFramebufferSize(win_, &(ret.width), &(ret.height));
-            return ret;
+            return viewport_dim_;
         }
 
         void clear_screen() const noexcept {
@@ -90,6 +569,15 @@ class Renderer {
             glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
         }
 
+        // zones of the current frame, e.g. `auto zone = profiler().zone("shadows");`
+        GpuProfiler& profiler() noexcept {
+            return profiler_;
+        }
+
+        const GpuProfiler& profiler() const noexcept {
+            return profiler_;
+        }
+
         ShaderManager& shader_manager() {
             return shader_manager_;
         }
@@ -99,14 +587,134 @@ class Renderer {
         }
 
     private:
-        GLFWwindow* win_;
+        Surface& surface_;
 
         struct mesh_handle {
+            uint32_t vao;
+            // none for meshes in an arena
+            std::optional<Buffer<BufferType::Array>> vbo;
+            std::optional<Buffer<BufferType::ElementArray>> ibo;
+            GLenum index_type;
+            std::vector<MeshLod> lods;
+            BoundingSphere bounds;
+            // generation of the instance ring the instance attributes refer
+            // to, set up by `render_instanced`, 0 before
+            uint64_t instance_generation = 0;
+            // `lods` are relative to the arena range
+            GeometryArena* arena = nullptr;
+            GeometryArena::range_id arena_range = 0;
+            // by `release_mesh`, until the handle is reused
+            bool released = false;
+        };
+
+        // shader storage binding of the `StaticDrawData` array
+        static constexpr GLuint static_draw_data_binding = 0;
+
+        struct static_batch_handle {
             uint32_t vao;
             Buffer<BufferType::Array> vbo;
+            Buffer<BufferType::Array> draw_ids;
             Buffer<BufferType::ElementArray> ibo;
-            size_t ibo_size;
+            Buffer<BufferType::ShaderStorage> draw_data;
+            // all commands, the visible ones are copied to the ring buffer per frame
+            std::vector<DrawElementsIndirectCommand> commands;
+            BoundsList bounds;
         };
+
+        // into the slot of a released mesh if there is one
+        handle_type add_mesh(mesh_handle&& hndl, const BoundingBox& box) {
+            if (!free_handles_.empty()) {
+                auto ret = free_handles_.back();
+                free_handles_.pop_back();
+                bounds_.set(ret, box, hndl.bounds);
+                meshes_[ret] = std::move(hndl);
+                return ret;
+            }
+            bounds_.push_back(box, hndl.bounds);
+            meshes_.push_back(std::move(hndl));
+            return meshes_.size()-1;
+        }
+
+        // `blocks` holds the last data of each binding of `ring`
+        template <BufferType Type>
+        void upload_block(
+                RingBuffer<Type>& ring,
+                const std::map<GLuint, std::vector<std::byte>>& blocks,
+                size_t alignment,
+                GLuint binding,
+                std::span<const std::byte> data) {
+            if (data.empty()) {
+                return;
+            }
+            auto generation = ring.generation();
+            auto alloc = ring.allocate(data.size(), alignment);
+            std::memcpy(alloc.ptr, data.data(), data.size());
+            gl_state().bind_buffer_range(Type, binding, ring.buffer().handle(), alloc.offset, data.size());
+            if (ring.generation() != generation) {
+                // the ring grew, the other blocks were bound from the deleted buffer
+                for (const auto& [other, other_data] : blocks) {
+                    if (other != binding) {
+                        upload_block(ring, blocks, alignment, other, other_data);
+                    }
+                }
+            }
+        }
+
+        void draw_level(const mesh_handle& mesh, size_t level, GLsizei instance_count = 1, GLuint base_instance = 0) const {
+            const auto& lod = mesh.lods[level];
+            if (lod.index_count == 0) {
+                return;
+            }
+            assert(lod.index_count < INT_MAX);
+            auto index_size = (mesh.index_type == GL_UNSIGNED_SHORT) ? sizeof(uint16_t) : sizeof(uint32_t);
+            auto first_index = lod.index_offset;
+            auto base_vertex = GLint{0};
+            if (mesh.arena != nullptr) {
+                const auto& range = mesh.arena->range(mesh.arena_range);
+                first_index += range.first_index;
+                assert(range.first_vertex < INT_MAX);
+                base_vertex = static_cast<GLint>(range.first_vertex);
+            }
+            if (gl_state().bind_vertex_array(mesh.vao)) {
+                ++state_changes_.vertex_arrays;
+            }
+            glDrawElementsInstancedBaseVertexBaseInstance(
+                GL_TRIANGLES,
+                static_cast<GLsizei>(lod.index_count),
+                mesh.index_type,
+                reinterpret_cast<const void*>(first_index*index_size),
+                instance_count,
+                base_vertex,
+                base_instance
+            );
+        }
+
+        // per vertex format and program
+        std::map<std::pair<std::type_index, std::string>, std::unique_ptr<GeometryArena>> arenas_;
         std::vector<mesh_handle> meshes_;
+        // released, to be reused
+        std::vector<handle_type> free_handles_;
+        // per mesh, same order as `meshes_`
+        BoundsList bounds_;
+        std::vector<uint8_t> visible_;
+        CullStats cull_stats_;
+        RenderQueue queue_;
+        std::vector<static_batch_handle> static_batches_;
+        // per-frame data, grown on demand
+        RingBuffer<BufferType::Array> instance_ring_{1024*sizeof(InstanceData)};
+        RingBuffer<BufferType::DrawIndirect> indirect_ring_{1024*sizeof(DrawElementsIndirectCommand)};
+        RingBuffer<BufferType::Uniform> uniform_ring_{16*1024};
+        RingBuffer<BufferType::ShaderStorage> storage_ring_{64*1024};
+        // last value of each block by binding, uploaded again if the ring grows
+        std::map<GLuint, std::vector<std::byte>> uniform_blocks_;
+        std::map<GLuint, std::vector<std::byte>> storage_blocks_;
+        // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT and
+        // GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, queried in `init`
+        size_t uniform_alignment_ = 256;
+        size_t storage_alignment_ = 256;
+        mutable StateChanges state_changes_;
         ShaderManager shader_manager_;
+        GpuProfiler profiler_;
+        float lod_screen_error_ = 1.f;
+        Extent2D<int> viewport_dim_ = {};
 };
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+// The last `capacity` samples of a measurement, e.g. a frame time, with their
+// mean and percentiles.
+class RollingStats {
+    public:
+        explicit RollingStats(size_t capacity = 120) : capacity_{capacity} {
+            assert(capacity > 0);
+            samples_.reserve(capacity);
+        }
+
+        // replaces the oldest sample once full
+        void push(float sample) {
+            if (samples_.size() < capacity_) {
+                samples_.push_back(sample);
+            } else {
+                samples_[next_] = sample;
+            }
+            next_ = (next_ + 1) % capacity_;
+        }
+
+        size_t size() const noexcept {
+            return samples_.size();
+        }
+
+        bool empty() const noexcept {
+            return samples_.empty();
+        }
+
+        float last() const noexcept {
+            assert(!empty());
+            return samples_[(next_ + capacity_ - 1) % capacity_];
+        }
+
+        float mean() const noexcept {
+            if (empty()) {
+                return 0.f;
+            }
+            auto sum = 0.;
+            for (auto sample : samples_) {
+                sum += static_cast<double>(sample);
+            }
+            return static_cast<float>(sum/static_cast<double>(samples_.size()));
+        }
+
+        // nearest rank, `p` in [0, 1]: 0 is the minimum, 1 the maximum
+        float percentile(float p) const {
+            if (empty()) {
+                return 0.f;
+            }
+            sorted_.assign(samples_.begin(), samples_.end());
+            auto rank = static_cast<size_t>(std::ceil(std::clamp(p, 0.f, 1.f)*static_cast<float>(sorted_.size())));
+            auto idx = std::clamp(rank, size_t{1}, sorted_.size()) - 1;
+            std::nth_element(sorted_.begin(), sorted_.begin() + static_cast<std::ptrdiff_t>(idx), sorted_.end());
+            return sorted_[idx];
+        }
+    private:
+        size_t capacity_;
+        std::vector<float> samples_;
+        // where the next sample goes once full
+        size_t next_ = 0;
+        // scratch space of `percentile`
+        mutable std::vector<float> sorted_;
+};
@@ -48,6 +48,17 @@ struct Light {
     float intensity;
 };
 
+// Lights a sphere of `radius` around `pos`, fading out towards its border.
+// Laid out like `PointLight` in res/deferred_point.*.glsl and
+// res/cluster*.glsl (std430).
+struct PointLight {
+    glm::vec3 pos;
+    float radius;
+    glm::vec3 color;
+    float intensity;
+};
+static_assert(sizeof(PointLight) == 32);
+
 struct Scene {
     Camera cam;
     struct AmbientLight {
@@ -55,4 +66,6 @@ struct Scene {
         float intensity;
     } ambient;
     Light diffuse;
+    // drawn by `DeferredShading` or `ClusteredLighting`
+    std::vector<PointLight> point_lights;
 };
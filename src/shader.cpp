@@ -1,8 +1,29 @@
 #include "shader.h"
 
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+// for the binary search in `Program::find_variable`
+void
+sort_by_hash(std::vector<Program::ActiveVariable>& vars) {
+    std::sort(vars.begin(), vars.end(), [](const Program::ActiveVariable& a, const Program::ActiveVariable& b) {
+        return a.hash < b.hash;
+    });
+    auto collision = std::adjacent_find(vars.begin(), vars.end(), [](const Program::ActiveVariable& a, const Program::ActiveVariable& b) {
+        return a.hash == b.hash;
+    });
+    if (collision != vars.end()) {
+        throw GLSBError(("shader variables with equal name hashes: "s + collision->name + ", " + std::next(collision)->name).c_str());
+    }
+}
+
+}
+
 void
 Program::link_program(const std::vector<Shader>& shaders) {
-    prog_ = UniqueProgramHandle(glCreateProgram(), glDeleteProgram);
+    prog_ = UniqueProgramHandle(glCreateProgram());
     for (const auto& shader : shaders) {
         glAttachShader(prog_.get(), shader.shader_.get());
     }
@@ -17,6 +38,56 @@ Program::link_program(const std::vector<Shader>& shaders) {
 
         throw GLSBError(buf);
     }
+    reflect();
+}
+
+void
+Program::reflect() {
+    auto read = [this](GLenum count_param, GLenum length_param, auto get_active, auto get_location) {
+        auto count = GLint{0};
+        glGetProgramiv(prog_.get(), count_param, &count);
+        auto max_length = GLint{0};
+        glGetProgramiv(prog_.get(), length_param, &max_length);
+        auto buf = std::vector<char>(static_cast<size_t>(std::max(max_length, 1)));
+
+        auto ret = std::vector<ActiveVariable>{};
+        for (GLuint i=0; i<static_cast<GLuint>(count); ++i) {
+            auto len = GLsizei{0};
+            auto size = GLint{0};
+            auto type = GLenum{0};
+            get_active(prog_.get(), i, static_cast<GLsizei>(buf.size()), &len, &size, &type, buf.data());
+            auto location = get_location(prog_.get(), buf.data());
+            if (location < 0) {
+                // built-ins and members of uniform blocks
+                continue;
+            }
+            auto name = std::string(buf.data(), static_cast<size_t>(len));
+            if (name.ends_with("[0]")) {
+                name.resize(name.size()-3);
+            }
+            ret.push_back(ActiveVariable{hash_name(name), location, type, size, std::move(name)});
+        }
+        sort_by_hash(ret);
+        return ret;
+    };
+    uniforms_ = read(GL_ACTIVE_UNIFORMS, GL_ACTIVE_UNIFORM_MAX_LENGTH, glGetActiveUniform, glGetUniformLocation);
+    attributes_ = read(GL_ACTIVE_ATTRIBUTES, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, glGetActiveAttrib, glGetAttribLocation);
+
+    auto block_count = GLint{0};
+    glGetProgramiv(prog_.get(), GL_ACTIVE_UNIFORM_BLOCKS, &block_count);
+    auto max_length = GLint{0};
+    glGetProgramiv(prog_.get(), GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &max_length);
+    auto buf = std::vector<char>(static_cast<size_t>(std::max(max_length, 1)));
+    uniform_blocks_.clear();
+    for (GLuint i=0; i<static_cast<GLuint>(block_count); ++i) {
+        auto len = GLsizei{0};
+        glGetActiveUniformBlockName(prog_.get(), i, static_cast<GLsizei>(buf.size()), &len, buf.data());
+        auto size = GLint{0};
+        glGetActiveUniformBlockiv(prog_.get(), i, GL_UNIFORM_BLOCK_DATA_SIZE, &size);
+        auto name = std::string(buf.data(), static_cast<size_t>(len));
+        uniform_blocks_.push_back(ActiveVariable{hash_name(name), static_cast<GLint>(i), GL_UNIFORM_BLOCK, size, std::move(name)});
+    }
+    sort_by_hash(uniform_blocks_);
 }
 
 void
@@ -1,9 +1,17 @@
 #pragma once
 
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cstdint>
+#include <deque>
 #include <optional>
+#include <span>
 #include <string>
 using namespace std::string_literals;
+#include <string_view>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 #include <glm/glm.hpp>
@@ -11,6 +19,7 @@ using namespace std::string_literals;
 
 #include <spdlog/spdlog.h>
 
+#include "gl_state.h"
 #include "utils.h"
 
 struct VertexDescriptor {
@@ -19,6 +28,8 @@ struct VertexDescriptor {
     uint32_t stride;
     uintptr_t offset;
     bool is_normalized;
+    // component type, e.g. GL_SHORT for packed attributes
+    GLenum type = GL_FLOAT;
 };
 
 class Shader {
@@ -28,6 +39,8 @@ class Shader {
         enum class Type : GLenum {
             Vertex = GL_VERTEX_SHADER,
             Fragment = GL_FRAGMENT_SHADER,
+            // alone in a program, see `ClusteredLighting`
+            Compute = GL_COMPUTE_SHADER,
         };
 
         Shader(Type type, const char* source) : shader_{0, glDeleteShader} {
@@ -42,25 +55,74 @@ class Shader {
 };
 
 
+// FNV-1a, shader variables are looked up by the hash of their name
+constexpr uint32_t
+hash_name(std::string_view name) noexcept {
+    auto ret = uint32_t{2166136261u};
+    for (auto c : name) {
+        ret ^= static_cast<uint8_t>(c);
+        ret *= 16777619u;
+    }
+    return ret;
+}
+
+// Name of a uniform or attribute. Made implicitly from string literals, which
+// are hashed at compile time; use `runtime` for other strings.
+class VariableName {
+    public:
+        consteval VariableName(const char* str) noexcept : hash{hash_name(str)}, name{str} {}
+
+        static constexpr VariableName runtime(const char* str) noexcept {
+            return VariableName(hash_name(str), str);
+        }
+
+        uint32_t hash;
+        // for messages, must outlive the lookup
+        const char* name;
+    private:
+        constexpr VariableName(uint32_t h, const char* str) noexcept : hash{h}, name{str} {}
+};
+
+// location of a uniform, resolved with `Program::get_uniform_location`
+struct UniformLocation {
+    GLint value;
+};
+
 class Program {
     public:
-        using UniqueProgramHandle = UniqueHandle<GLuint, decltype(glDeleteProgram)>;
+        struct ProgramDeleter {
+            void operator()(GLuint prog_hndl) const noexcept {
+                gl_state().forget_program(prog_hndl);
+                glDeleteProgram(prog_hndl);
+            }
+        };
+        using UniqueProgramHandle = UniqueHandle<GLuint, ProgramDeleter>;
 
-        Program(const std::vector<Shader>& shaders) : prog_{0, glDeleteProgram} {
+        // active uniform or attribute, arrays under the name without "[0]"
+        struct ActiveVariable {
+            uint32_t hash;
+            GLint location;
+            GLenum type;
+            GLint size;
+            std::string name;
+        };
+
+        Program(const std::vector<Shader>& shaders) : prog_{} {
             link_program(shaders);
         }
 
-        std::optional<GLuint> get_attrib_location(const char* name) const noexcept {
-            auto pos = glGetAttribLocation(prog_.get(), name);
-            if ((pos == -1) || (pos == GL_INVALID_OPERATION)) {
+        // from the table built after linking, no driver query
+        std::optional<GLuint> get_attrib_location(VariableName name) const noexcept {
+            auto var = find_variable(attributes_, name);
+            if (var == nullptr) {
                 return std::nullopt;
             }
-            assert(pos >= 0);
-            return pos;
+            assert(var->location >= 0);
+            return static_cast<GLuint>(var->location);
         }
 
         bool set_attrib_pointer(const VertexDescriptor& desc) const {
-            auto pos = get_attrib_location(desc.name);
+            auto pos = get_attrib_location(VariableName::runtime(desc.name));
             if (!pos) {
                 spdlog::info("trying to bind unkown attribute \"{}\"", desc.name);
                 return false;
@@ -70,7 +132,7 @@ class Program {
             glVertexAttribPointer(
                 *pos,
                 static_cast<GLint>(desc.count),
-                GL_FLOAT,
+                desc.type,
                 desc.is_normalized ? GL_TRUE : GL_FALSE,
                 static_cast<GLsizei>(desc.stride),
                 reinterpret_cast<void*>(desc.offset));
@@ -78,81 +140,170 @@ class Program {
             return true;
         }
 
-        std::optional<GLint> get_uniform_location(const char* name) const noexcept {
-            auto pos = glGetUniformLocation(prog_.get(), name);
-            if ((pos == -1) || (pos == GL_INVALID_OPERATION) || pos == GL_INVALID_VALUE) {
+        // from the table built after linking, no driver query
+        std::optional<UniformLocation> get_uniform_location(VariableName name) const noexcept {
+            auto var = find_variable(uniforms_, name);
+            if (var == nullptr) {
                 return std::nullopt;
             }
-            return pos;
+            return UniformLocation{var->location};
         }
 
-        bool set_uniform(const char* name, float val) const noexcept {
+        // The setters write to the program in use. Those taking a name look
+        // the location up by hash, keep a `UniformLocation` to skip that.
+        template <typename T>
+        bool set_uniform(VariableName name, const T& val) const noexcept {
             auto loc = get_uniform_location(name);
             if (!loc) {
-                spdlog::info("trying to set unknown uniform \"{}\"", name);
+                spdlog::info("trying to set unknown uniform \"{}\"", name.name);
                 return false;
             }
-            glUniform1f(*loc, val);
+            set_uniform(*loc, val);
             return true;
         }
 
-        bool set_uniform(const char* name, const glm::vec3& val) const noexcept {
-            auto loc = get_uniform_location(name);
-            if (!loc) {
-                spdlog::info("trying to set unknown uniform \"{}\"", name);
-                return false;
-            }
-            glUniform3f(*loc, val[0], val[1], val[2]);
-            return true;
+        // e.g. the texture unit of a sampler
+        void set_uniform(UniformLocation loc, GLint val) const noexcept {
+            glUniform1i(loc.value, val);
         }
 
-        bool set_uniform(const char* name, const glm::vec4& val) const noexcept {
-            auto loc = get_uniform_location(name);
-            if (!loc) {
-                spdlog::info("trying to set unknown uniform \"{}\"", name);
-                return false;
-            }
-            glUniform4f(*loc, val[0], val[1], val[2], val[3]);
-            return true;
+        void set_uniform(UniformLocation loc, float val) const noexcept {
+            glUniform1f(loc.value, val);
         }
 
-        bool set_uniform(const char* name, const glm::mat4& val) const noexcept {
-            auto loc = get_uniform_location(name);
-            if (!loc) {
-                spdlog::info("trying to set unknown uniform \"{}\"", name);
+        void set_uniform(UniformLocation loc, const glm::vec3& val) const noexcept {
+            glUniform3f(loc.value, val[0], val[1], val[2]);
+        }
+
+        void set_uniform(UniformLocation loc, const glm::vec4& val) const noexcept {
+            glUniform4f(loc.value, val[0], val[1], val[2], val[3]);
+        }
+
+        void set_uniform(UniformLocation loc, const glm::mat4& val) const noexcept {
+            glUniformMatrix4fv(loc.value, 1, GL_FALSE, &val[0][0]);
+        }
+
+        // Makes the uniform block `name` read from the uniform buffer bound
+        // to `binding`. False if the program has no such block.
+        bool set_block_binding(VariableName name, GLuint binding) const noexcept {
+            auto var = find_variable(uniform_blocks_, name);
+            if (var == nullptr) {
                 return false;
             }
-            glUniformMatrix4fv(*loc, 1, GL_FALSE, &val[0][0]);
+            glUniformBlockBinding(prog_.get(), static_cast<GLuint>(var->location), binding);
             return true;
         }
 
-        void use() const noexcept {
-            glUseProgram(prog_.get());
+        // sorted by hash
+        std::span<const ActiveVariable> uniforms() const noexcept {
+            return uniforms_;
+        }
+
+        // the location is the block index, the size the block's data size
+        std::span<const ActiveVariable> uniform_blocks() const noexcept {
+            return uniform_blocks_;
+        }
+
+        std::span<const ActiveVariable> attributes() const noexcept {
+            return attributes_;
+        }
+
+        // false if the program was in use already
+        bool use() const noexcept {
+            return gl_state().use_program(prog_.get());
         }
     private:
         void link_program(const std::vector<Shader>& shaders);
+        // fills `uniforms_`, `uniform_blocks_` and `attributes_`
+        void reflect();
+
+        static const ActiveVariable* find_variable(std::span<const ActiveVariable> vars, VariableName name) noexcept {
+            auto it = std::lower_bound(vars.begin(), vars.end(), name.hash, [](const ActiveVariable& var, uint32_t hash) {
+                return var.hash < hash;
+            });
+            if ((it == vars.end()) || (it->hash != name.hash)) {
+                return nullptr;
+            }
+            assert(it->name == name.name);
+            return &*it;
+        }
 
         UniqueProgramHandle prog_;
+        std::vector<ActiveVariable> uniforms_;
+        std::vector<ActiveVariable> uniform_blocks_;
+        std::vector<ActiveVariable> attributes_;
 };
 
+// Owns the programs by name. Programs get a handle when they are added, so
+// per-frame code can reach them without hashing the name.
 class ShaderManager {
     public:
-        Program& add_shader(const std::string& name, const std::vector<Shader>& shaders) {
-            auto it = shaders_.try_emplace(name, shaders).first;
-            return (*it).second;
+        // stays valid while programs are added
+        using handle_type = size_t;
+
+        // the existing program if `name` is taken
+        handle_type add_shader(const std::string& name, const std::vector<Shader>& shaders) {
+            if (auto hndl = find(name)) {
+                return *hndl;
+            }
+            programs_.emplace_back(shaders);
+            apply_block_bindings(programs_.back());
+            return names_.emplace(name, programs_.size()-1).first->second;
+        }
+        handle_type add_shader(const std::string& name, Program&& prog) {
+            if (auto hndl = find(name)) {
+                return *hndl;
+            }
+            programs_.push_back(std::move(prog));
+            apply_block_bindings(programs_.back());
+            return names_.emplace(name, programs_.size()-1).first->second;
         }
-        Program& add_shader(const std::string& name, Program&& prog) {
-            auto it = shaders_.insert(std::make_pair(name, std::move(prog))).first;
-            return (*it).second;
+
+        // Programs with a uniform block `name` read it from `binding`,
+        // including those added later.
+        void set_block_binding(const std::string& name, GLuint binding) {
+            block_bindings_.emplace_back(name, binding);
+            for (const auto& prog : programs_) {
+                prog.set_block_binding(VariableName::runtime(name.c_str()), binding);
+            }
+        }
+
+        bool has_shader(const std::string& name) const {
+            return names_.contains(name);
+        }
+
+        std::optional<handle_type> find(const std::string& name) const {
+            auto it = names_.find(name);
+            if (it == names_.end()) {
+                return std::nullopt;
+            }
+            return it->second;
         }
 
         Program& get_shader(const std::string& name) {
-            return shaders_.at(name);
+            return programs_[names_.at(name)];
         }
 
         const Program& get_shader(const std::string& name) const {
-            return shaders_.at(name);
+            return programs_[names_.at(name)];
+        }
+
+        Program& get(handle_type hndl) noexcept {
+            return programs_[hndl];
+        }
+
+        const Program& get(handle_type hndl) const noexcept {
+            return programs_[hndl];
         }
     private:
-        std::unordered_map<std::string, Program> shaders_;
+        void apply_block_bindings(const Program& prog) const {
+            for (const auto& [name, binding] : block_bindings_) {
+                prog.set_block_binding(VariableName::runtime(name.c_str()), binding);
+            }
+        }
+
+        // a deque keeps references to the programs valid
+        std::deque<Program> programs_;
+        std::unordered_map<std::string, handle_type> names_;
+        std::vector<std::pair<std::string, GLuint>> block_bindings_;
 };
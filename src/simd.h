@@ -0,0 +1,134 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+// The instruction set is selected at compile time (see GLSB_ENABLE_AVX2).
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define GLSB_USE_SSE
+#include <immintrin.h>
+#endif
+
+#if defined(GLSB_USE_SSE) && defined(__AVX__)
+#define GLSB_USE_AVX
+#endif
+
+namespace simd {
+
+// Four floats in one SSE register, plain arrays where SSE is not available.
+// Only covers what the geometry kernels need.
+#ifdef GLSB_USE_SSE
+
+struct Mask4 {
+    __m128 v;
+
+    friend Mask4 operator&(Mask4 a, Mask4 b) noexcept { return {_mm_and_ps(a.v, b.v)}; }
+    friend Mask4 operator|(Mask4 a, Mask4 b) noexcept { return {_mm_or_ps(a.v, b.v)}; }
+
+    // lane i in bit i
+    int bits() const noexcept { return _mm_movemask_ps(v); }
+    bool any() const noexcept { return bits() != 0; }
+};
+
+struct Float4 {
+    __m128 v;
+
+    Float4() noexcept : v{_mm_setzero_ps()} {}
+    Float4(__m128 val) noexcept : v{val} {}
+    Float4(float s) noexcept : v{_mm_set1_ps(s)} {}
+
+    static Float4 load(const float* p) noexcept { return {_mm_loadu_ps(p)}; }
+    void store(float* p) const noexcept { _mm_storeu_ps(p, v); }
+
+    friend Float4 operator+(Float4 a, Float4 b) noexcept { return {_mm_add_ps(a.v, b.v)}; }
+    friend Float4 operator-(Float4 a, Float4 b) noexcept { return {_mm_sub_ps(a.v, b.v)}; }
+    friend Float4 operator*(Float4 a, Float4 b) noexcept { return {_mm_mul_ps(a.v, b.v)}; }
+    friend Float4 operator/(Float4 a, Float4 b) noexcept { return {_mm_div_ps(a.v, b.v)}; }
+    friend Mask4 operator<(Float4 a, Float4 b) noexcept { return {_mm_cmplt_ps(a.v, b.v)}; }
+    friend Mask4 operator<=(Float4 a, Float4 b) noexcept { return {_mm_cmple_ps(a.v, b.v)}; }
+    friend Mask4 operator>(Float4 a, Float4 b) noexcept { return {_mm_cmpgt_ps(a.v, b.v)}; }
+    friend Mask4 operator>=(Float4 a, Float4 b) noexcept { return {_mm_cmpge_ps(a.v, b.v)}; }
+};
+
+inline Float4 min(Float4 a, Float4 b) noexcept { return {_mm_min_ps(a.v, b.v)}; }
+inline Float4 max(Float4 a, Float4 b) noexcept { return {_mm_max_ps(a.v, b.v)}; }
+inline Float4 abs(Float4 a) noexcept { return {_mm_andnot_ps(_mm_set1_ps(-0.f), a.v)}; }
+// lanes of `a` where `mask` is set, else of `b`
+inline Float4 select(Mask4 mask, Float4 a, Float4 b) noexcept {
+    return {_mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v))};
+}
+
+#else
+
+struct Mask4 {
+    bool v[4];
+
+    friend Mask4 operator&(Mask4 a, Mask4 b) noexcept {
+        return {{a.v[0] && b.v[0], a.v[1] && b.v[1], a.v[2] && b.v[2], a.v[3] && b.v[3]}};
+    }
+    friend Mask4 operator|(Mask4 a, Mask4 b) noexcept {
+        return {{a.v[0] || b.v[0], a.v[1] || b.v[1], a.v[2] || b.v[2], a.v[3] || b.v[3]}};
+    }
+
+    int bits() const noexcept {
+        return (v[0] ? 1 : 0) | (v[1] ? 2 : 0) | (v[2] ? 4 : 0) | (v[3] ? 8 : 0);
+    }
+    bool any() const noexcept { return bits() != 0; }
+};
+
+struct Float4 {
+    float v[4];
+
+    Float4() noexcept : v{} {}
+    Float4(float s) noexcept : v{s, s, s, s} {}
+
+    static Float4 load(const float* p) noexcept {
+        auto ret = Float4{};
+        std::copy(p, p+4, ret.v);
+        return ret;
+    }
+    void store(float* p) const noexcept { std::copy(v, v+4, p); }
+
+    template <typename FnT>
+    static Float4 apply(Float4 a, Float4 b, FnT&& fn) noexcept {
+        auto ret = Float4{};
+        for (int i=0; i<4; ++i) {
+            ret.v[i] = fn(a.v[i], b.v[i]);
+        }
+        return ret;
+    }
+    template <typename FnT>
+    static Mask4 compare(Float4 a, Float4 b, FnT&& fn) noexcept {
+        auto ret = Mask4{};
+        for (int i=0; i<4; ++i) {
+            ret.v[i] = fn(a.v[i], b.v[i]);
+        }
+        return ret;
+    }
+
+    friend Float4 operator+(Float4 a, Float4 b) noexcept { return apply(a, b, [](float x, float y) { return x + y; }); }
+    friend Float4 operator-(Float4 a, Float4 b) noexcept { return apply(a, b, [](float x, float y) { return x - y; }); }
+    friend Float4 operator*(Float4 a, Float4 b) noexcept { return apply(a, b, [](float x, float y) { return x * y; }); }
+    friend Float4 operator/(Float4 a, Float4 b) noexcept { return apply(a, b, [](float x, float y) { return x / y; }); }
+    friend Mask4 operator<(Float4 a, Float4 b) noexcept { return compare(a, b, [](float x, float y) { return x < y; }); }
+    friend Mask4 operator<=(Float4 a, Float4 b) noexcept { return compare(a, b, [](float x, float y) { return x <= y; }); }
+    friend Mask4 operator>(Float4 a, Float4 b) noexcept { return compare(a, b, [](float x, float y) { return x > y; }); }
+    friend Mask4 operator>=(Float4 a, Float4 b) noexcept { return compare(a, b, [](float x, float y) { return x >= y; }); }
+};
+
+// same NaN handling as minps/maxps: the second operand is returned
+inline Float4 min(Float4 a, Float4 b) noexcept { return Float4::apply(a, b, [](float x, float y) { return (x < y) ? x : y; }); }
+inline Float4 max(Float4 a, Float4 b) noexcept { return Float4::apply(a, b, [](float x, float y) { return (x > y) ? x : y; }); }
+inline Float4 abs(Float4 a) noexcept { return Float4::apply(a, a, [](float x, float) { return std::fabs(x); }); }
+inline Float4 select(Mask4 mask, Float4 a, Float4 b) noexcept {
+    auto ret = Float4{};
+    for (int i=0; i<4; ++i) {
+        ret.v[i] = mask.v[i] ? a.v[i] : b.v[i];
+    }
+    return ret;
+}
+
+#endif
+
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+
+#include "bounds.h"
+#include "mesh.h"
+
+// layout of GL_DRAW_INDIRECT_BUFFER entries for glMultiDrawElementsIndirect
+struct DrawElementsIndirectCommand {
+    uint32_t count;
+    uint32_t instance_count;
+    uint32_t first_index;
+    int32_t base_vertex;
+    uint32_t base_instance;
+};
+static_assert(sizeof(DrawElementsIndirectCommand) == 20);
+
+// Per-draw data of a static batch, std430 layout as read by
+// res/static.vert.glsl. The normal matrix is stored as mat4 to avoid the
+// padding rules of mat3.
+struct StaticDrawData {
+    glm::mat4 model;
+    glm::mat4 normal_mat;
+};
+static_assert(sizeof(StaticDrawData) == 32*sizeof(float));
+
+// Packs many static meshes into one vertex and one index buffer, so that
+// all of them are drawn with a single glMultiDrawElementsIndirect, see
+// `Renderer::upload_static_batch`. Each draw places a mesh with a model
+// matrix, a mesh can be drawn several times while its data is stored once.
+// The base instance of every command is its draw index, the shader uses it
+// to look up the draw's `StaticDrawData`.
+template <typename VertexT>
+class StaticBatch {
+    public:
+        using vertex_type = VertexT;
+
+        // returns the id to pass to `add_draw`
+        size_t add_mesh(MeshView<vertex_type> mesh) {
+            assert(vertex_data_.size() + mesh.vertex_data.size() <= size_t{INT32_MAX});
+            meshes_.push_back(MeshRange{
+                static_cast<uint32_t>(index_data_.size()),
+                static_cast<uint32_t>(mesh.index_data.size()),
+                static_cast<int32_t>(vertex_data_.size()),
+                compute_bounding_box(mesh.vertex_data),
+                compute_bounding_sphere(mesh.vertex_data)
+            });
+            vertex_data_.insert(vertex_data_.end(), mesh.vertex_data.begin(), mesh.vertex_data.end());
+            index_data_.insert(index_data_.end(), mesh.index_data.begin(), mesh.index_data.end());
+            return meshes_.size()-1;
+        }
+
+        // returns the index of the draw
+        size_t add_draw(size_t mesh_id, const glm::mat4& model) {
+            const auto& mesh = meshes_[mesh_id];
+            auto draw_idx = static_cast<uint32_t>(commands_.size());
+            commands_.push_back(DrawElementsIndirectCommand{mesh.index_count, 1, mesh.first_index, mesh.base_vertex, draw_idx});
+            draw_data_.push_back(StaticDrawData{model, glm::mat4(glm::inverseTranspose(glm::mat3(model)))});
+
+            auto box = BoundingBox::empty();
+            for (int corner=0; corner<8; ++corner) {
+                auto p = glm::vec3(
+                    (corner & 1) ? mesh.box.hi.x : mesh.box.lo.x,
+                    (corner & 2) ? mesh.box.hi.y : mesh.box.lo.y,
+                    (corner & 4) ? mesh.box.hi.z : mesh.box.lo.z
+                );
+                box.grow(glm::vec3(model*glm::vec4(p, 1.f)));
+            }
+            boxes_.push_back(box);
+            auto max_scale = std::max(
+                std::max(glm::length(glm::vec3(model[0])), glm::length(glm::vec3(model[1]))),
+                glm::length(glm::vec3(model[2]))
+            );
+            spheres_.push_back(BoundingSphere{glm::vec3(model*glm::vec4(mesh.sphere.center, 1.f)), mesh.sphere.radius*max_scale});
+            return commands_.size()-1;
+        }
+
+        std::span<const vertex_type> vertex_data() const noexcept {
+            return vertex_data_;
+        }
+
+        std::span<const uint32_t> index_data() const noexcept {
+            return index_data_;
+        }
+
+        std::span<const DrawElementsIndirectCommand> commands() const noexcept {
+            return commands_;
+        }
+
+        std::span<const StaticDrawData> draw_data() const noexcept {
+            return draw_data_;
+        }
+
+        // world space bounds per draw
+        std::span<const BoundingBox> draw_boxes() const noexcept {
+            return boxes_;
+        }
+
+        std::span<const BoundingSphere> draw_spheres() const noexcept {
+            return spheres_;
+        }
+
+    private:
+        struct MeshRange {
+            uint32_t first_index;
+            uint32_t index_count;
+            int32_t base_vertex;
+            BoundingBox box;
+            BoundingSphere sphere;
+        };
+
+        std::vector<vertex_type> vertex_data_;
+        std::vector<uint32_t> index_data_;
+        std::vector<MeshRange> meshes_;
+        std::vector<DrawElementsIndirectCommand> commands_;
+        std::vector<StaticDrawData> draw_data_;
+        std::vector<BoundingBox> boxes_;
+        std::vector<BoundingSphere> spheres_;
+};
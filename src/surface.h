@@ -0,0 +1,68 @@
+#pragma once
+
+#define GLFW_INCLUDE_NONE
+#include <GLFW/glfw3.h>
+
+template <typename NumT>
+struct Extent2D {
+    NumT width;
+    NumT height;
+};
+
+// What `Application` and `Renderer` draw to: the default framebuffer of a
+// current OpenGL context, where the frames are presented and the events come
+// from. Either a window, or a context without one for headless runs, see
+// `HeadlessSurface`.
+class Surface {
+    public:
+        virtual ~Surface() = default;
+
+        // of the default framebuffer, in pixels
+        virtual Extent2D<int> framebuffer_size() const noexcept = 0;
+
+        virtual void poll_events() = 0;
+        // presents the frame
+        virtual void swap_buffers() = 0;
+
+        virtual bool should_close() const noexcept = 0;
+        virtual void request_close() noexcept = 0;
+
+        // the window for ImGui and input, null without one
+        virtual GLFWwindow* window() const noexcept {
+            return nullptr;
+        }
+};
+
+// GLFW window whose context is current
+class WindowSurface final : public Surface {
+    public:
+        explicit WindowSurface(GLFWwindow* win) : win_{win} {}
+
+        Extent2D<int> framebuffer_size() const noexcept override {
+            auto ret = Extent2D<int>{};
+            glfwGetFramebufferSize(win_, &(ret.width), &(ret.height));
+            return ret;
+        }
+
+        void poll_events() override {
+            glfwPollEvents();
+        }
+
+        void swap_buffers() override {
+            glfwSwapBuffers(win_);
+        }
+
+        bool should_close() const noexcept override {
+            return glfwWindowShouldClose(win_) == GLFW_TRUE;
+        }
+
+        void request_close() noexcept override {
+            glfwSetWindowShouldClose(win_, GLFW_TRUE);
+        }
+
+        GLFWwindow* window() const noexcept override {
+            return win_;
+        }
+    private:
+        GLFWwindow* win_;
+};
@@ -9,6 +9,8 @@
 
 #include <GL/glew.h>
 
+#include "gl_state.h"
+
 class Bitmap {
     public:
         Bitmap(const std::filesystem::path& fpath) : ptr_(nullptr, stbi_image_free) {
@@ -63,10 +65,6 @@ enum class TextureWrapping : GLint {
     ClampToBorder = GL_CLAMP_TO_BORDER,
 };
 
-enum class TextureTarget : GLenum {
-    Texture2D = GL_TEXTURE_2D,
-};
-
 enum class TextureParameter : GLenum {
     MinFilter = GL_TEXTURE_MIN_FILTER,
     MagFilter = GL_TEXTURE_MAG_FILTER,
@@ -74,15 +72,8 @@ enum class TextureParameter : GLenum {
     WrapT = GL_TEXTURE_WRAP_T,
 };
 
-template <>
-struct BindingPointTraits<TextureTarget> {
-    static constexpr auto binding_fn = glBindTexture;
-};
-
 class TextureBindingContext;
 
-using TextureBindingPoint = BindingPoint<TextureTarget, GLuint>;
-
 class TextureBindingContext : public BindingContext<TextureBindingPoint> {
     public:
         TextureBindingContext(TextureBindingPoint& binding, TextureBindingPoint::index_type idx) :
@@ -111,46 +102,49 @@ class TextureBindingContext : public BindingContext<TextureBindingPoint> {
 class Texture {
     struct TextureDeleter {
         void operator()(GLuint hndl) const noexcept {
+            gl_state().forget_texture(hndl);
             glDeleteTextures(1, &hndl);
         }
     };
     using UniqueTextureHandle = UniqueHandle<GLuint, TextureDeleter>;
 
     public:
-        Texture(TextureBindingPoint& binding) : binding_{binding}, hndl_{} {
+        // `unit` is the texture unit `bind` binds to
+        explicit Texture(GLuint unit = 0) : unit_{unit}, hndl_{} {
             auto tex = UniqueTextureHandle::value_type{};
             glGenTextures(1, &tex);
             hndl_.reset(tex);
         }
 
         void allocate(int width, int height, const void* data) {
-            auto tex = TextureBindingContext(binding_, hndl_.get());
+            auto tex = TextureBindingContext(gl_state().texture_unit(unit_), hndl_.get());
             tex.allocate(TextureFormat::RGBA, TextureType::UnsignedByte, width, height, data);
             if (use_mipmap_) {
                 tex.gen_mipmap();
             }
         }
 
-        void bind() {
-            binding_.bind(hndl_.get());
+        // false if it was bound already
+        bool bind() {
+            return gl_state().bind_texture(unit_, hndl_.get());
         }
 
         void unbind() {
-            binding_.unbind();
+            gl_state().bind_texture(unit_, 0);
         }
 
         void set_filtering(TextureFilter filter, bool use_mipmap) {
             use_mipmap_ = use_mipmap;
 
             {
-                auto tex = TextureBindingContext(binding_, hndl_.get());
+                auto tex = TextureBindingContext(gl_state().texture_unit(unit_), hndl_.get());
                 tex.set_parameter(TextureParameter::MinFilter, get_filter_param(filter, use_mipmap));
                 tex.set_parameter(TextureParameter::MagFilter, get_filter_param(filter, false));
             }
         }
 
         void set_wrapping(TextureWrapping wrapping) {
-            auto tex = TextureBindingContext(binding_, hndl_.get());
+            auto tex = TextureBindingContext(gl_state().texture_unit(unit_), hndl_.get());
             tex.set_parameter(TextureParameter::WrapS, static_cast<std::underlying_type_t<TextureWrapping>>(wrapping));
             tex.set_parameter(TextureParameter::WrapT, static_cast<std::underlying_type_t<TextureWrapping>>(wrapping));
         }
@@ -179,7 +173,7 @@ class Texture {
             abort();
         }
 
-        TextureBindingPoint& binding_;
+        GLuint unit_;
         UniqueTextureHandle hndl_;
         bool use_mipmap_ = false;
 };
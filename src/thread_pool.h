@@ -0,0 +1,81 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "cpu_profiler.h"
+
+// Fixed-size pool of worker threads executing tasks in FIFO order.
+class ThreadPool {
+    public:
+        explicit ThreadPool(unsigned thread_count = std::thread::hardware_concurrency()) {
+            thread_count = std::max(thread_count, 1u);
+            workers_.reserve(thread_count);
+            for (unsigned i=0; i<thread_count; ++i) {
+                workers_.emplace_back([this]() { worker_loop(); });
+            }
+        }
+
+        ~ThreadPool() {
+            {
+                auto lock = std::scoped_lock(mtx_);
+                is_stopping_ = true;
+            }
+            cv_.notify_all();
+            for (auto& worker : workers_) {
+                worker.join();
+            }
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        template <typename FuncT>
+        std::future<std::invoke_result_t<FuncT>> submit(FuncT&& fn) {
+            using result_type = std::invoke_result_t<FuncT>;
+            auto task = std::make_shared<std::packaged_task<result_type()>>(std::forward<FuncT>(fn));
+            auto ret = task->get_future();
+            {
+                auto lock = std::scoped_lock(mtx_);
+                tasks_.emplace([task]() { (*task)(); });
+            }
+            cv_.notify_one();
+            return ret;
+        }
+
+        unsigned size() const noexcept {
+            return static_cast<unsigned>(workers_.size());
+        }
+    private:
+        void worker_loop() {
+            while (true) {
+                auto task = std::function<void()>{};
+                {
+                    auto lock = std::unique_lock(mtx_);
+                    cv_.wait(lock, [this]() { return is_stopping_ || !tasks_.empty(); });
+                    if (tasks_.empty()) {
+                        return;
+                    }
+                    task = std::move(tasks_.front());
+                    tasks_.pop();
+                }
+                auto zone = cpu_profiler().zone("task");
+                task();
+            }
+        }
+
+        std::vector<std::thread> workers_;
+        std::queue<std::function<void()>> tasks_;
+        std::mutex mtx_;
+        std::condition_variable cv_;
+        bool is_stopping_ = false;
+};
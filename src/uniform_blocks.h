@@ -0,0 +1,136 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include <glm/glm.hpp>
+#include <GL/glew.h>
+
+#include "light_clusters.h"
+#include "scene.h"
+
+// C++ mirrors of the std140 uniform blocks in res/*.glsl. Each block has a
+// fixed binding index, `Renderer` registers them with its `ShaderManager` so
+// every program reads the same buffer range, see `Renderer::set_uniform_block`.
+// A vec3 takes 16 bytes unless a float fills its last 4.
+
+// per frame, in every program
+struct FrameUniforms {
+    static constexpr const char* block_name = "Frame";
+    static constexpr GLuint binding = 0;
+
+    glm::mat4 view;
+    glm::mat4 proj;
+    glm::vec3 camera_pos;
+    float pad0;
+
+    static FrameUniforms from_camera(const Camera& cam) noexcept {
+        return FrameUniforms{cam.get_view_matrix(), cam.get_proj_matrix(), cam.pos, 0.f};
+    }
+};
+static_assert(offsetof(FrameUniforms, view) == 0);
+static_assert(offsetof(FrameUniforms, proj) == 64);
+static_assert(offsetof(FrameUniforms, camera_pos) == 128);
+static_assert(sizeof(FrameUniforms) == 144);
+
+// per frame, the lights of `Scene`
+struct LightUniforms {
+    static constexpr const char* block_name = "Lights";
+    static constexpr GLuint binding = 1;
+
+    // struct AmbientLight
+    glm::vec3 ambient_color;
+    float ambient_intensity;
+    // struct Light, whose members start on a 16 byte boundary
+    glm::vec3 diffuse_pos;
+    float pad0;
+    glm::vec3 diffuse_color;
+    float diffuse_intensity;
+
+    static LightUniforms from_scene(const Scene& scene) noexcept {
+        return LightUniforms{
+            scene.ambient.color,
+            scene.ambient.intensity,
+            scene.diffuse.pos,
+            0.f,
+            scene.diffuse.color,
+            scene.diffuse.intensity
+        };
+    }
+};
+static_assert(offsetof(LightUniforms, ambient_color) == 0);
+static_assert(offsetof(LightUniforms, ambient_intensity) == 12);
+static_assert(offsetof(LightUniforms, diffuse_pos) == 16);
+static_assert(offsetof(LightUniforms, diffuse_color) == 32);
+static_assert(offsetof(LightUniforms, diffuse_intensity) == 44);
+static_assert(sizeof(LightUniforms) == 48);
+
+// per material, may change between draws
+struct MaterialUniforms {
+    static constexpr const char* block_name = "Material";
+    static constexpr GLuint binding = 2;
+
+    // struct Specularity
+    float roughness;
+    float spec_intensity;
+    float pad0[2];
+};
+static_assert(offsetof(MaterialUniforms, roughness) == 0);
+static_assert(offsetof(MaterialUniforms, spec_intensity) == 4);
+static_assert(sizeof(MaterialUniforms) == 16);
+
+// per frame, for the passes of `DeferredShading` that read the G-buffer
+struct DeferredUniforms {
+    static constexpr const char* block_name = "Deferred";
+    static constexpr GLuint binding = 3;
+
+    // from clip space back to world space
+    glm::mat4 inv_view_proj;
+    glm::vec2 viewport_size;
+    float pad0[2];
+
+    static DeferredUniforms from_camera(const Camera& cam, glm::vec2 viewport_size) noexcept {
+        return DeferredUniforms{
+            glm::inverse(cam.get_proj_matrix()*cam.get_view_matrix()),
+            viewport_size,
+            {0.f, 0.f}
+        };
+    }
+};
+static_assert(offsetof(DeferredUniforms, inv_view_proj) == 0);
+static_assert(offsetof(DeferredUniforms, viewport_size) == 64);
+static_assert(sizeof(DeferredUniforms) == 80);
+
+// per frame, the `ClusterGrid` of `ClusteredLighting`
+struct ClusterUniforms {
+    static constexpr const char* block_name = "Clusters";
+    static constexpr GLuint binding = 4;
+
+    // number of point lights in w
+    glm::uvec4 grid_size;
+    float z_near;
+    float z_far;
+    float tan_half_fov;
+    float aspect;
+    glm::vec2 viewport_size;
+    uint32_t max_cluster_lights;
+    float pad0;
+
+    static ClusterUniforms from_grid(const ClusterGrid& grid, glm::vec2 viewport_size, uint32_t light_count, uint32_t max_cluster_lights) noexcept {
+        return ClusterUniforms{
+            glm::uvec4(grid.size, light_count),
+            grid.z_near,
+            grid.z_far,
+            grid.tan_half_fov,
+            grid.aspect,
+            viewport_size,
+            max_cluster_lights,
+            0.f
+        };
+    }
+};
+static_assert(offsetof(ClusterUniforms, grid_size) == 0);
+static_assert(offsetof(ClusterUniforms, z_near) == 16);
+static_assert(offsetof(ClusterUniforms, viewport_size) == 32);
+static_assert(offsetof(ClusterUniforms, max_cluster_lights) == 40);
+static_assert(sizeof(ClusterUniforms) == 48);
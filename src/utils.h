@@ -1,8 +1,11 @@
 #pragma once
 
+#include <cstddef>
 #include <filesystem>
 #include <fstream>
 #include <stdexcept>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 class GLSBError : public std::runtime_error {
@@ -70,6 +73,21 @@ struct BindingPointTraits {};
 template <typename BindingPointT>
 class BindingContext;
 
+// calls to the binding function, and calls skipped because the index was bound already
+struct BindingStats {
+    size_t issued = 0;
+    size_t avoided = 0;
+
+    BindingStats& operator+=(const BindingStats& other) noexcept {
+        issued += other.issued;
+        avoided += other.avoided;
+        return *this;
+    }
+};
+
+// Remembers the index bound to a target and only calls the binding function
+// of `BindingTraits` when it changes. Bindings made behind its back have to
+// be reported with `invalidate` or `set_bound`.
 template <typename TgtT, typename IdxT, typename BindingTraits=BindingPointTraits<TgtT>>
 class BindingPoint {
     public:
@@ -80,25 +98,62 @@ class BindingPoint {
         constexpr BindingPoint(target_type tgt) : tgt_{tgt} {}
 
         bool bind(index_type idx) noexcept {
-            if (idx == bound_idx_) {
+            if (is_known_ && (idx == bound_idx_)) {
                 // already bound: do nothing
+                ++stats_.avoided;
                 return false;
             }
             // TODO: handle multiple access => lock or at least log
-            BindingPointTraits<TgtT>::binding_fn(static_cast<std::underlying_type_t<TgtT>>(tgt_), idx);
+            BindingTraits::binding_fn(static_cast<std::underlying_type_t<TgtT>>(tgt_), idx);
             bound_idx_ = idx;
+            is_known_ = true;
+            ++stats_.issued;
             return true;
         }
 
         void unbind() noexcept {
-            if (bound_idx_ != index_type{}) {
-                BindingPointTraits<TgtT>::binding_fn(static_cast<std::underlying_type_t<TgtT>>(tgt_), index_type{});
+            bind(index_type{});
+        }
+
+        // the bound index, only meaningful if `is_known`
+        index_type bound() const noexcept {
+            return bound_idx_;
+        }
+
+        bool is_known() const noexcept {
+            return is_known_;
+        }
+
+        // the next `bind` calls the binding function whatever the index
+        void invalidate() noexcept {
+            is_known_ = false;
+        }
+
+        // for indices bound by other means, e.g. as a side effect
+        void set_bound(index_type idx) noexcept {
+            bound_idx_ = idx;
+            is_known_ = true;
+        }
+
+        // GL reverts the bindings of deleted objects to 0
+        void forget(index_type idx) noexcept {
+            if (bound_idx_ == idx) {
                 bound_idx_ = index_type{};
             }
         }
+
+        const BindingStats& stats() const noexcept {
+            return stats_;
+        }
+
+        void reset_stats() noexcept {
+            stats_ = BindingStats{};
+        }
     protected:
         TgtT tgt_;
-        index_type bound_idx_;
+        index_type bound_idx_{};
+        bool is_known_ = true;
+        BindingStats stats_;
 
         template <typename T>
         friend class BindingContext;
@@ -0,0 +1,214 @@
+#include "mesh.h"
+#include "simd.h"
+
+static_assert(sizeof(Vertex) == 8*sizeof(float), "kernels expect 8 packed floats per vertex");
+static_assert(offsetof(Vertex, norm) == 3*sizeof(float));
+
+namespace {
+
+// per-vertex math shared by all kernels, row-major copies of the matrices
+struct TransformParams {
+    // tmat rows: pos' = m[r][0]*x + m[r][1]*y + m[r][2]*z + m[r][3]
+    float m[3][4];
+    // inverse transposed upper 3x3 of tmat, rows
+    float n[3][3];
+
+    TransformParams(const glm::mat4& tmat) noexcept {
+        auto norm_mat = glm::inverseTranspose(glm::mat3(tmat));
+        for (int r=0; r<3; ++r) {
+            for (int c=0; c<4; ++c) {
+                m[r][c] = tmat[c][r];
+            }
+            for (int c=0; c<3; ++c) {
+                n[r][c] = norm_mat[c][r];
+            }
+        }
+    }
+};
+
+void
+transform_scalar(Vertex* vert, size_t count, const TransformParams& p) noexcept {
+    for (size_t i=0; i<count; ++i) {
+        auto pos = vert[i].pos;
+        auto norm = vert[i].norm;
+        for (int r=0; r<3; ++r) {
+            vert[i].pos[r] = p.m[r][0]*pos.x + p.m[r][1]*pos.y + p.m[r][2]*pos.z + p.m[r][3];
+            vert[i].norm[r] = p.n[r][0]*norm.x + p.n[r][1]*norm.y + p.n[r][2]*norm.z;
+        }
+    }
+}
+
+#ifdef GLSB_USE_SSE
+
+inline __m128
+madd(__m128 a, __m128 b, __m128 c) noexcept {
+#ifdef __FMA__
+    return _mm_fmadd_ps(a, b, c);
+#else
+    return _mm_add_ps(_mm_mul_ps(a, b), c);
+#endif
+}
+
+inline void
+transpose4(__m128& r0, __m128& r1, __m128& r2, __m128& r3) noexcept {
+    auto t0 = _mm_unpacklo_ps(r0, r1);
+    auto t1 = _mm_unpacklo_ps(r2, r3);
+    auto t2 = _mm_unpackhi_ps(r0, r1);
+    auto t3 = _mm_unpackhi_ps(r2, r3);
+    r0 = _mm_movelh_ps(t0, t1);
+    r1 = _mm_movehl_ps(t1, t0);
+    r2 = _mm_movelh_ps(t2, t3);
+    r3 = _mm_movehl_ps(t3, t2);
+}
+
+// 4 vertices per iteration: both 4-float halves of the vertices are
+// transposed into x/y/z/nx and ny/nz/u/v registers
+size_t
+transform_sse(Vertex* vert, size_t count, const TransformParams& p) noexcept {
+    __m128 m[3][4];
+    __m128 n[3][3];
+    for (int r=0; r<3; ++r) {
+        for (int c=0; c<4; ++c) {
+            m[r][c] = _mm_set1_ps(p.m[r][c]);
+        }
+        for (int c=0; c<3; ++c) {
+            n[r][c] = _mm_set1_ps(p.n[r][c]);
+        }
+    }
+
+    auto done = size_t{0};
+    for (; done+4<=count; done+=4) {
+        auto base = reinterpret_cast<float*>(vert + done);
+        auto x = _mm_loadu_ps(base);
+        auto y = _mm_loadu_ps(base + 8);
+        auto z = _mm_loadu_ps(base + 16);
+        auto nx = _mm_loadu_ps(base + 24);
+        auto ny = _mm_loadu_ps(base + 4);
+        auto nz = _mm_loadu_ps(base + 12);
+        auto u = _mm_loadu_ps(base + 20);
+        auto v = _mm_loadu_ps(base + 28);
+        transpose4(x, y, z, nx);
+        transpose4(ny, nz, u, v);
+
+        __m128 pos[3];
+        __m128 norm[3];
+        for (int r=0; r<3; ++r) {
+            pos[r] = madd(m[r][0], x, madd(m[r][1], y, madd(m[r][2], z, m[r][3])));
+            norm[r] = madd(n[r][0], nx, madd(n[r][1], ny, _mm_mul_ps(n[r][2], nz)));
+        }
+
+        transpose4(pos[0], pos[1], pos[2], norm[0]);
+        transpose4(norm[1], norm[2], u, v);
+        _mm_storeu_ps(base, pos[0]);
+        _mm_storeu_ps(base + 4, norm[1]);
+        _mm_storeu_ps(base + 8, pos[1]);
+        _mm_storeu_ps(base + 12, norm[2]);
+        _mm_storeu_ps(base + 16, pos[2]);
+        _mm_storeu_ps(base + 20, u);
+        _mm_storeu_ps(base + 24, norm[0]);
+        _mm_storeu_ps(base + 28, v);
+    }
+    return done;
+}
+
+#endif
+
+#ifdef GLSB_USE_AVX
+
+inline __m256
+madd(__m256 a, __m256 b, __m256 c) noexcept {
+#ifdef __FMA__
+    return _mm256_fmadd_ps(a, b, c);
+#else
+    return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+}
+
+inline void
+transpose8(__m256 (&r)[8]) noexcept {
+    auto t0 = _mm256_unpacklo_ps(r[0], r[1]);
+    auto t1 = _mm256_unpackhi_ps(r[0], r[1]);
+    auto t2 = _mm256_unpacklo_ps(r[2], r[3]);
+    auto t3 = _mm256_unpackhi_ps(r[2], r[3]);
+    auto t4 = _mm256_unpacklo_ps(r[4], r[5]);
+    auto t5 = _mm256_unpackhi_ps(r[4], r[5]);
+    auto t6 = _mm256_unpacklo_ps(r[6], r[7]);
+    auto t7 = _mm256_unpackhi_ps(r[6], r[7]);
+    auto s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+    auto s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+    auto s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+    auto s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+    auto s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+    auto s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+    auto s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+    auto s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+    r[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+    r[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+    r[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+    r[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+    r[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+    r[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+    r[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+    r[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+}
+
+// 8 vertices per iteration: an 8x8 transpose turns them into one register
+// per vertex component
+size_t
+transform_avx(Vertex* vert, size_t count, const TransformParams& p) noexcept {
+    __m256 m[3][4];
+    __m256 n[3][3];
+    for (int r=0; r<3; ++r) {
+        for (int c=0; c<4; ++c) {
+            m[r][c] = _mm256_set1_ps(p.m[r][c]);
+        }
+        for (int c=0; c<3; ++c) {
+            n[r][c] = _mm256_set1_ps(p.n[r][c]);
+        }
+    }
+
+    auto done = size_t{0};
+    for (; done+8<=count; done+=8) {
+        auto base = reinterpret_cast<float*>(vert + done);
+        __m256 comp[8];
+        for (int i=0; i<8; ++i) {
+            comp[i] = _mm256_loadu_ps(base + i*8);
+        }
+        transpose8(comp);
+
+        __m256 out[8];
+        for (int r=0; r<3; ++r) {
+            out[r] = madd(m[r][0], comp[0], madd(m[r][1], comp[1], madd(m[r][2], comp[2], m[r][3])));
+            out[3+r] = madd(n[r][0], comp[3], madd(n[r][1], comp[4], _mm256_mul_ps(n[r][2], comp[5])));
+        }
+        out[6] = comp[6];
+        out[7] = comp[7];
+
+        transpose8(out);
+        for (int i=0; i<8; ++i) {
+            _mm256_storeu_ps(base + i*8, out[i]);
+        }
+    }
+    return done;
+}
+
+#endif
+
+}
+
+void
+transform_vertices_scalar(std::span<Vertex> vertices, const glm::mat4& tmat) noexcept {
+    transform_scalar(vertices.data(), vertices.size(), TransformParams(tmat));
+}
+
+void
+transform_vertices(std::span<Vertex> vertices, const glm::mat4& tmat) noexcept {
+    auto params = TransformParams(tmat);
+    auto done = size_t{0};
+#if defined(GLSB_USE_AVX)
+    done = transform_avx(vertices.data(), vertices.size(), params);
+#elif defined(GLSB_USE_SSE)
+    done = transform_sse(vertices.data(), vertices.size(), params);
+#endif
+    transform_scalar(vertices.data() + done, vertices.size() - done, params);
+}
@@ -0,0 +1,134 @@
+#include <catch2/catch.hpp>
+
+#include <chrono>
+#include <future>
+#include <thread>
+#include <vector>
+
+#include <asset_loader.h>
+#include <utils.h>
+
+namespace {
+
+// drives the upload queue like the render loop does
+template <typename T>
+void process_until_ready(AssetLoader& loader, const std::future<T>& fut) {
+    while (fut.wait_for(std::chrono::milliseconds(1)) != std::future_status::ready) {
+        loader.process_uploads();
+    }
+}
+
+}
+
+TEST_CASE("AssetLoader runs uploads on the processing thread", "[asset_loader]") {
+    auto loader = AssetLoader(2);
+    auto main_thread = std::this_thread::get_id();
+
+    auto load_thread = std::promise<std::thread::id>{};
+    auto fut = loader.load(
+        [&load_thread]() {
+            load_thread.set_value(std::this_thread::get_id());
+            return 21;
+        },
+        [](int&& value) {
+            return std::make_pair(value*2, std::this_thread::get_id());
+        }
+    );
+
+    // nothing is uploaded without the render thread
+    REQUIRE(load_thread.get_future().get() != main_thread);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    REQUIRE(fut.wait_for(std::chrono::seconds(0)) == std::future_status::timeout);
+
+    process_until_ready(loader, fut);
+    auto [value, upload_thread] = fut.get();
+    REQUIRE(value == 42);
+    REQUIRE(upload_thread == main_thread);
+    REQUIRE(loader.pending_uploads() == 0);
+}
+
+TEST_CASE("AssetLoader forwards errors to the future", "[asset_loader]") {
+    auto loader = AssetLoader(1);
+
+    auto load_failed = loader.load(
+        []() -> int {
+            throw GLSBError("load");
+        },
+        [](int&&) {}
+    );
+    auto upload_failed = loader.load(
+        []() {
+            return 1;
+        },
+        [](int&&) {
+            throw GLSBError("upload");
+        }
+    );
+
+    process_until_ready(loader, load_failed);
+    process_until_ready(loader, upload_failed);
+    REQUIRE_THROWS_WITH(load_failed.get(), "load");
+    REQUIRE_THROWS_WITH(upload_failed.get(), "upload");
+}
+
+TEST_CASE("AssetLoader::process_uploads runs at least one upload", "[asset_loader]") {
+    auto loader = AssetLoader(1);
+    auto futs = std::vector<std::future<void>>{};
+    for (int i=0; i<4; ++i) {
+        futs.push_back(loader.load([]() { return 0; }, [](int&&) {}));
+    }
+    while (loader.pending_uploads() < 4) {
+        std::this_thread::yield();
+    }
+
+    REQUIRE(loader.process_uploads(std::chrono::microseconds(0)) == 1);
+    REQUIRE(loader.pending_uploads() == 3);
+    REQUIRE(loader.process_uploads() == 3);
+    for (auto& fut : futs) {
+        REQUIRE(fut.wait_for(std::chrono::seconds(0)) == std::future_status::ready);
+    }
+}
+
+TEST_CASE("AssetLoader::load_after holds uploads back until their dependencies are ready", "[asset_loader]") {
+    auto loader = AssetLoader(1);
+    auto dep = std::promise<void>{};
+    auto fut = loader.load_after({dep.get_future().share()}, []() { return 1; }, [](int&& value) { return value; });
+    // the worker is free for other loads meanwhile
+    auto other = loader.load([]() { return 2; }, [](int&& value) { return value; });
+    process_until_ready(loader, other);
+    REQUIRE(other.get() == 2);
+
+    REQUIRE(loader.pending_uploads() == 1);
+    loader.process_uploads();
+    REQUIRE(fut.wait_for(std::chrono::seconds(0)) == std::future_status::timeout);
+
+    dep.set_value();
+    process_until_ready(loader, fut);
+    REQUIRE(fut.get() == 1);
+    REQUIRE(loader.pending_uploads() == 0);
+}
+
+TEST_CASE("AssetLoader::pending_loads counts loads until their upload ran", "[asset_loader]") {
+    auto loader = AssetLoader(1);
+    REQUIRE(loader.pending_loads() == 0);
+
+    auto release = std::promise<void>{};
+    auto released = release.get_future().share();
+    auto plain = loader.load([released]() { released.wait(); return 1; });
+    auto uploaded = loader.load([]() { return 2; }, [](int&& value) { return value; });
+    auto failed = loader.load([]() -> int { throw GLSBError("load failed"); }, [](int&& value) { return value; });
+    REQUIRE(loader.pending_loads() == 3);
+
+    release.set_value();
+    REQUIRE(plain.get() == 1);
+    REQUIRE_THROWS_AS(failed.get(), GLSBError);
+    while (loader.pending_uploads() == 0) {
+        std::this_thread::yield();
+    }
+    // loaded, but not uploaded yet
+    REQUIRE(loader.pending_loads() == 1);
+
+    process_until_ready(loader, uploaded);
+    REQUIRE(uploaded.get() == 2);
+    REQUIRE(loader.pending_loads() == 0);
+}
@@ -0,0 +1,88 @@
+#include <catch2/catch.hpp>
+
+#include <vector>
+
+#include <utils.h>
+
+namespace {
+
+enum class FakeTarget : unsigned {
+    A = 1,
+};
+
+// records the calls instead of calling GL
+std::vector<unsigned> calls;
+
+}
+
+template <>
+struct BindingPointTraits<FakeTarget> {
+    static void binding_fn(unsigned, unsigned idx) noexcept {
+        calls.push_back(idx);
+    }
+};
+
+using FakeBindingPoint = BindingPoint<FakeTarget, unsigned>;
+
+TEST_CASE("BindingPoint skips redundant binds", "[binding_point]") {
+    calls.clear();
+    auto point = FakeBindingPoint(FakeTarget::A);
+    REQUIRE(point.bind(3));
+    REQUIRE_FALSE(point.bind(3));
+    REQUIRE(point.bind(4));
+    point.unbind();
+    point.unbind();
+    REQUIRE(calls == std::vector<unsigned>{3, 4, 0});
+    REQUIRE(point.stats().issued == 3);
+    REQUIRE(point.stats().avoided == 2);
+
+    point.reset_stats();
+    REQUIRE(point.stats().issued == 0);
+    REQUIRE(point.stats().avoided == 0);
+}
+
+TEST_CASE("BindingPoint rebinds after invalidate", "[binding_point]") {
+    calls.clear();
+    auto point = FakeBindingPoint(FakeTarget::A);
+    REQUIRE(point.bind(3));
+    point.invalidate();
+    REQUIRE_FALSE(point.is_known());
+    REQUIRE(point.bind(3));
+    REQUIRE(point.is_known());
+    REQUIRE(calls == std::vector<unsigned>{3, 3});
+
+    // bound as a side effect of something else
+    point.set_bound(5);
+    REQUIRE_FALSE(point.bind(5));
+    REQUIRE(calls.size() == 2);
+}
+
+TEST_CASE("BindingPoint forgets deleted objects", "[binding_point]") {
+    calls.clear();
+    auto point = FakeBindingPoint(FakeTarget::A);
+    REQUIRE(point.bind(3));
+    point.forget(4);
+    REQUIRE(point.bound() == 3);
+    point.forget(3);
+    REQUIRE(point.bound() == 0);
+    // a new object may get the name of the deleted one
+    REQUIRE(point.bind(3));
+    REQUIRE(calls == std::vector<unsigned>{3, 3});
+}
+
+TEST_CASE("BindingContext restores only what it bound", "[binding_point]") {
+    calls.clear();
+    auto point = FakeBindingPoint(FakeTarget::A);
+    {
+        auto ctx = BindingContext<FakeBindingPoint>(point, 3);
+    }
+    REQUIRE(calls == std::vector<unsigned>{3, 0});
+
+    calls.clear();
+    REQUIRE(point.bind(3));
+    {
+        auto ctx = BindingContext<FakeBindingPoint>(point, 3);
+    }
+    REQUIRE(point.bound() == 3);
+    REQUIRE(calls == std::vector<unsigned>{3});
+}
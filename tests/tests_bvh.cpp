@@ -0,0 +1,132 @@
+#include <catch2/catch.hpp>
+
+#include <random>
+#include <vector>
+
+#include <bvh.h>
+
+namespace {
+
+// Möller-Trumbore against every triangle, the reference for the BVH queries
+RayHit intersect_brute_force(const Mesh<Vertex>& mesh, const Ray& ray) {
+    auto ret = RayHit{};
+    ret.t = ray.t_max;
+    for (size_t tri=0; tri<mesh.index_data.size()/3; ++tri) {
+        auto v0 = mesh.vertex_data[mesh.index_data[3*tri]].pos;
+        auto e1 = mesh.vertex_data[mesh.index_data[3*tri+1]].pos - v0;
+        auto e2 = mesh.vertex_data[mesh.index_data[3*tri+2]].pos - v0;
+        auto pvec = glm::cross(ray.dir, e2);
+        auto det = glm::dot(e1, pvec);
+        if (std::fabs(det) <= std::numeric_limits<float>::min()) {
+            continue;
+        }
+        auto tvec = ray.origin - v0;
+        auto qvec = glm::cross(tvec, e1);
+        auto u = glm::dot(tvec, pvec)/det;
+        auto v = glm::dot(ray.dir, qvec)/det;
+        auto t = glm::dot(e2, qvec)/det;
+        if ((u >= 0.f) && (v >= 0.f) && (u+v <= 1.f) && (t > 0.f) && (t < ret.t)) {
+            ret = RayHit{t, static_cast<uint32_t>(tri), u, v};
+        }
+    }
+    if (ret.triangle == RayHit::no_triangle) {
+        return RayHit{};
+    }
+    return ret;
+}
+
+std::vector<Ray> random_rays(const BoundingBox& bounds, size_t count) {
+    auto rng = std::mt19937(42);
+    auto unit = std::uniform_real_distribution<float>(0.f, 1.f);
+    auto sym = std::uniform_real_distribution<float>(-1.f, 1.f);
+    auto ret = std::vector<Ray>{};
+    for (size_t i=0; i<count; ++i) {
+        auto origin = glm::mix(bounds.lo, bounds.hi, glm::vec3(unit(rng), unit(rng), unit(rng)));
+        auto dir = glm::vec3(sym(rng), sym(rng), sym(rng));
+        if (glm::length(dir) < 1e-3f) {
+            dir = glm::vec3(1.f, 0.f, 0.f);
+        }
+        ret.push_back(Ray{origin, dir});
+    }
+    return ret;
+}
+
+}
+
+TEST_CASE("Bvh finds the closest hit on a quad", "[bvh]") {
+    auto mesh = Mesh<Vertex>{};
+    mesh.vertex_data = {
+        {{-1.f, -1.f, 0.f}, {0.f, 0.f, 1.f}, {0.f, 0.f}},
+        {{1.f, -1.f, 0.f}, {0.f, 0.f, 1.f}, {1.f, 0.f}},
+        {{1.f, 1.f, 0.f}, {0.f, 0.f, 1.f}, {1.f, 1.f}},
+        {{-1.f, 1.f, 0.f}, {0.f, 0.f, 1.f}, {0.f, 1.f}},
+        {{-1.f, -1.f, -1.f}, {0.f, 0.f, 1.f}, {0.f, 0.f}},
+        {{1.f, -1.f, -1.f}, {0.f, 0.f, 1.f}, {1.f, 0.f}},
+        {{1.f, 1.f, -1.f}, {0.f, 0.f, 1.f}, {1.f, 1.f}},
+    };
+    mesh.index_data = {0, 1, 2, 2, 3, 0, 4, 5, 6};
+    auto bvh = Bvh(mesh.view());
+    REQUIRE(bvh.triangle_count() == 3);
+
+    auto hit = bvh.intersect(Ray{{.5f, -.5f, 2.f}, {0.f, 0.f, -1.f}});
+    REQUIRE(hit);
+    REQUIRE(hit.triangle == 0);
+    REQUIRE(hit.t == Approx(2.f));
+    auto pos = mesh.vertex_data[0].pos*(1.f-hit.u-hit.v) + mesh.vertex_data[1].pos*hit.u + mesh.vertex_data[2].pos*hit.v;
+    REQUIRE(pos.x == Approx(.5f));
+    REQUIRE(pos.y == Approx(-.5f));
+
+    // from below the lower triangle is hit first
+    hit = bvh.intersect(Ray{{.5f, -.5f, -2.f}, {0.f, 0.f, 1.f}});
+    REQUIRE(hit.triangle == 2);
+    REQUIRE(hit.t == Approx(1.f));
+
+    REQUIRE_FALSE(bvh.intersect(Ray{{.5f, -.5f, 2.f}, {0.f, 0.f, -1.f}, 1.5f}));
+    REQUIRE_FALSE(bvh.intersect(Ray{{.5f, -.5f, 2.f}, {0.f, 0.f, 1.f}}));
+    REQUIRE_FALSE(bvh.intersect(Ray{{3.f, 0.f, 2.f}, {0.f, 0.f, -1.f}}));
+}
+
+TEST_CASE("Bvh queries match brute force on room.obj", "[bvh]") {
+    auto mesh = load_obj(GLSB_RES_DIR "/room.obj");
+    auto bvh = Bvh(mesh.view(), BvhSettings{.max_leaf_size = 4});
+    REQUIRE(bvh.triangle_count() == mesh.index_data.size()/3);
+    REQUIRE(bvh.nodes().size() > 1);
+
+    // every triangle is inside the bounds of its leaf
+    for (const auto& vert : mesh.vertex_data) {
+        REQUIRE(glm::all(glm::lessThanEqual(bvh.bounds().lo, vert.pos)));
+        REQUIRE(glm::all(glm::lessThanEqual(vert.pos, bvh.bounds().hi)));
+    }
+
+    auto rays = random_rays(bvh.bounds(), 256);
+    for (size_t i=0; i<rays.size(); i+=ray_packet_size) {
+        auto packet = std::span<const Ray, ray_packet_size>(rays.data() + i, ray_packet_size);
+        auto packet_hits = bvh.intersect(packet);
+        for (size_t r=0; r<ray_packet_size; ++r) {
+            auto expected = intersect_brute_force(mesh, packet[r]);
+            auto hit = bvh.intersect(packet[r]);
+            REQUIRE(static_cast<bool>(hit) == static_cast<bool>(expected));
+            REQUIRE(static_cast<bool>(packet_hits[r]) == static_cast<bool>(expected));
+            if (expected) {
+                // triangles sharing an edge may tie, so only the distance has to match
+                REQUIRE(hit.t == Approx(expected.t).epsilon(1e-4));
+                REQUIRE(packet_hits[r].t == Approx(expected.t).epsilon(1e-4));
+            }
+        }
+    }
+}
+
+TEST_CASE("camera_ray goes through the view center", "[bvh]") {
+    auto cam = Camera{{0.f, -5.f, 1.f}, {0.f, 0.f, 1.f}, std::make_pair(.1f, 100.f), 60.f, 1.5f};
+    auto center = camera_ray(cam, glm::vec2(0.f));
+    REQUIRE(center.origin == cam.pos);
+    REQUIRE(glm::length(center.dir - glm::vec3(0.f, 1.f, 0.f)) < 1e-5f);
+
+    auto top_right = camera_ray(cam, glm::vec2(1.f));
+    REQUIRE(top_right.dir.x > 0.f);
+    REQUIRE(top_right.dir.z > 0.f);
+    // matches the projection: the corner lands on the corner of the clip space
+    auto clip = cam.get_proj_matrix()*cam.get_view_matrix()*glm::vec4(cam.pos + top_right.dir, 1.f);
+    REQUIRE(clip.x/clip.w == Approx(1.f));
+    REQUIRE(clip.y/clip.w == Approx(1.f));
+}
@@ -0,0 +1,67 @@
+#include <catch2/catch.hpp>
+
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include <cpu_profiler.h>
+
+TEST_CASE("CpuProfiler records nested zones per thread", "[cpu_profiler]") {
+    auto profiler = CpuProfiler{};
+    profiler.mark_frame();
+    {
+        auto outer = profiler.zone("outer");
+        auto inner = profiler.zone("inner");
+    }
+    auto worker = std::thread([&profiler]() {
+        auto zone = profiler.zone("worker");
+    });
+    worker.join();
+
+    auto threads = profiler.collect(1);
+    REQUIRE(threads.size() == 2);
+    REQUIRE(threads[0].size() == 2);
+    // closed first
+    REQUIRE(std::string(threads[0][0].name) == "inner");
+    REQUIRE(std::string(threads[0][1].name) == "outer");
+    REQUIRE(threads[0][1].begin_ns <= threads[0][0].begin_ns);
+    REQUIRE(threads[0][0].end_ns <= threads[0][1].end_ns);
+    REQUIRE(threads[1].size() == 1);
+    REQUIRE(std::string(threads[1][0].name) == "worker");
+}
+
+TEST_CASE("CpuProfiler keeps the last frames", "[cpu_profiler]") {
+    auto profiler = CpuProfiler{};
+    for (int i=0; i<3; ++i) {
+        profiler.mark_frame();
+        auto zone = profiler.zone("frame");
+    }
+    REQUIRE(profiler.collect(1)[0].size() == 1);
+    REQUIRE(profiler.collect(2)[0].size() == 2);
+    REQUIRE(profiler.collect(10)[0].size() == 3);
+}
+
+TEST_CASE("CpuProfiler overwrites the oldest zones", "[cpu_profiler]") {
+    auto profiler = CpuProfiler{};
+    for (size_t i=0; i<CpuProfiler::ring_size + 10; ++i) {
+        profiler.record("zone", i, i + 1);
+    }
+    auto threads = profiler.collect(0);
+    // the oldest slot is the next one written, so it's never trusted
+    REQUIRE(threads[0].size() == CpuProfiler::ring_size - 1);
+    REQUIRE(threads[0].front().begin_ns == 11);
+    REQUIRE(threads[0].back().begin_ns == CpuProfiler::ring_size + 9);
+}
+
+TEST_CASE("CpuProfiler writes Chrome trace events", "[cpu_profiler]") {
+    auto profiler = CpuProfiler{};
+    profiler.record("a \"quoted\" zone", 1500, 4250);
+
+    auto os = std::ostringstream{};
+    profiler.write_trace(os, 0);
+    REQUIRE(os.str() ==
+        "{\"traceEvents\":[\n"
+        "{\"name\":\"a \\\"quoted\\\" zone\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":0,\"tid\":0,\"ts\":1.500,\"dur\":2.750}\n"
+        "],\"displayTimeUnit\":\"ns\"}\n"
+    );
+}
@@ -0,0 +1,103 @@
+#include <catch2/catch.hpp>
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <culling.h>
+
+namespace {
+
+void push_sphere(BoundsList& bounds, glm::vec3 center, float radius) {
+    bounds.push_back(BoundingBox{center - radius, center + radius}, BoundingSphere{center, radius});
+}
+
+}
+
+TEST_CASE("Frustum planes enclose the view volume", "[culling]") {
+    auto cam = Camera{{0.f, 0.f, 0.f}, {0.f, 1.f, 0.f}, std::make_pair(.1f, 100.f), 90.f, 1.f};
+    auto frustum = Frustum::from_camera(cam);
+
+    auto signed_dist = [&](Frustum::Plane plane, glm::vec3 p) {
+        return glm::dot(glm::vec3(frustum.planes[plane]), p) + frustum.planes[plane].w;
+    };
+    REQUIRE(signed_dist(Frustum::Near, {0.f, 1.f, 0.f}) == Approx(.9f));
+    REQUIRE(signed_dist(Frustum::Far, {0.f, 1.f, 0.f}) == Approx(99.f));
+    for (auto plane : {Frustum::Left, Frustum::Right, Frustum::Bottom, Frustum::Top}) {
+        REQUIRE(signed_dist(plane, {0.f, 10.f, 0.f}) > 0.f);
+        REQUIRE(signed_dist(plane, {0.f, 10.f, 0.f}) == Approx(10.f*std::sqrt(.5f)));
+    }
+    // 90° fov: the side planes go through the diagonals
+    REQUIRE(signed_dist(Frustum::Right, {10.f, 10.f, 0.f}) == Approx(0.f).margin(1e-4));
+    REQUIRE(signed_dist(Frustum::Top, {0.f, 10.f, 10.f}) == Approx(0.f).margin(1e-4));
+}
+
+TEST_CASE("BoundsList::cull rejects objects outside the frustum", "[culling]") {
+    auto cam = Camera{{0.f, 0.f, 0.f}, {0.f, 1.f, 0.f}, std::make_pair(.1f, 100.f), 90.f, 1.f};
+    auto bounds = BoundsList{};
+    push_sphere(bounds, {0.f, 10.f, 0.f}, 1.f);     // in front
+    push_sphere(bounds, {0.f, -10.f, 0.f}, 1.f);    // behind
+    push_sphere(bounds, {12.f, 10.f, 0.f}, 1.f);    // right of the frustum
+    push_sphere(bounds, {10.5f, 10.f, 0.f}, 1.f);   // crossing the right plane
+    push_sphere(bounds, {0.f, 200.f, 0.f}, 1.f);    // beyond the far plane
+    // long thin box along the right plane: its sphere intersects the
+    // frustum, the box itself does not
+    bounds.push_back(BoundingBox{{20.f, 0.f, -.5f}, {21.f, 19.f, .5f}}, BoundingSphere{{20.5f, 9.5f, 0.f}, 9.6f});
+
+    auto visible = std::vector<uint8_t>(bounds.size());
+    REQUIRE(bounds.cull(Frustum::from_camera(cam), visible) == 2);
+    REQUIRE(visible == std::vector<uint8_t>{1, 0, 0, 1, 0, 0});
+}
+
+TEST_CASE("BoundsList::cull matches cull_scalar", "[culling]") {
+    auto rng = std::mt19937(42);
+    auto dist = std::uniform_real_distribution<float>(-50.f, 50.f);
+    auto size_dist = std::uniform_real_distribution<float>(.1f, 5.f);
+
+    // 37 objects: exercises the padding of the last SIMD batch
+    auto bounds = BoundsList{};
+    for (int i=0; i<37; ++i) {
+        auto center = glm::vec3(dist(rng), dist(rng), dist(rng));
+        auto half_size = glm::vec3(size_dist(rng), size_dist(rng), size_dist(rng));
+        bounds.push_back(BoundingBox{center - half_size, center + half_size}, BoundingSphere{center, glm::length(half_size)});
+    }
+    auto cam = Camera{{0.f, 0.f, 0.f}, {1.f, 1.f, .2f}, std::make_pair(.1f, 200.f), 90.f, 1.6f};
+    auto frustum = Frustum::from_camera(cam);
+
+    auto visible = std::vector<uint8_t>(bounds.size());
+    auto visible_scalar = std::vector<uint8_t>(bounds.size());
+    auto count = bounds.cull(frustum, visible);
+    REQUIRE(count == bounds.cull_scalar(frustum, visible_scalar));
+    REQUIRE(visible == visible_scalar);
+    REQUIRE(count > 0);
+    REQUIRE(count < bounds.size());
+}
+
+TEST_CASE("BoundsList::set replaces the bounds of an object", "[culling]") {
+    auto cam = Camera{{0.f, 0.f, 0.f}, {0.f, 1.f, 0.f}, std::make_pair(.1f, 100.f), 90.f, 1.f};
+    auto bounds = BoundsList{};
+    push_sphere(bounds, {0.f, 10.f, 0.f}, 1.f);
+    push_sphere(bounds, {0.f, 20.f, 0.f}, 1.f);
+
+    // moved behind the camera
+    bounds.set(0, BoundingBox{{-1.f, -11.f, -1.f}, {1.f, -9.f, 1.f}}, BoundingSphere{{0.f, -10.f, 0.f}, 1.f});
+    REQUIRE(bounds.size() == 2);
+    auto visible = std::vector<uint8_t>(bounds.size());
+    REQUIRE(bounds.cull(Frustum::from_camera(cam), visible) == 1);
+    REQUIRE(visible == std::vector<uint8_t>{0, 1});
+}
+
+TEST_CASE("BoundsList::cull rejects empty bounds", "[culling]") {
+    auto cam = Camera{{0.f, 0.f, 0.f}, {0.f, 1.f, 0.f}, std::make_pair(.1f, 100.f), 90.f, 1.f};
+    auto bounds = BoundsList{};
+    push_sphere(bounds, {0.f, 10.f, 0.f}, 1.f);
+    push_sphere(bounds, {0.f, 20.f, 0.f}, 1.f);
+
+    // like a released mesh
+    bounds.set(1, BoundingBox::empty(), BoundingSphere{glm::vec3(0.f), 0.f});
+    auto visible = std::vector<uint8_t>(bounds.size());
+    REQUIRE(bounds.cull(Frustum::from_camera(cam), visible) == 1);
+    REQUIRE(visible == std::vector<uint8_t>{1, 0});
+    REQUIRE(bounds.cull_scalar(Frustum::from_camera(cam), visible) == 1);
+    REQUIRE(visible == std::vector<uint8_t>{1, 0});
+}
@@ -0,0 +1,62 @@
+#include <catch2/catch.hpp>
+
+#include <random>
+
+#include <light_clusters.h>
+
+namespace {
+
+ClusterGrid test_grid() {
+    auto cam = Camera{{0.f, 0.f, 0.f}, {0.f, 1.f, 0.f}, std::make_pair(.1f, 100.f), 60.f, 16.f/9.f};
+    return ClusterGrid::from_camera(cam);
+}
+
+}
+
+TEST_CASE("ClusterGrid slices span the view depth", "[light_clusters]") {
+    auto grid = test_grid();
+    REQUIRE(grid.cluster_count() == 16*9*24);
+    REQUIRE(grid.slice_depth(0) == Approx(.1f));
+    REQUIRE(grid.slice_depth(grid.size.z) == Approx(100.f));
+    for (uint32_t k=0; k<grid.size.z; ++k) {
+        auto near = grid.slice_depth(k);
+        auto far = grid.slice_depth(k + 1);
+        REQUIRE(near < far);
+        REQUIRE(grid.slice(near*1.001f) == k);
+        REQUIRE(grid.slice(far*.999f) == k);
+    }
+    // clamped
+    REQUIRE(grid.slice(.01f) == 0);
+    REQUIRE(grid.slice(1000.f) == grid.size.z - 1);
+}
+
+TEST_CASE("ClusterGrid::bounds contains the points of the cluster", "[light_clusters]") {
+    auto grid = test_grid();
+    auto rng = std::mt19937(42);
+    auto ndc = std::uniform_real_distribution<float>(-1.f, 1.f);
+    auto depth = std::uniform_real_distribution<float>(.1f, 100.f);
+    for (int i=0; i<1000; ++i) {
+        auto d = depth(rng);
+        auto pos = glm::vec3(ndc(rng)*grid.tan_half_fov*grid.aspect*d, ndc(rng)*grid.tan_half_fov*d, -d);
+        auto cluster = grid.cluster_of(pos);
+        REQUIRE(cluster.x < grid.size.x);
+        REQUIRE(cluster.y < grid.size.y);
+        REQUIRE(cluster.z < grid.size.z);
+        auto bounds = grid.bounds(cluster);
+        auto eps = 1e-4f*d;
+        REQUIRE(glm::all(glm::greaterThanEqual(pos, bounds.lo - eps)));
+        REQUIRE(glm::all(glm::lessThanEqual(pos, bounds.hi + eps)));
+    }
+}
+
+TEST_CASE("ClusterGrid::cluster_of maps screen tiles", "[light_clusters]") {
+    auto grid = test_grid();
+    // on the view axis: the center tiles
+    REQUIRE(grid.cluster_of({0.f, 0.f, -1.f}) == glm::uvec3(8, 4, grid.slice(1.f)));
+    // lower left and upper right corner of the screen
+    auto d = 10.f;
+    auto corner = glm::vec3(grid.tan_half_fov*grid.aspect*d, grid.tan_half_fov*d, -d)*.999f;
+    REQUIRE(grid.cluster_of(corner) == glm::uvec3(15, 8, grid.slice(-corner.z)));
+    REQUIRE(grid.cluster_of({-corner.x, -corner.y, corner.z}) == glm::uvec3(0, 0, grid.slice(-corner.z)));
+    REQUIRE(grid.index({1, 2, 3}) == (3*9 + 2)*16 + 1);
+}
@@ -0,0 +1,274 @@
+#include <catch2/catch.hpp>
+
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <span>
+#include <string>
+
+#include <fmt/format.h>
+
+#include <mesh.h>
+#include <mesh_cache.h>
+
+namespace {
+
+std::filesystem::path write_tmp_file(const char* name, const char* content) {
+    auto fpath = std::filesystem::temp_directory_path() / name;
+    auto ofs = std::ofstream(fpath);
+    ofs << content;
+    return fpath;
+}
+
+const char* quad_obj =
+    "o quad\n"
+    "v 0 0 0\n"
+    "v 1 0 0\n"
+    "v 1 1 0\n"
+    "v 0 1 0\n"
+    "vt 0 0\n"
+    "vt 1 0\n"
+    "vt 1 1\n"
+    "vt 0 1\n"
+    "vn 0 0 1\n"
+    "f 1/1/1 2/2/1 3/3/1\n"
+    "f 3/3/1 4/4/1 1/1/1\n";
+
+}
+
+TEST_CASE("load_obj shares vertices between faces", "[mesh]") {
+    auto fpath = write_tmp_file("glsb_test_quad.obj", quad_obj);
+
+    auto stats = WeldStats{};
+    auto mesh = load_obj(fpath, ObjLoadOptions{.optimize = false, .use_cache = false}, &stats);
+
+    REQUIRE(stats.vertices_before == 6);
+    REQUIRE(stats.vertices_after == 4);
+    REQUIRE(mesh.vertex_data.size() == 4);
+    REQUIRE(mesh.index_data == std::vector<uint32_t>{0, 1, 2, 2, 3, 0});
+
+    auto unwelded = load_obj(fpath, ObjLoadOptions{.weld = false, .optimize = false, .use_cache = false});
+    REQUIRE(unwelded.vertex_data.size() == 6);
+    for (size_t i=0; i<mesh.index_data.size(); ++i) {
+        const auto& a = mesh.vertex_data[mesh.index_data[i]];
+        const auto& b = unwelded.vertex_data[unwelded.index_data[i]];
+        REQUIRE(a.pos == b.pos);
+        REQUIRE(a.norm == b.norm);
+        REQUIRE(a.uv == b.uv);
+    }
+
+    std::filesystem::remove(fpath);
+}
+
+TEST_CASE("load_obj reports the weld stats of the source on a cache hit", "[mesh]") {
+    auto fpath = write_tmp_file("glsb_test_cached_quad.obj", quad_obj);
+    auto cache_path = mesh_cache_path(fpath);
+
+    auto written = WeldStats{};
+    load_obj(fpath, ObjLoadOptions{.optimize = false}, &written);
+    REQUIRE(std::filesystem::exists(cache_path));
+
+    auto cached = WeldStats{};
+    auto mesh = load_obj(fpath, ObjLoadOptions{.optimize = false}, &cached);
+    REQUIRE(mesh.vertex_data.size() == 4);
+    REQUIRE(cached.vertices_before == 6);
+    REQUIRE(cached.vertices_after == 4);
+
+    std::filesystem::remove(cache_path);
+    std::filesystem::remove(fpath);
+}
+
+TEST_CASE("weld_vertices merges quantized duplicates", "[mesh]") {
+    auto mesh = Mesh<FlatVertex>{
+        {
+            {{0.f, 0.f, 0.f}, {1.f, 1.f, 1.f, 1.f}},
+            {{1.f, 0.f, 0.f}, {1.f, 1.f, 1.f, 1.f}},
+            {{1.f, 1.f, 0.f}, {1.f, 1.f, 1.f, 1.f}},
+            {{1.f, 1.00001f, 0.f}, {1.f, 1.f, 1.f, 1.f}},
+            {{0.f, 1.f, -0.f}, {1.f, 1.f, 1.f, 1.f}},
+            {{0.f, 0.f, 0.f}, {1.f, 1.f, 1.f, 1.f}},
+        },
+        {0, 1, 2, 3, 4, 5}
+    };
+
+    SECTION("exact") {
+        auto stats = weld_vertices(mesh);
+        REQUIRE(stats.vertices_before == 6);
+        REQUIRE(stats.vertices_after == 5);
+        REQUIRE(mesh.index_data == std::vector<uint32_t>{0, 1, 2, 3, 4, 0});
+    }
+
+    SECTION("quantized") {
+        auto stats = weld_vertices(mesh, 1e-3f);
+        REQUIRE(stats.vertices_after == 4);
+        REQUIRE(mesh.index_data == std::vector<uint32_t>{0, 1, 2, 2, 3, 0});
+    }
+}
+
+TEST_CASE("mesh cache roundtrip", "[mesh]") {
+    auto fpath = std::filesystem::temp_directory_path() / "glsb_test_roundtrip.glsbmesh";
+    auto mesh = generate_quad(2.f, 3.f);
+
+    write_mesh_cache(fpath, mesh.view(), 42, 6);
+
+    REQUIRE_FALSE(map_mesh_cache<Vertex>(fpath, 43));
+    REQUIRE_FALSE(map_mesh_cache<FlatVertex>(fpath, 42));
+
+    auto mapped = map_mesh_cache<Vertex>(fpath, 42);
+    REQUIRE(mapped);
+    REQUIRE(mapped->corner_count() == 6);
+    auto view = mapped->view();
+    REQUIRE(reinterpret_cast<uintptr_t>(view.vertex_data.data()) % mesh_cache_alignment == 0);
+    REQUIRE(reinterpret_cast<uintptr_t>(view.index_data.data()) % mesh_cache_alignment == 0);
+
+    auto loaded = mapped->to_mesh();
+    REQUIRE(loaded.index_data == mesh.index_data);
+    REQUIRE(loaded.vertex_data.size() == mesh.vertex_data.size());
+    for (size_t i=0; i<mesh.vertex_data.size(); ++i) {
+        REQUIRE(loaded.vertex_data[i].pos == mesh.vertex_data[i].pos);
+        REQUIRE(loaded.vertex_data[i].uv == mesh.vertex_data[i].uv);
+    }
+
+    mapped.reset();
+    std::filesystem::remove(fpath);
+}
+
+TEST_CASE("map_mesh_cache rejects counts beyond the file", "[mesh]") {
+    auto fpath = std::filesystem::temp_directory_path() / "glsb_test_corrupt.glsbmesh";
+    auto mesh = generate_quad(2.f, 3.f);
+    write_mesh_cache(fpath, mesh.view(), 42, 6);
+
+    // multiplied by the vertex size, this wraps around to the real size of
+    // the vertex data
+    auto vertex_count = std::numeric_limits<uint64_t>::max() / sizeof(Vertex) + 1 + mesh.vertex_data.size();
+    {
+        auto fs = std::fstream(fpath, std::ios::in | std::ios::out | std::ios::binary);
+        fs.seekp(offsetof(MeshCacheHeader, vertex_count));
+        fs.write(reinterpret_cast<const char*>(&vertex_count), sizeof(vertex_count));
+    }
+    REQUIRE_FALSE(map_mesh_cache<Vertex>(fpath, 42));
+
+    std::filesystem::remove(fpath);
+}
+
+namespace {
+
+struct CollectingSink final : public MeshSink {
+    void append(std::span<const Vertex> vertices, std::span<const uint32_t> indices) override {
+        // indices count all preceding batches
+        for (auto idx : indices) {
+            REQUIRE(idx < mesh.vertex_data.size() + vertices.size());
+        }
+        mesh.vertex_data.insert(mesh.vertex_data.end(), vertices.begin(), vertices.end());
+        mesh.index_data.insert(mesh.index_data.end(), indices.begin(), indices.end());
+        ++batches;
+    }
+
+    void finish() override {
+        is_finished = true;
+    }
+
+    Mesh<Vertex> mesh;
+    size_t batches = 0;
+    bool is_finished = false;
+};
+
+// compares the corners of both meshes in order, independent of the vertex sharing
+void require_same_triangles(MeshView<Vertex> a, MeshView<Vertex> b) {
+    REQUIRE(a.index_data.size() == b.index_data.size());
+    for (size_t i=0; i<a.index_data.size(); ++i) {
+        const auto& va = a.vertex_data[a.index_data[i]];
+        const auto& vb = b.vertex_data[b.index_data[i]];
+        REQUIRE(va.pos == vb.pos);
+        REQUIRE(va.norm == vb.norm);
+        REQUIRE(va.uv == vb.uv);
+    }
+}
+
+// enough for the attributes of res/room.obj, small enough for several batches
+constexpr auto stream_budget = size_t{1024*1024};
+
+}
+
+TEST_CASE("stream_obj emits the mesh in batches", "[mesh]") {
+    auto fpath = std::filesystem::path(GLSB_RES_DIR "/room.obj");
+    auto reference = load_obj(fpath, ObjLoadOptions{.optimize = false, .use_cache = false});
+
+    auto sink = CollectingSink{};
+    auto stats = stream_obj(fpath, sink, ObjStreamOptions{.memory_budget = stream_budget});
+
+    REQUIRE(sink.is_finished);
+    REQUIRE(stats.batch_count > 1);
+    REQUIRE(stats.batch_count == sink.batches);
+    REQUIRE(stats.vertex_count == sink.mesh.vertex_data.size());
+    REQUIRE(stats.index_count == sink.mesh.index_data.size());
+    REQUIRE(stats.peak_bytes <= stream_budget);
+    require_same_triangles(sink.mesh.view(), reference.view());
+}
+
+TEST_CASE("stream_obj counts the attributes against the budget", "[mesh]") {
+    auto fpath = std::filesystem::path(GLSB_RES_DIR "/room.obj");
+    auto sink = CollectingSink{};
+    REQUIRE_THROWS_AS(stream_obj(fpath, sink, ObjStreamOptions{.memory_budget = obj_min_stream_budget}), GLSBError);
+}
+
+TEST_CASE("stream_obj resolves relative indices across pieces", "[mesh]") {
+    // a strip of quads, each referring to its own vertices relatively
+    auto obj = std::string("vn 0 0 1\nvt 0 0\n");
+    for (int i=0; i<2000; ++i) {
+        obj += fmt::format("v {} 0 0\nv {} 0 0\nv {} 1 0\nv {} 1 0\n", i, i+1, i+1, i);
+        obj += "f -4/1/1 -3/1/1 -2/1/1 -1/1/1\n";
+    }
+    auto fpath = write_tmp_file("glsb_test_relative.obj", obj.c_str());
+    auto reference = load_obj(fpath, ObjLoadOptions{.optimize = false, .use_cache = false});
+
+    auto sink = CollectingSink{};
+    auto stats = stream_obj(fpath, sink, ObjStreamOptions{.memory_budget = stream_budget, .weld = false});
+    REQUIRE(stats.batch_count > 1);
+    require_same_triangles(sink.mesh.view(), reference.view());
+
+    std::filesystem::remove(fpath);
+}
+
+TEST_CASE("stream_obj into a mesh cache", "[mesh]") {
+    auto fpath = std::filesystem::path(GLSB_RES_DIR "/room.obj");
+    auto cache_path = std::filesystem::temp_directory_path() / "glsb_test_stream.glsbmesh";
+
+    auto sink = CollectingSink{};
+    stream_obj(fpath, sink, ObjStreamOptions{.memory_budget = stream_budget});
+    {
+        auto cache_sink = MeshCacheSink(cache_path, 7);
+        stream_obj(fpath, cache_sink, ObjStreamOptions{.memory_budget = stream_budget});
+    }
+
+    auto mapped = map_mesh_cache<Vertex>(cache_path, 7);
+    REQUIRE(mapped);
+    REQUIRE(mapped->view().index_data.size() == sink.mesh.index_data.size());
+    REQUIRE(mapped->view().vertex_data.size() == sink.mesh.vertex_data.size());
+    REQUIRE(mapped->corner_count() == sink.mesh.index_data.size());
+    require_same_triangles(mapped->view(), sink.mesh.view());
+
+    mapped.reset();
+    std::filesystem::remove(cache_path);
+}
+
+TEST_CASE("generate_icosphere covers the unit sphere", "[mesh]") {
+    auto [subdivisions, vertex_count] = GENERATE(
+        std::make_pair(0u, size_t{12}),
+        std::make_pair(1u, size_t{42}),
+        std::make_pair(2u, size_t{162})
+    );
+    auto mesh = generate_icosphere(subdivisions);
+    REQUIRE(mesh.vertex_data.size() == vertex_count);
+    REQUIRE(mesh.index_data.size() == 60*(size_t{1} << (2*subdivisions)));
+
+    for (size_t i=0; i<mesh.index_data.size(); i+=3) {
+        const auto& a = mesh.vertex_data[mesh.index_data[i]].pos;
+        const auto& b = mesh.vertex_data[mesh.index_data[i + 1]].pos;
+        const auto& c = mesh.vertex_data[mesh.index_data[i + 2]].pos;
+        // counter-clockwise seen from outside, and not cutting into the sphere
+        auto n = glm::normalize(glm::cross(b - a, c - a));
+        REQUIRE(glm::dot(n, a) >= 1.f - 1e-5f);
+    }
+}
@@ -0,0 +1,105 @@
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <array>
+#include <vector>
+
+#include <mesh_optimizer.h>
+
+namespace {
+
+// `size`x`size` quads, triangles emitted column by column to get a poor
+// initial cache order
+Mesh<FlatVertex> generate_grid(uint32_t size) {
+    auto mesh = Mesh<FlatVertex>{};
+    for (uint32_t y=0; y<=size; ++y) {
+        for (uint32_t x=0; x<=size; ++x) {
+            mesh.vertex_data.push_back({{static_cast<float>(x), static_cast<float>(y), 0.f}, {1.f, 1.f, 1.f, 1.f}});
+        }
+    }
+    for (uint32_t x=0; x<size; ++x) {
+        for (uint32_t y=0; y<size; ++y) {
+            auto i0 = y*(size+1) + x;
+            auto i1 = i0 + 1;
+            auto i2 = i1 + size + 1;
+            auto i3 = i0 + size + 1;
+            mesh.index_data.insert(mesh.index_data.end(), {i0, i1, i2, i2, i3, i0});
+        }
+    }
+    return mesh;
+}
+
+std::vector<std::array<glm::vec3, 3>> triangles_of(const Mesh<FlatVertex>& mesh) {
+    auto ret = std::vector<std::array<glm::vec3, 3>>{};
+    for (size_t i=0; i<mesh.index_data.size(); i+=3) {
+        ret.push_back({
+            mesh.vertex_data[mesh.index_data[i+0]].pos,
+            mesh.vertex_data[mesh.index_data[i+1]].pos,
+            mesh.vertex_data[mesh.index_data[i+2]].pos,
+        });
+    }
+    auto less = [](const auto& a, const auto& b) {
+        for (size_t k=0; k<3; ++k) {
+            for (int c=0; c<3; ++c) {
+                if (a[k][c] != b[k][c]) {
+                    return a[k][c] < b[k][c];
+                }
+            }
+        }
+        return false;
+    };
+    std::sort(ret.begin(), ret.end(), less);
+    return ret;
+}
+
+}
+
+TEST_CASE("analyze_vertex_cache", "[mesh_optimizer]") {
+    auto indices = std::vector<uint32_t>{0, 1, 2, 2, 1, 3};
+    auto stats = analyze_vertex_cache(indices, 4);
+    REQUIRE(stats.vertices_transformed == 4);
+    REQUIRE(stats.acmr == Approx(2.f));
+    REQUIRE(stats.atvr == Approx(1.f));
+
+    // with a single entry every corner but repeated ones misses
+    stats = analyze_vertex_cache(indices, 4, 1);
+    REQUIRE(stats.vertices_transformed == 5);
+}
+
+TEST_CASE("optimize_mesh keeps the triangles and improves cache reuse", "[mesh_optimizer]") {
+    auto mesh = generate_grid(64);
+    auto reference = triangles_of(mesh);
+
+    auto stats = optimize_mesh(mesh);
+
+    REQUIRE(stats.after.acmr < stats.before.acmr);
+    REQUIRE(stats.after.acmr < .8f);
+    REQUIRE(triangles_of(mesh) == reference);
+
+    // vertices are stored in first-use order
+    auto next = uint32_t{0};
+    for (auto idx : mesh.index_data) {
+        REQUIRE(idx <= next);
+        if (idx == next) {
+            ++next;
+        }
+    }
+    REQUIRE(next == mesh.vertex_data.size());
+}
+
+TEST_CASE("optimize_vertex_fetch drops unreferenced vertices", "[mesh_optimizer]") {
+    auto mesh = Mesh<FlatVertex>{
+        {
+            {{0.f, 0.f, 0.f}, {}},
+            {{1.f, 0.f, 0.f}, {}},
+            {{2.f, 0.f, 0.f}, {}},
+            {{3.f, 0.f, 0.f}, {}},
+        },
+        {3, 1, 0}
+    };
+    optimize_vertex_fetch(mesh);
+    REQUIRE(mesh.vertex_data.size() == 3);
+    REQUIRE(mesh.index_data == std::vector<uint32_t>{0, 1, 2});
+    REQUIRE(mesh.vertex_data[0].pos.x == 3.f);
+    REQUIRE(mesh.vertex_data[2].pos.x == 0.f);
+}
@@ -0,0 +1,217 @@
+#include <catch2/catch.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include <lod.h>
+#include <mesh_simplifier.h>
+
+namespace {
+
+// `size`x`size` quads in the xy plane, displaced in z by `height(x, y)`
+template <typename FnT>
+Mesh<Vertex> generate_heightfield(uint32_t size, FnT&& height) {
+    auto mesh = Mesh<Vertex>{};
+    for (uint32_t y=0; y<=size; ++y) {
+        for (uint32_t x=0; x<=size; ++x) {
+            auto fx = static_cast<float>(x);
+            auto fy = static_cast<float>(y);
+            mesh.vertex_data.push_back({{fx, fy, height(fx, fy)}, {0.f, 0.f, 1.f}, {fx, fy}});
+        }
+    }
+    for (uint32_t y=0; y<size; ++y) {
+        for (uint32_t x=0; x<size; ++x) {
+            auto i0 = y*(size+1) + x;
+            auto i1 = i0 + 1;
+            auto i2 = i1 + size + 1;
+            auto i3 = i0 + size + 1;
+            mesh.index_data.insert(mesh.index_data.end(), {i0, i1, i2, i2, i3, i0});
+        }
+    }
+    return mesh;
+}
+
+std::vector<glm::vec3> positions_of(const Mesh<Vertex>& mesh) {
+    auto ret = std::vector<glm::vec3>{};
+    for (const auto& vert : mesh.vertex_data) {
+        ret.push_back(vert.pos);
+    }
+    return ret;
+}
+
+}
+
+TEST_CASE("simplify collapses flat regions without error", "[mesh_simplifier]") {
+    auto mesh = generate_heightfield(32, [](float, float) { return 0.f; });
+    auto positions = positions_of(mesh);
+
+    auto error = -1.f;
+    auto target = mesh.index_data.size()/10;
+    auto indices = simplify(mesh.index_data, positions, target, &error);
+
+    REQUIRE(indices.size() <= target);
+    REQUIRE(indices.size() % 3 == 0);
+    REQUIRE(error == Approx(0.f).margin(1e-3));
+
+    // the outline is kept: all corners are still referenced
+    for (auto corner : {0u, 32u, 33u*32u, 33u*33u-1u}) {
+        REQUIRE(std::find(indices.begin(), indices.end(), corner) != indices.end());
+    }
+
+    // no triangle is flipped
+    for (size_t i=0; i<indices.size(); i+=3) {
+        auto n = glm::cross(
+            positions[indices[i+1]] - positions[indices[i]],
+            positions[indices[i+2]] - positions[indices[i]]
+        );
+        REQUIRE(n.z > 0.f);
+    }
+}
+
+TEST_CASE("simplify reports the error on curved surfaces", "[mesh_simplifier]") {
+    auto mesh = generate_heightfield(32, [](float x, float y) { return std::sin(x*.3f)*std::cos(y*.3f)*2.f; });
+    auto positions = positions_of(mesh);
+
+    auto coarse_error = 0.f;
+    auto fine_error = 0.f;
+    auto fine = simplify(mesh.index_data, positions, mesh.index_data.size()/2, &fine_error);
+    auto coarse = simplify(mesh.index_data, positions, mesh.index_data.size()/8, &coarse_error);
+
+    REQUIRE(fine.size() <= mesh.index_data.size()/2);
+    REQUIRE(coarse.size() <= mesh.index_data.size()/8);
+    REQUIRE(fine_error > 0.f);
+    REQUIRE(coarse_error >= fine_error);
+    REQUIRE(coarse_error < 2.f);
+}
+
+TEST_CASE("simplify collapses attribute seams without cracks", "[mesh_simplifier]") {
+    auto mesh = generate_heightfield(16, [](float x, float y) { return std::sin(x*.3f)*std::cos(y*.3f); });
+    // split the mesh along x == 8 like a texture seam would
+    auto seam = std::vector<uint32_t>{};
+    for (uint32_t y=0; y<=16; ++y) {
+        seam.push_back(y*17 + 8);
+    }
+    auto seam_copies = std::vector<uint32_t>{};
+    for (auto v : seam) {
+        seam_copies.push_back(static_cast<uint32_t>(mesh.vertex_data.size()));
+        mesh.vertex_data.push_back(mesh.vertex_data[v]);
+    }
+    for (size_t i=0; i<mesh.index_data.size(); i+=3) {
+        auto right = true;
+        for (size_t k=0; k<3; ++k) {
+            right = right && (mesh.vertex_data[mesh.index_data[i+k]].pos.x >= 8.f);
+        }
+        for (size_t k=0; (k<3) && right; ++k) {
+            auto it = std::find(seam.begin(), seam.end(), mesh.index_data[i+k]);
+            if (it != seam.end()) {
+                mesh.index_data[i+k] = seam_copies[static_cast<size_t>(it - seam.begin())];
+            }
+        }
+    }
+
+    auto positions = positions_of(mesh);
+    auto result = simplify(mesh.index_data, positions, mesh.index_data.size()/4);
+    REQUIRE(result.size() <= mesh.index_data.size()/4);
+
+    // each side keeps its own seam vertices
+    auto is_right = [&](uint32_t v) {
+        return (v >= seam_copies.front()) || (positions[v].x > 8.f);
+    };
+    for (size_t i=0; i<result.size(); i+=3) {
+        auto right = is_right(result[i]) + is_right(result[i+1]) + is_right(result[i+2]);
+        REQUIRE(((right == 0) || (right == 3)));
+    }
+
+    // both sides still meet: apart from the outline, every edge has its
+    // opposite at the same positions
+    auto edges = std::set<std::pair<std::array<float, 3>, std::array<float, 3>>>{};
+    auto key = [&](uint32_t v) {
+        return std::array<float, 3>{positions[v].x, positions[v].y, positions[v].z};
+    };
+    for (size_t i=0; i<result.size(); i+=3) {
+        for (size_t k=0; k<3; ++k) {
+            edges.emplace(key(result[i+k]), key(result[i+(k+1)%3]));
+        }
+    }
+    auto on_outline = [&](uint32_t v) {
+        const auto& p = positions[v];
+        return (p.x == 0.f) || (p.x == 16.f) || (p.y == 0.f) || (p.y == 16.f);
+    };
+    for (size_t i=0; i<result.size(); i+=3) {
+        for (size_t k=0; k<3; ++k) {
+            auto a = result[i+k];
+            auto b = result[i+(k+1)%3];
+            if (!edges.contains({key(b), key(a)})) {
+                REQUIRE(on_outline(a));
+                REQUIRE(on_outline(b));
+            }
+        }
+    }
+}
+
+TEST_CASE("generate_lods reduces meshes with seams at every vertex", "[mesh_simplifier]") {
+    // flat shaded: every quad has its own 4 vertices
+    auto mesh = Mesh<Vertex>{};
+    for (uint32_t y=0; y<16; ++y) {
+        for (uint32_t x=0; x<16; ++x) {
+            auto base = static_cast<uint32_t>(mesh.vertex_data.size());
+            for (auto [dx, dy] : {std::pair{0.f, 0.f}, {1.f, 0.f}, {1.f, 1.f}, {0.f, 1.f}}) {
+                auto px = static_cast<float>(x) + dx;
+                auto py = static_cast<float>(y) + dy;
+                mesh.vertex_data.push_back({{px, py, std::sin(px*.3f)}, {0.f, 0.f, 1.f}, {dx, dy}});
+            }
+            mesh.index_data.insert(mesh.index_data.end(), {base, base+1, base+2, base+2, base+3, base});
+        }
+    }
+    auto index_count = mesh.index_data.size();
+    auto lod_mesh = generate_lods(std::move(mesh));
+    REQUIRE(lod_mesh.lods.size() == 4);
+    REQUIRE(lod_mesh.lods.back().index_count <= index_count/8);
+
+    // the cube of the sandbox, whose corners are all seams
+    auto cube = generate_lods(load_obj(GLSB_RES_DIR "/cube.obj", ObjLoadOptions{.use_cache = false}));
+    REQUIRE(cube.lods.size() > 1);
+    REQUIRE(cube.lods[1].index_count < cube.lods[0].index_count);
+}
+
+TEST_CASE("generate_lods builds coarser levels", "[mesh_simplifier]") {
+    auto mesh = load_obj(GLSB_RES_DIR "/room.obj");
+    auto index_count = mesh.index_data.size();
+    auto lod_mesh = generate_lods(std::move(mesh), LodSettings{.reduction_targets = {.5f, .25f}});
+
+    REQUIRE(lod_mesh.lods.size() >= 1);
+    REQUIRE(lod_mesh.lods[0].index_offset == 0);
+    REQUIRE(lod_mesh.lods[0].index_count == index_count);
+    REQUIRE(lod_mesh.lods[0].error == 0.f);
+    for (size_t level=1; level<lod_mesh.lods.size(); ++level) {
+        const auto& prev = lod_mesh.lods[level-1];
+        const auto& lod = lod_mesh.lods[level];
+        REQUIRE(lod.index_offset == prev.index_offset + prev.index_count);
+        REQUIRE(lod.index_count < prev.index_count);
+        REQUIRE(lod.error >= prev.error);
+        for (auto idx : lod_mesh.view(level).index_data) {
+            REQUIRE(idx < lod_mesh.mesh.vertex_data.size());
+        }
+    }
+    auto last = lod_mesh.lods.back();
+    REQUIRE(last.index_offset + last.index_count == lod_mesh.mesh.index_data.size());
+}
+
+TEST_CASE("select_lod picks coarser levels with distance", "[mesh_simplifier]") {
+    auto lods = std::vector<MeshLod>{{0, 300, 0.f}, {300, 150, .01f}, {450, 60, .1f}};
+    auto bounds = BoundingSphere{glm::vec3(0.f), 1.f};
+    auto cam = Camera{{0.f, 0.f, 2.f}, {0.f, 0.f, 0.f}, std::make_pair(.1f, 1000.f), 45.f, 1.f};
+
+    REQUIRE(select_lod(lods, bounds, cam, 1000.f, 1.f) == 0);
+    cam.pos.z = 30.f;
+    REQUIRE(select_lod(lods, bounds, cam, 1000.f, 1.f) == 1);
+    cam.pos.z = 500.f;
+    REQUIRE(select_lod(lods, bounds, cam, 1000.f, 1.f) == 2);
+    // a looser threshold allows coarser levels earlier
+    cam.pos.z = 30.f;
+    REQUIRE(select_lod(lods, bounds, cam, 1000.f, 10.f) == 2);
+}
@@ -0,0 +1,125 @@
+#include <catch2/catch.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <obj_parser.h>
+#include <thread_pool.h>
+#include <utils.h>
+
+namespace {
+
+void require_equal(
+        const tinyobj::attrib_t& attrib_a,
+        const std::vector<tinyobj::shape_t>& shapes_a,
+        const tinyobj::attrib_t& attrib_b,
+        const std::vector<tinyobj::shape_t>& shapes_b) {
+    REQUIRE(attrib_a.vertices == attrib_b.vertices);
+    REQUIRE(attrib_a.normals == attrib_b.normals);
+    REQUIRE(attrib_a.texcoords == attrib_b.texcoords);
+    REQUIRE(shapes_a.size() == shapes_b.size());
+    for (size_t s=0; s<shapes_a.size(); ++s) {
+        REQUIRE(shapes_a[s].name == shapes_b[s].name);
+        REQUIRE(shapes_a[s].mesh.num_face_vertices == shapes_b[s].mesh.num_face_vertices);
+        REQUIRE(shapes_a[s].mesh.indices.size() == shapes_b[s].mesh.indices.size());
+        for (size_t i=0; i<shapes_a[s].mesh.indices.size(); ++i) {
+            const auto& a = shapes_a[s].mesh.indices[i];
+            const auto& b = shapes_b[s].mesh.indices[i];
+            REQUIRE(a.vertex_index == b.vertex_index);
+            REQUIRE(a.normal_index == b.normal_index);
+            REQUIRE(a.texcoord_index == b.texcoord_index);
+        }
+    }
+}
+
+std::string generate_obj(int shape_count, int quads_per_shape) {
+    auto ss = std::ostringstream{};
+    ss << "# generated\nmtllib none.mtl\n";
+    for (int s=0; s<shape_count; ++s) {
+        ss << ((s % 2 == 0) ? "o shape" : "g group") << s << "\n";
+        for (int q=0; q<quads_per_shape; ++q) {
+            ss << "v " << q << ".25 " << s << " -1.5e-1\n";
+            ss << "v " << q << ".5 " << s << " 1\n";
+            ss << "v " << q << ".75 " << s+1 << " 0.125\n";
+            ss << "v " << q << " " << s+1 << " 2E2\n";
+            ss << "vt 0." << q % 10 << " 1\n";
+            ss << "vn 0 0 " << ((q % 2 == 0) ? "1" : "-1") << "\n";
+            if (q % 3 == 0) {
+                // relative indices
+                ss << "f -4/-1/-1 -3/-1/-1 -2/-1/-1 -1/-1/-1\n";
+            } else {
+                auto base = (s*quads_per_shape + q)*4 + 1;
+                auto tex = s*quads_per_shape + q + 1;
+                ss << "f " << base << "/" << tex << "/" << tex << " "
+                    << base+1 << "//" << tex << " "
+                    << base+2 << "/" << tex << " "
+                    << base+3 << "\r\n";
+            }
+        }
+    }
+    return ss.str();
+}
+
+}
+
+TEST_CASE("parse_obj gives the same result for any chunking", "[obj_parser]") {
+    auto text = generate_obj(7, 500);
+
+    auto attrib_ref = tinyobj::attrib_t{};
+    auto shapes_ref = std::vector<tinyobj::shape_t>{};
+    parse_obj(text, attrib_ref, shapes_ref);
+    REQUIRE(shapes_ref.size() == 7);
+    REQUIRE(shapes_ref[1].name == "group1");
+    REQUIRE(shapes_ref[0].mesh.indices.size() == 500*6);
+    REQUIRE(shapes_ref[0].mesh.indices[0].vertex_index == 0);
+    REQUIRE(attrib_ref.vertices[2] == Approx(-.15f));
+
+    auto pool = ThreadPool(4);
+    for (auto chunk_size : {size_t{1}, size_t{100}, size_t{4096}}) {
+        auto attrib = tinyobj::attrib_t{};
+        auto shapes = std::vector<tinyobj::shape_t>{};
+        parse_obj(text, attrib, shapes, &pool, chunk_size);
+        require_equal(attrib, shapes, attrib_ref, shapes_ref);
+    }
+}
+
+TEST_CASE("parse_obj matches tinyobjloader", "[obj_parser]") {
+    for (auto fname : {"cube.obj", "room.obj"}) {
+        auto fpath = std::filesystem::path(GLSB_RES_DIR) / fname;
+
+        auto attrib_ref = tinyobj::attrib_t{};
+        auto shapes_ref = std::vector<tinyobj::shape_t>{};
+        auto materials = std::vector<tinyobj::material_t>{};
+        auto err = std::string{};
+        auto ifs = std::ifstream(fpath);
+        REQUIRE(tinyobj::LoadObj(&attrib_ref, &shapes_ref, &materials, &err, &ifs));
+
+        auto attrib = tinyobj::attrib_t{};
+        auto shapes = std::vector<tinyobj::shape_t>{};
+        auto pool = ThreadPool(4);
+        auto text = load_file(fpath);
+        parse_obj(std::string_view(text.data(), text.size() - 1), attrib, shapes, &pool, 4096);
+
+        require_equal(attrib, shapes, attrib_ref, shapes_ref);
+    }
+
+    // obj indices start at 1, both reject 0
+    {
+        auto text = std::string("v 0 0 0\nv 1 0 0\nv 1 1 0\nf 1 2 3\nf 1 0 3\n");
+
+        auto attrib_ref = tinyobj::attrib_t{};
+        auto shapes_ref = std::vector<tinyobj::shape_t>{};
+        auto materials = std::vector<tinyobj::material_t>{};
+        auto err = std::string{};
+        auto iss = std::istringstream(text);
+        REQUIRE_FALSE(tinyobj::LoadObj(&attrib_ref, &shapes_ref, &materials, &err, &iss));
+
+        auto attrib = tinyobj::attrib_t{};
+        auto shapes = std::vector<tinyobj::shape_t>{};
+        auto pool = ThreadPool(4);
+        REQUIRE_THROWS_WITH(parse_obj(text, attrib, shapes), Catch::Contains("line 5"));
+        REQUIRE_THROWS_WITH(parse_obj(text, attrib, shapes, &pool, 1), Catch::Contains("line 5"));
+    }
+}
@@ -0,0 +1,36 @@
+#include <catch2/catch.hpp>
+
+#include <packed_vertex.h>
+
+TEST_CASE("octahedral normal encoding", "[packed_vertex]") {
+    auto normals = std::vector<glm::vec3>{
+        {0.f, 0.f, 1.f},
+        {0.f, 0.f, -1.f},
+        {1.f, 0.f, 0.f},
+        {0.f, -1.f, 0.f},
+        glm::normalize(glm::vec3(1.f, 2.f, -3.f)),
+        glm::normalize(glm::vec3(-.3f, .1f, .2f)),
+    };
+    for (const auto& norm : normals) {
+        auto enc = oct_encode(norm);
+        auto packed = glm::vec2(to_snorm16(enc.x), to_snorm16(enc.y)) / 32767.f;
+        auto dec = oct_decode(packed);
+        REQUIRE(glm::dot(dec, norm) > .99999f);
+    }
+}
+
+TEST_CASE("quantize_mesh", "[packed_vertex]") {
+    auto mesh = generate_quad(4.f, 2.f);
+    auto quantized = quantize_mesh(mesh);
+
+    REQUIRE(quantized.mesh.index_data == mesh.index_data);
+    REQUIRE(quantized.mesh.vertex_data.size() == mesh.vertex_data.size());
+    for (size_t i=0; i<mesh.vertex_data.size(); ++i) {
+        const auto& q = quantized.mesh.vertex_data[i];
+        auto pos = quantized.dequantization.offset +
+            glm::vec3(q.pos[0], q.pos[1], q.pos[2]) / 65535.f * quantized.dequantization.scale;
+        REQUIRE(glm::distance(pos, mesh.vertex_data[i].pos) < 1e-4f);
+        REQUIRE(from_half(q.uv[0]) == mesh.vertex_data[i].uv.x);
+        REQUIRE(from_half(q.uv[1]) == mesh.vertex_data[i].uv.y);
+    }
+}
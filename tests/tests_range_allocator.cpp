@@ -0,0 +1,87 @@
+#include <catch2/catch.hpp>
+
+#include <range_allocator.h>
+
+TEST_CASE("RangeAllocator allocates first fit", "[range_allocator]") {
+    auto alloc = RangeAllocator(100);
+    REQUIRE(alloc.allocate(30) == 0u);
+    REQUIRE(alloc.allocate(30) == 30u);
+    REQUIRE(alloc.allocate(30) == 60u);
+    REQUIRE(alloc.used() == 90);
+    REQUIRE_FALSE(alloc.allocate(20));
+    REQUIRE_FALSE(alloc.allocate(0));
+
+    // the first gap that fits is used, even if a later one fits better
+    alloc.free(0, 30);
+    REQUIRE(alloc.largest_free_range() == 30);
+    REQUIRE(alloc.allocate(10) == 0u);
+    REQUIRE(alloc.allocate(10) == 10u);
+    REQUIRE(alloc.allocate(10) == 20u);
+    REQUIRE(alloc.allocate(10) == 90u);
+    REQUIRE(alloc.used() == alloc.capacity());
+    REQUIRE(alloc.free_range_count() == 0);
+}
+
+TEST_CASE("RangeAllocator merges freed neighbors", "[range_allocator]") {
+    auto alloc = RangeAllocator(40);
+    for (size_t i=0; i<4; ++i) {
+        REQUIRE(alloc.allocate(10) == 10*i);
+    }
+    alloc.free(10, 10);
+    alloc.free(30, 10);
+    REQUIRE(alloc.free_range_count() == 2);
+    REQUIRE_FALSE(alloc.allocate(20));
+
+    // joins both gaps into one
+    alloc.free(20, 10);
+    REQUIRE(alloc.free_range_count() == 1);
+    REQUIRE(alloc.largest_free_range() == 30);
+    REQUIRE(alloc.allocate(30) == 10u);
+
+    alloc.free(0, 10);
+    alloc.free(10, 30);
+    REQUIRE(alloc.used() == 0);
+    REQUIRE(alloc.free_range_count() == 1);
+    REQUIRE(alloc.largest_free_range() == 40);
+}
+
+TEST_CASE("RangeAllocator grows and resets", "[range_allocator]") {
+    auto alloc = RangeAllocator(20);
+    REQUIRE(alloc.allocate(10) == 0u);
+    REQUIRE(alloc.allocate(10) == 10u);
+    alloc.free(0, 10);
+
+    // the new space starts a separate range unless it touches a free one
+    alloc.grow(50);
+    REQUIRE(alloc.capacity() == 50);
+    REQUIRE(alloc.free_range_count() == 2);
+    REQUIRE(alloc.allocate(30) == 20u);
+    alloc.free(10, 10);
+    REQUIRE(alloc.largest_free_range() == 20);
+
+    alloc.reset(30);
+    REQUIRE(alloc.used() == 30);
+    REQUIRE(alloc.free_range_count() == 1);
+    REQUIRE(alloc.allocate(20) == 30u);
+    REQUIRE(alloc.used() == 50);
+}
+
+TEST_CASE("RangeAllocator::capacity_for makes room in a fragmented allocator", "[range_allocator]") {
+    auto alloc = RangeAllocator(100);
+    REQUIRE(alloc.allocate(90) == 0u);
+    REQUIRE(alloc.allocate(10) == 90u);
+    alloc.free(0, 90);
+    REQUIRE(alloc.capacity_for(90) == 100);
+
+    // 90 free, but not at the end: growing by the used size isn't enough
+    auto capacity = alloc.capacity_for(150);
+    REQUIRE(capacity == 250);
+    alloc.grow(capacity);
+    REQUIRE(alloc.allocate(150) == 100u);
+
+    // a free range at the end counts
+    alloc.free(100, 150);
+    REQUIRE(alloc.capacity_for(160) == 260);
+    alloc.grow(alloc.capacity_for(160));
+    REQUIRE(alloc.allocate(160) == 100u);
+}
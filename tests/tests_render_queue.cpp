@@ -0,0 +1,42 @@
+#include <catch2/catch.hpp>
+
+#include <vector>
+
+#include <render_queue.h>
+
+TEST_CASE("make_sort_key groups opaque draws by state", "[render_queue]") {
+    // program before texture before depth
+    REQUIRE(make_sort_key(0, 5, 3, 100.f, false) < make_sort_key(1, 0, 0, 1.f, false));
+    REQUIRE(make_sort_key(1, 0, 3, 100.f, false) < make_sort_key(1, 1, 0, 1.f, false));
+    // front to back within the same state
+    REQUIRE(make_sort_key(1, 1, 7, 1.f, false) < make_sort_key(1, 1, 2, 2.f, false));
+    REQUIRE(make_sort_key(1, 1, 7, .5f, false) < make_sort_key(1, 1, 2, 1000.f, false));
+    // behind the camera counts as depth 0
+    REQUIRE(make_sort_key(1, 1, 2, -3.f, false) == make_sort_key(1, 1, 2, 0.f, false));
+}
+
+TEST_CASE("make_sort_key puts transparent draws last, back to front", "[render_queue]") {
+    REQUIRE(make_sort_key(2047, 4095, 0xffffff, 1e30f, false) < make_sort_key(0, 0, 0, 1e30f, true));
+    // depth before state
+    REQUIRE(make_sort_key(5, 5, 0, 10.f, true) < make_sort_key(0, 0, 0, 9.f, true));
+    REQUIRE(make_sort_key(0, 0, 0, 2.5f, true) < make_sort_key(0, 0, 0, 2.f, true));
+}
+
+TEST_CASE("RenderQueue sorts submitted draws", "[render_queue]") {
+    auto queue = RenderQueue{};
+    queue.submit(DrawItem{0, nullptr, nullptr, true, 1.f});
+    queue.submit(DrawItem{1, nullptr, nullptr, false, 5.f});
+    queue.submit(DrawItem{2, nullptr, nullptr, true, 3.f});
+    queue.submit(DrawItem{3, nullptr, nullptr, false, 2.f});
+    REQUIRE(queue.size() == 4);
+
+    auto order = std::vector<size_t>{};
+    for (const auto& item : queue.sorted()) {
+        order.push_back(item.mesh);
+    }
+    REQUIRE(order == std::vector<size_t>{3, 1, 2, 0});
+
+    queue.clear();
+    REQUIRE(queue.size() == 0);
+    REQUIRE(queue.sorted().empty());
+}
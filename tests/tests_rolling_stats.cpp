@@ -0,0 +1,34 @@
+#include <catch2/catch.hpp>
+
+#include <rolling_stats.h>
+
+TEST_CASE("RollingStats of a partial window", "[rolling_stats]") {
+    auto stats = RollingStats(10);
+    REQUIRE(stats.empty());
+    REQUIRE(stats.mean() == 0.f);
+    REQUIRE(stats.percentile(.5f) == 0.f);
+
+    for (auto sample : {4.f, 1.f, 3.f, 2.f}) {
+        stats.push(sample);
+    }
+    REQUIRE(stats.size() == 4);
+    REQUIRE(stats.last() == 2.f);
+    REQUIRE(stats.mean() == Approx(2.5f));
+    REQUIRE(stats.percentile(0.f) == 1.f);
+    REQUIRE(stats.percentile(.5f) == 2.f);
+    REQUIRE(stats.percentile(.75f) == 3.f);
+    REQUIRE(stats.percentile(1.f) == 4.f);
+}
+
+TEST_CASE("RollingStats keeps the last samples", "[rolling_stats]") {
+    auto stats = RollingStats(4);
+    for (int i=1; i<=10; ++i) {
+        stats.push(static_cast<float>(i));
+    }
+    // 7, 8, 9, 10 are left
+    REQUIRE(stats.size() == 4);
+    REQUIRE(stats.last() == 10.f);
+    REQUIRE(stats.mean() == Approx(8.5f));
+    REQUIRE(stats.percentile(0.f) == 7.f);
+    REQUIRE(stats.percentile(.95f) == 10.f);
+}
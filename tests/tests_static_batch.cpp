@@ -0,0 +1,55 @@
+#include <catch2/catch.hpp>
+
+#include <static_batch.h>
+
+TEST_CASE("StaticBatch packs meshes into shared buffers", "[static_batch]") {
+    auto quad = generate_quad(2.f, 2.f);
+    auto triangle = Mesh<Vertex>{
+        {
+            {{0.f, 0.f, 0.f}, {0.f, 0.f, 1.f}, {0.f, 0.f}},
+            {{1.f, 0.f, 0.f}, {0.f, 0.f, 1.f}, {1.f, 0.f}},
+            {{0.f, 1.f, 0.f}, {0.f, 0.f, 1.f}, {0.f, 1.f}},
+        },
+        {0, 1, 2}
+    };
+
+    auto batch = StaticBatch<Vertex>{};
+    auto quad_id = batch.add_mesh(quad.view());
+    auto triangle_id = batch.add_mesh(triangle.view());
+    REQUIRE(batch.vertex_data().size() == 7);
+    REQUIRE(batch.index_data().size() == 9);
+
+    auto moved = glm::translate(glm::mat4(1.f), glm::vec3(10.f, 0.f, 0.f));
+    REQUIRE(batch.add_draw(triangle_id, glm::mat4(1.f)) == 0);
+    REQUIRE(batch.add_draw(quad_id, moved) == 1);
+    REQUIRE(batch.add_draw(triangle_id, glm::scale(moved, glm::vec3(2.f))) == 2);
+
+    auto cmds = batch.commands();
+    REQUIRE(cmds.size() == 3);
+    REQUIRE(batch.draw_data().size() == 3);
+    for (uint32_t i=0; i<cmds.size(); ++i) {
+        REQUIRE(cmds[i].instance_count == 1);
+        REQUIRE(cmds[i].base_instance == i);
+    }
+    // both draws of the triangle share its data
+    REQUIRE(cmds[0].count == 3);
+    REQUIRE(cmds[0].first_index == 6);
+    REQUIRE(cmds[0].base_vertex == 4);
+    REQUIRE(cmds[2].first_index == cmds[0].first_index);
+    REQUIRE(cmds[1].count == 6);
+    REQUIRE(cmds[1].first_index == 0);
+    REQUIRE(cmds[1].base_vertex == 0);
+    // indices stay relative to the mesh, the base vertex offsets them
+    for (uint32_t i=0; i<cmds[0].count; ++i) {
+        auto idx = batch.index_data()[cmds[0].first_index + i];
+        REQUIRE(batch.vertex_data()[static_cast<size_t>(cmds[0].base_vertex) + idx].pos == triangle.vertex_data[idx].pos);
+    }
+
+    REQUIRE(batch.draw_data()[1].model == moved);
+    auto box = batch.draw_boxes()[2];
+    REQUIRE(box.lo == glm::vec3(10.f, 0.f, 0.f));
+    REQUIRE(box.hi == glm::vec3(12.f, 2.f, 0.f));
+    auto sphere = batch.draw_spheres()[1];
+    REQUIRE(sphere.center == glm::vec3(10.f, 0.f, 0.f));
+    REQUIRE(sphere.radius == Approx(std::sqrt(2.f)));
+}
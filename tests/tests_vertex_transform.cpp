@@ -0,0 +1,42 @@
+#include <catch2/catch.hpp>
+
+#include <random>
+#include <vector>
+
+#include <mesh.h>
+
+TEST_CASE("transform_vertices matches Vertex::transform", "[mesh]") {
+    auto rng = std::mt19937(42);
+    auto dist = std::uniform_real_distribution<float>(-2.f, 2.f);
+
+    // 37 vertices: exercises the SIMD loops as well as the scalar tail
+    auto vertices = std::vector<Vertex>(37);
+    for (auto& vert : vertices) {
+        vert.pos = glm::vec3(dist(rng), dist(rng), dist(rng));
+        vert.norm = glm::normalize(glm::vec3(dist(rng), dist(rng), dist(rng)));
+        vert.uv = glm::vec2(dist(rng), dist(rng));
+    }
+
+    auto tmat = glm::translate(glm::mat4(1.f), glm::vec3(1.f, -2.f, .5f));
+    tmat = glm::scale(tmat, glm::vec3(2.f, .5f, 1.5f));
+    tmat[1][0] = .3f;    // add some shear
+
+    auto reference = vertices;
+    for (auto& vert : reference) {
+        vert.transform(tmat);
+    }
+    auto scalar = vertices;
+    transform_vertices_scalar(scalar, tmat);
+    auto batched = vertices;
+    transform_vertices(batched, tmat);
+
+    for (size_t i=0; i<vertices.size(); ++i) {
+        for (int c=0; c<3; ++c) {
+            REQUIRE(scalar[i].pos[c] == Approx(reference[i].pos[c]).margin(1e-5));
+            REQUIRE(scalar[i].norm[c] == Approx(reference[i].norm[c]).margin(1e-5));
+            REQUIRE(batched[i].pos[c] == Approx(reference[i].pos[c]).margin(1e-5));
+            REQUIRE(batched[i].norm[c] == Approx(reference[i].norm[c]).margin(1e-5));
+        }
+        REQUIRE(batched[i].uv == vertices[i].uv);
+    }
+}